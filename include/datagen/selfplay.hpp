@@ -0,0 +1,46 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <random>
+#include <vector>
+
+#include "binary_position.hpp"
+#include "eval_types.hpp"
+
+class Board;
+
+// Generates training positions by letting the engine play itself.
+namespace datagen
+{
+
+using evaluation::eval_t;
+
+struct settings
+{
+	// Every move is a search of this many nodes.
+	uint64_t nodes             = 5000;
+	// Games start with this many random moves, so they don't all play the same opening.
+	uint32_t random_plies      = 8;
+	// Openings the search scores further from equal than this are thrown away.
+	eval_t   max_opening_score = 300;
+
+	// A game is adjudicated as won once the search scores it at least `win_score` for `win_plies` plies in a row.
+	eval_t   win_score  = 1500;
+	uint32_t win_plies  = 4;
+	// And as drawn once it's past `draw_start` plies and scored within `draw_score` for `draw_plies` plies in a row.
+	uint32_t draw_start = 80;
+	eval_t   draw_score = 10;
+	uint32_t draw_plies = 12;
+	// Games that go on this long are called a draw.
+	uint32_t max_plies  = 400;
+};
+
+// Plays one game on `board` and appends its quiet positions to `positions`, labelled with the game's result.
+// Returns the result, as one of `binary::BLACK_WIN`, `binary::DRAW` or `binary::WHITE_WIN`.
+uint8_t play_game(Board                         &board,
+                  std::mt19937_64               &rng,
+                  const settings                &config,
+                  std::vector<binary::position> &positions);
+
+} // namespace datagen
\ No newline at end of file
@@ -0,0 +1,42 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <iosfwd>
+#include <string>
+
+/**
+ * Analyses many positions in one process, so a batch doesn't pay the engine's startup cost once per position.
+ * Requests and results are JSON objects, one per line. Every field of a request is optional:
+ *
+ * {"id": 7, "fen": "...", "moves": ["e2e4", "e7e5"], "depth": 10, "nodes": 100000, "time": 500, "multipv": 3,
+ *  "priority": 1}
+ *
+ * The id can be any JSON value and is echoed back as it was sent. Without a FEN the start position is used,
+ * and without any limit the search goes to DEFAULT_DEPTH. Higher priorities are searched first, and requests
+ * of the same priority in the order they came in. Results are written as soon as they are done, so they can
+ * come back in a different order than the requests:
+ *
+ * {"id": 7, "bestmove": "g1f3", "depth": 10, "nodes": 123456, "time": 480, "queue_time": 12,
+ *  "lines": [{"move": "g1f3", "score": {"cp": 31}}, {"move": "d2d4", "score": {"cp": 28}}, ...]}
+ *
+ * A request that can't be analysed gets {"id": 7, "error": "..."} instead. {"command": "stats"} is answered
+ * straight away with throughput and queue latency counters. Times are in milliseconds.
+ */
+namespace analysis
+{
+
+constexpr uint32_t DEFAULT_DEPTH = 8;
+
+// One worker per hardware thread. Each worker searches with a single thread, since searching several
+// positions side by side scales much better than splitting one search up.
+size_t default_workers();
+
+// Reads requests from `input` until it ends, then waits for every result to be written to `output`.
+void run(std::istream &input, std::ostream &output, size_t workers = default_workers());
+
+// Listens on a Unix domain socket at `path`, answering each client's requests on its own connection.
+// Only returns if the socket can't be set up (or isn't supported on this platform), with false.
+bool serve(const std::string &path, size_t workers = default_workers());
+
+} // namespace analysis
\ No newline at end of file
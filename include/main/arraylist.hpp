@@ -0,0 +1,124 @@
+#pragma once
+
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+#include <cstring>
+#include <memory>
+#include <type_traits>
+
+/**
+ * @brief A contiguous, random-access list that keeps its first `N` elements inside the object itself.
+ *
+ * Pushing and popping never touches the heap while the list holds `N` elements or fewer. If the list grows past
+ * that, every element is moved into a heap buffer that doubles in size as needed, so the data stays contiguous.
+ * Elements must be trivially copyable, since copies only `memcpy` the used prefix of the buffer.
+ */
+template <typename T, size_t N>
+class arraylist
+{
+	static_assert(std::is_trivially_copyable_v<T>, "arraylist elements are copied with memcpy.");
+	static_assert(N > 0, "arraylist needs room for at least one inline element.");
+
+public:
+	typedef T        value_type;
+	typedef T       *iterator;
+	typedef const T *const_iterator;
+
+private:
+	// Left uninitialised, so constructing or copying a list only ever touches the elements it holds.
+	// Trivially copyable elements are implicit-lifetime types, so they can live in raw storage like this.
+	alignas(T) std::byte _inline[N * sizeof(T)];
+	std::unique_ptr<T[]> _heap;
+	T                   *_data     = _inline_data();
+	size_t               _size     = 0;
+	size_t               _capacity = N;
+
+	T *_inline_data() noexcept { return reinterpret_cast<T *>(_inline); }
+
+	void _grow(size_t min_capacity)
+	{
+		size_t new_capacity = std::max(_capacity * 2, min_capacity);
+		auto   new_heap     = std::make_unique_for_overwrite<T[]>(new_capacity);
+		std::memcpy(new_heap.get(), _data, _size * sizeof(T));
+		_heap     = std::move(new_heap);
+		_data     = _heap.get();
+		_capacity = new_capacity;
+	}
+
+	void _copy_from(const arraylist &other)
+	{
+		if (other._size > _capacity) _grow(other._size);
+		std::memcpy(_data, other._data, other._size * sizeof(T));
+		_size = other._size;
+	}
+
+public:
+	arraylist() {}
+	arraylist(const arraylist &other) { _copy_from(other); }
+	arraylist(arraylist &&other) noexcept { *this = std::move(other); }
+
+	arraylist &operator=(const arraylist &other)
+	{
+		if (this != &other) _copy_from(other);
+		return *this;
+	}
+
+	arraylist &operator=(arraylist &&other) noexcept
+	{
+		if (this == &other) return *this;
+		if (other._heap)
+		{
+			_heap     = std::move(other._heap);
+			_data     = _heap.get();
+			_size     = other._size;
+			_capacity = other._capacity;
+
+			other._data     = other._inline_data();
+			other._capacity = N;
+		}
+		else
+		{
+			_heap.reset();
+			_data     = _inline_data();
+			_capacity = N;
+			_copy_from(other);
+		}
+		other._size = 0;
+		return *this;
+	}
+
+	void push_back(const T &value)
+	{
+		if (_size == _capacity) [[unlikely]]
+			_grow(_size + 1);
+		_data[_size++] = value;
+	}
+
+	void pop_back()
+	{
+		assert(_size > 0 && "pop_back called on an empty arraylist");
+		_size--;
+	}
+
+	void clear() noexcept { _size = 0; }
+
+	T       &operator[](size_t i) { return assert(i < _size), _data[i]; }
+	const T &operator[](size_t i) const { return assert(i < _size), _data[i]; }
+	T       &back() { return (*this)[_size - 1]; }
+	const T &back() const { return (*this)[_size - 1]; }
+
+	size_t size() const noexcept { return _size; }
+	size_t capacity() const noexcept { return _capacity; }
+	bool   empty() const noexcept { return _size == 0; }
+
+	T       *data() noexcept { return _data; }
+	const T *data() const noexcept { return _data; }
+
+	iterator       begin() noexcept { return _data; }
+	iterator       end() noexcept { return _data + _size; }
+	const_iterator begin() const noexcept { return _data; }
+	const_iterator end() const noexcept { return _data + _size; }
+	const_iterator cbegin() const noexcept { return _data; }
+	const_iterator cend() const noexcept { return _data + _size; }
+};
\ No newline at end of file
@@ -0,0 +1,100 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <limits>
+#include <span>
+#include <string>
+#include <vector>
+
+#include "mapped_file.hpp"
+
+// A fixed-size binary encoding of a position, for datasets too big to keep as text.
+// Files are just these records back to back, so they can be read in place from a mapped file.
+namespace binary
+{
+
+constexpr uint8_t NO_SQUARE = 64;
+constexpr uint8_t NO_RESULT = 0xff;
+constexpr int16_t NO_SCORE  = std::numeric_limits<int16_t>::min();
+
+// Game results, as white's score in half points.
+constexpr uint8_t BLACK_WIN = 0;
+constexpr uint8_t DRAW      = 1;
+constexpr uint8_t WHITE_WIN = 2;
+
+// Bits of `position::flags`.
+constexpr uint8_t BLACK_TO_MOVE   = 1 << 0;
+constexpr uint8_t WHITE_KINGSIDE  = 1 << 1;
+constexpr uint8_t WHITE_QUEENSIDE = 1 << 2;
+constexpr uint8_t BLACK_KINGSIDE  = 1 << 3;
+constexpr uint8_t BLACK_QUEENSIDE = 1 << 4;
+
+/**
+ * All fields are little-endian. A board never has more than 32 pieces, so 16 bytes of piece codes always suffice.
+ * Each piece code is the piece type, plus 8 for black pieces. Two codes share a byte, the lower square
+ * in the low four bits, and the pieces are stored in the order of their squares in `occupancy`.
+ */
+struct position
+{
+	uint64_t                occupancy = 0;
+	std::array<uint8_t, 16> pieces{};
+	uint8_t                 flags            = 0;
+	uint8_t                 en_passant       = NO_SQUARE;
+	// Clocks too big for these fields are capped, which only loses information no one needs.
+	uint8_t                 fifty_move_clock = 0;
+	uint8_t                 result           = NO_RESULT;
+	uint16_t                move_number      = 1;
+	// Score from white's point of view, for example from a search when the dataset was generated.
+	int16_t                 score            = NO_SCORE;
+};
+
+static_assert(sizeof(position) == 32, "Binary positions are written to disk as they are in memory.");
+
+// Reads the positions a mapped file holds. Any partial record at the end is ignored.
+std::span<const position> positions(const mapped_file &file);
+
+// Number of positions read or written at once by the streaming reader and writer.
+constexpr size_t CHUNK_POSITIONS = 4096;
+
+// Appends positions to a file, a chunk at a time.
+class writer
+{
+	std::ofstream         stream;
+	std::vector<position> buffer;
+
+public:
+	// Check `good` afterwards, the file might not be writable.
+	explicit writer(const std::string &path, bool append = false);
+	~writer() { this->flush(); }
+
+	writer(const writer &)            = delete;
+	writer &operator=(const writer &) = delete;
+
+	void write(const position &pos);
+	void flush();
+	bool good() const { return this->stream.good(); }
+};
+
+// Reads a file of positions from start to end, a chunk at a time. For random access, map the file instead.
+class reader
+{
+	std::ifstream         stream;
+	std::vector<position> buffer;
+	size_t                next = 0;
+
+public:
+	// Check `is_open` afterwards, the file might not exist.
+	explicit reader(const std::string &path);
+
+	reader(const reader &)            = delete;
+	reader &operator=(const reader &) = delete;
+
+	bool is_open() const { return this->stream.is_open(); }
+	// Returns false once every position has been read.
+	bool read(position &pos);
+};
+
+} // namespace binary
\ No newline at end of file
@@ -3,12 +3,15 @@
 #include "move.hpp"
 #include "pieces.hpp"
 // #include <bitset>
+#include <algorithm>
+#include <array>
 #include <bit>
 #include <cassert>
 #include <cstddef>
 #include <cstdint>
 #include <functional>
 #include <numeric>
+#include <type_traits>
 #include <vector>
 
 class Board;
@@ -74,8 +77,36 @@ constexpr bitboard operator|(const bitboard &a, const bitboard &b) noexcept { re
 constexpr bitboard operator^(const bitboard &a, const bitboard &b) noexcept { return bitboard(a.bits ^ b.bits); }
 
 constexpr bitboard file_a = bitboard(0x0101010101010101);
+constexpr bitboard file_h = file_a << 7;
 constexpr bitboard rank_1 = bitboard(0xff);
 
+// Set-wise shifts. "North" is towards rank 8, "east" is towards the h-file.
+// East and west shifts drop whatever would wrap around to the other side of the board.
+constexpr bitboard north(bitboard bb) noexcept { return bb << 8; }
+constexpr bitboard south(bitboard bb) noexcept { return bb >> 8; }
+constexpr bitboard east(bitboard bb) noexcept { return (bb << 1) & ~file_a; }
+constexpr bitboard west(bitboard bb) noexcept { return (bb >> 1) & ~file_h; }
+
+// Smears every set bit over all the squares north (or south) of it, including itself.
+constexpr bitboard north_fill(bitboard bb) noexcept
+{
+	bb |= bb << 8;
+	bb |= bb << 16;
+	bb |= bb << 32;
+	return bb;
+}
+constexpr bitboard south_fill(bitboard bb) noexcept
+{
+	bb |= bb >> 8;
+	bb |= bb >> 16;
+	bb |= bb >> 32;
+	return bb;
+}
+constexpr bitboard file_fill(bitboard bb) noexcept { return north_fill(bb) | south_fill(bb); }
+
+// Mirrors the board vertically, so rank 1 becomes rank 8. Used to look at black's pieces from white's side.
+constexpr bitboard flip_vertical(bitboard bb) noexcept { return bitboard(std::byteswap(bb.bits)); }
+
 struct threat_line
 {
 	bitboard line;
@@ -114,45 +145,78 @@ struct piece_boards
 	}
 };
 
+// The king can be attacked from a total of 16 sides: 8 cardinal directions, and the 8 knight moves.
+// Knights can put the king in check, but they can't pin other pieces to the king.
+// We don't care if there's more than one piece on a line, we just care that there
+// is a piece that is on the line, which gives us a total of 8 lines that we care about.
+constexpr size_t MAX_THREAT_LINES = 16;
+
+// Fixed-capacity list of threat lines. Keeping it inline (instead of in a vector) makes the whole
+// `full_set` trivially copyable, so the board can snapshot and restore it with a plain copy.
 struct list
 {
-	std::vector<bitboard> boards{};
-	bitboard              combined;
+	std::array<bitboard, MAX_THREAT_LINES> boards{};
+	uint8_t                                count = 0;
+	bitboard                               combined;
 
-	void calculate_combined()
+	void push_back(bitboard line)
 	{
-		combined = std::reduce(boards.begin(), boards.end(), bitboard(0), std::bit_or<bitboard>());
+		assert(count < MAX_THREAT_LINES && "Too many threat lines.");
+		if (count < MAX_THREAT_LINES) boards[count++] = line;
 	}
 
-	bool operator==(const list &rhs) { return this->boards == rhs.boards && this->combined == rhs.combined; }
+	size_t          size() const { return count; }
+	const bitboard *begin() const { return boards.data(); }
+	const bitboard *end() const { return boards.data() + count; }
 
-	bool operator!=(const list &rhs) { return this->boards != rhs.boards || this->combined != rhs.combined; }
-};
+	void calculate_combined() { combined = std::reduce(begin(), end(), bitboard(0), std::bit_or<bitboard>()); }
 
-// The king can be attacked from a total of 16 sides: 8 cardinal directions, and the 8 knight moves.
-// Knights can put the king in check, but they can't pin other pieces to the king.
-// We don't care if there's more than one piece on a line, we just care that there
-// is a piece that is on the line, which gives us a total of 8 lines that we care about.
+	bool operator==(const list &rhs)
+	{
+		return this->count == rhs.count && std::equal(begin(), end(), rhs.begin()) && this->combined == rhs.combined;
+	}
+
+	bool operator!=(const list &rhs) { return !(*this == rhs); }
+};
 
 struct threat_boards
 {
 	list checks;
 	list pins;
 
-	threat_boards()
-	{
-		checks.boards.reserve(16);
-		pins.boards.reserve(8);
-	}
-
 	bool operator==(const threat_boards &rhs) { return this->checks == rhs.checks && this->pins == rhs.pins; }
 	bool operator!=(const threat_boards &rhs) { return this->checks != rhs.checks || this->pins != rhs.pins; }
 };
 
+// A side has at most 15 knights, bishops, rooks and queens (with every pawn promoted).
+constexpr size_t MAX_ATTACKING_PIECES = 16;
+
+// Attacks of this side's pieces, split up by piece type and (for everything but pawns and the king) by piece.
+// These are gathered while generating `piece_boards::visible`, so the evaluation doesn't need a second pass.
+struct attack_boards
+{
+	std::array<bitboard, (size_t) PieceType::MAX_TYPE> by_type{};
+	std::array<bitboard, MAX_ATTACKING_PIECES>         pieces{};
+	std::array<PieceType, MAX_ATTACKING_PIECES>        types{};
+	uint8_t                                            count = 0;
+
+	// Positions are validated when they're set up, so the list can't fill up. If it somehow did,
+	// the piece would still count towards `by_type`, it just wouldn't get an entry of its own.
+	void add(PieceType type, bitboard attacks)
+	{
+		assert(count < MAX_ATTACKING_PIECES && "Too many attacking pieces.");
+		by_type[(size_t) type] |= attacks;
+		if (count == MAX_ATTACKING_PIECES) return;
+		pieces[count]  = attacks;
+		types[count++] = type;
+	}
+};
+
 struct single_set
 {
 	piece_boards  pieces;
 	threat_boards threats;
+	attack_boards attacks;
 
 	bool operator==(const single_set &rhs) { return this->pieces == rhs.pieces && this->threats == rhs.threats; }
 	bool operator!=(const single_set &rhs) { return this->pieces != rhs.pieces || this->threats != rhs.threats; }
@@ -168,9 +232,20 @@ struct single_set
 // };
 
 typedef std::array<single_set, 2> full_set;
+static_assert(std::is_trivially_copyable_v<full_set>, "Board snapshots rely on full_set being trivially copyable.");
+
+// Everything needed to tell whether a move by `color` checks the enemy king without making it.
+struct check_squares
+{
+	// Squares that a piece of each type would give check from, indexed by `PieceType`.
+	std::array<bitboard, (size_t) PieceType::MAX_TYPE> squares;
+	// Our pieces that are the only blocker between one of our sliders and the enemy king.
+	bitboard                                           discovered;
+	uint8_t                                            enemy_king;
+};
 
 bitboard generate_piece_board(const piece_set_t::PieceList &list);
-piece_boards generate_piece_boards(const Board &state, color_t color);
+piece_boards generate_piece_boards(const Board &state, color_t color, attack_boards &attacks);
 
 // bitboard generate_pawn_visibility(const Board &state, const Piece &pawn);
 // bitboard generate_knight_visibility(const Piece &knight);
@@ -179,7 +254,13 @@ piece_boards generate_piece_boards(const Board &state, color_t color);
 // bitboard generate_queen_visibility(const Board &state, const Piece &queen);
 // bitboard generate_king_visibility(const Board &state, const Piece &king);
 
-bitboard generate_piece_visibility(const piece_set_t &piece_set, color_t color, const full_set &old_boards);
+bitboard generate_bishop_visibility(const Piece &bishop, bitboard break_board);
+bitboard generate_rook_visibility(const Piece &rook, bitboard break_board);
+
+bitboard generate_piece_visibility(const piece_set_t &piece_set,
+                                   color_t            color,
+                                   const full_set    &old_boards,
+                                   attack_boards     &attacks);
 
 threat_line generate_threat_line(const Piece    &piece,
                                  bitboard        all_pieces,
@@ -190,6 +271,8 @@ threat_line generate_threat_line(const Piece    &piece,
 
 threat_boards generate_threat_lines(const Board &state, color_t color, const full_set &old_boards);
 
+check_squares generate_check_squares(const full_set &boards, color_t color);
+
 single_set generate_single_set(const Board &state, color_t color);
 full_set   generate_full_set(const Board &state);
 
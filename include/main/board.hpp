@@ -2,15 +2,30 @@
 #include <array>
 #include <cstddef>
 #include <cstdint>
-#include <list>
 #include <optional>
-#include <stack>
 #include <string>
+#include <string_view>
+#include <vector>
 
-// #include "arraylist.hpp"
+#include "arraylist.hpp"
 #include "bitboard.hpp"
+#include "hc_evaluation.hpp"
 #include "move.hpp"
+#include "nnue.hpp"
 #include "pieces.hpp"
+#include "zobrist.hpp"
+
+namespace binary
+{
+struct position;
+}
+
+// Longest game (in halfmoves) that fits in the board's inline history buffers.
+// Longer games still work, they just spill the history over to the heap.
+constexpr size_t MAX_GAME_LENGTH = 1024;
+// Plies of derived-state and accumulator snapshots kept inline. They're much larger than the rest of the history,
+// so this covers a long game plus a search below it rather than MAX_GAME_LENGTH. Deeper stacks spill to the heap.
+constexpr size_t MAX_INLINE_SNAPSHOTS = 256;
 
 class Board
 {
@@ -26,15 +41,32 @@ public:
 		// Board::CastlingRights black_castling_rights;
 		std::array<Board::CastlingRights, 2> rights;
 		uint16_t                             fifty_move_clock  = 0;
+		uint16_t                             plies_from_null   = 0;
 		int16_t                              en_passant_target = -1;
 		Piece                                captured_piece;
 	};
+	// Everything make_move derives from the piece placement. It is saved before every move,
+	// so unmake_move can copy it back instead of recomputing visibility and threats.
+	struct DerivedState
+	{
+		bitboard::full_set        bitboards;
+		bitboard::check_squares   check_info;
+		evaluation::packed_eval_t packed_material;
+		zobrist::hash_t           pawn_hash;
+		bool                      in_check;
+	};
 
 	std::array<piece_set_t::iterator, 64> piece_board{};
-	std::list<Move>                       moves;
+	arraylist<Move, MAX_GAME_LENGTH>      moves;
 
 private:
-	std::stack<IrreversableState> history;
+	arraylist<IrreversableState, MAX_GAME_LENGTH>                  history;
+	// Hash of the position before each move in `moves`, indexed by ply.
+	arraylist<zobrist::hash_t, MAX_GAME_LENGTH>                    hash_history;
+	// Like the stacks above, copying a board only copies the snapshots in use, without allocating.
+	arraylist<DerivedState, MAX_INLINE_SNAPSHOTS>                  derived_history;
+	// Accumulators from before each move. Only used while a network is loaded.
+	arraylist<evaluation::nnue::accumulator, MAX_INLINE_SNAPSHOTS> accumulator_history;
 
 public:
 	bitboard::full_set         bitboards;
@@ -44,23 +76,48 @@ public:
 private:
 	uint32_t halfmove          = 0;
 	uint16_t fifty_move_clock  = 0;
+	uint16_t plies_from_null   = 0;
 	int16_t  en_passant_target = -1;
 
 	// CastlingRights white_castling_rights;
 	// CastlingRights black_castling_rights;
 	std::array<CastlingRights, 2> rights;
 
-	bool _in_check = false;
+	bool                    _in_check = false;
+	bitboard::check_squares check_info{};
+
+	zobrist::hash_t hash = 0;
+	// Hash of the pawns alone, used to look up cached pawn structure evaluations.
+	zobrist::hash_t pawn_hash = 0;
+	// Running sum of `evaluation::hce::piece_tables::packed_value` over every piece on the board.
+	evaluation::packed_eval_t packed_material = 0;
+	// First layer of the network, kept up to date as moves are made while a network is loaded.
+	evaluation::nnue::accumulator accumulator{};
+	// Nodes of pieces from a previous position, reused by `add_piece` instead of allocating new ones.
+	piece_set_t::PieceList        spare_pieces;
 
 public:
 	Board() {}
 	Board(const Board &b);
-	Board(const Board &&b);
-
-	static std::optional<Board> from_fen(const std::string &fen_string);
+	Board(Board &&b);
+
+	static std::optional<Board> from_fen(std::string_view fen_string);
+	// Sets the board up from a FEN in place. The move counters may be left out, and EPD operations after the
+	// position (like `bm Nf3;`) are ignored.
+	// Doesn't allocate once the board has held as many pieces before, so one board can be reused for many FENs.
+	// Returns false if the FEN is invalid, which leaves the board in an unspecified (but destructible) state.
+	// Like `from_fen`, `update_bitboards` still has to be called afterwards.
+	bool set_fen(std::string_view fen_string);
+	// Writes the position as a FEN (without a null terminator) and returns its length,
+	// or returns 0 and writes nothing if it doesn't fit in `size` characters. MAX_FEN_LENGTH always fits.
+	size_t to_fen(char *buffer, size_t size) const;
+	// Sets the board up from a binary position, just like `set_fen`. Returns false if the position isn't valid.
+	bool set_packed(const binary::position &packed);
+	// The position in binary form, without a result or score.
+	binary::position to_packed() const;
 
 	Board &operator=(const Board &b);
-	Board &operator=(const Board &&b);
+	Board &operator=(Board &&b);
 
 	std::string  to_string() const;
 	inline color_t turn_to_move() const { return halfmove % 2 == 0 ? WHITE : BLACK; }
@@ -74,20 +131,48 @@ public:
 	inline CastlingRights            get_black_castling_rights() const { return rights[BLACK]; }
 	inline CastlingRights            get_castling_rights(color_t c) const { return rights[c]; }
 	inline const bitboard::full_set &get_bitboards() const { return bitboards; };
+	inline zobrist::hash_t           get_hash() const { return hash; }
+	inline zobrist::hash_t           get_pawn_hash() const { return pawn_hash; }
+	inline evaluation::packed_eval_t get_packed_material() const { return packed_material; }
 	// inline const std::array<bitboard::single_set, 2> &get_bitboards() const { return bitboards; }
 
+	inline const evaluation::nnue::accumulator &get_accumulator() const { return accumulator; }
+
 	std::array<piece_set_t::iterator, 64>             &get_pieces();
 	const std::array<piece_set_t::const_iterator, 64> &get_pieces() const;
 
 	void add_piece(Piece piece);
 	void make_move(Move m);
 	void unmake_move();
-	void update_bitboards() { this->bitboards = bitboard::generate_full_set(*this); };
+	// Passes the turn to the other side. Must not be used while in check.
+	void make_null_move();
+	void unmake_null_move();
+	void update_bitboards();
+
+	// Returns true if the (legal) move would put the enemy king in check, without making it.
+	bool gives_check(Move m) const;
+
+	// Computes the hash of the current position from scratch.
+	zobrist::hash_t generate_hash() const;
+	// Computes the pawn-only hash of the current position from scratch.
+	zobrist::hash_t generate_pawn_hash() const;
+	// Computes the packed material and piece-square score from scratch.
+	evaluation::packed_eval_t generate_packed_material() const;
+
+	// Returns true if the current position already occurred since the last capture, pawn move or null move.
+	// Only positions with the same side to move are compared, so the scan steps back two plies at a time.
+	bool is_repetition() const;
+	bool is_fifty_move_draw() const { return fifty_move_clock >= 100; }
 
 	Board simulate_move(Move m) const;
 
 private:
 	void _setup_piece_iterators();
+	// Takes every piece off the board and resets the state to that of an empty board with white to move.
+	void _clear();
+	// Returns true if each side has one king, at most 16 pieces and 8 pawns, and no pawn is on the first or last rank.
+	// The fixed-size buffers in move generation and evaluation rely on this.
+	bool _has_valid_pieces() const;
 
 	void _move_piece(uint16_t from, uint16_t to, piece_set_t::iterator &moved_piece, bitboard::single_set &bb_set);
 	void _delete_captured_piece(piece_set_t::iterator &piece);
@@ -0,0 +1,79 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+
+#include "hc_evaluation.hpp"
+#include "pieces.hpp"
+
+class Board;
+
+// Specialised knowledge for endings with very little material, looked up by which pieces are left.
+// https://www.chessprogramming.org/Material_Hash_Table
+namespace evaluation::endgame
+{
+
+// Number of pawns, knights, bishops, rooks and queens of each side, four bits per count. Kings are left out.
+typedef uint64_t material_key_t;
+
+constexpr size_t material_shift(PieceType type, color_t color)
+{
+	return 4 * ((size_t) color * 5 + (size_t) type - (size_t) PieceType::PAWN);
+}
+
+// Builds a key from a signature like "KRKP". The side listed first gets `strong`, the other side the other color.
+constexpr material_key_t make_key(std::string_view signature, color_t strong = WHITE)
+{
+	material_key_t key   = 0;
+	color_t        color = invert_color(strong);
+	for (char piece : signature)
+	{
+		PieceType type = PieceType::NONE;
+		switch (piece)
+		{
+		case 'K': color = invert_color(color); continue;
+		case 'P': type = PieceType::PAWN; break;
+		case 'N': type = PieceType::KNIGHT; break;
+		case 'B': type = PieceType::BISHOP; break;
+		case 'R': type = PieceType::ROOK; break;
+		case 'Q': type = PieceType::QUEEN; break;
+		}
+		key += (material_key_t) 1 << material_shift(type, color);
+	}
+	return key;
+}
+
+material_key_t material_key(const Board &state);
+
+// Scores in won endings are offset by this much, so they always beat a normal evaluation.
+constexpr eval_t KNOWN_WIN = 5000;
+
+// Scale factors are applied as `score * scale / SCALE_NORMAL`.
+constexpr eval_t SCALE_NORMAL = 64;
+constexpr eval_t SCALE_DRAW   = 0;
+
+// Returns the score from the strong side's point of view.
+typedef eval_t (*evaluator_t)(const Board &state, color_t strong);
+// Returns a scale factor between SCALE_DRAW and SCALE_NORMAL for the regular evaluation.
+typedef eval_t (*scale_t)(const Board &state, color_t strong);
+
+struct entry
+{
+	material_key_t key;
+	color_t        strong;
+	// Exactly one of these is set.
+	evaluator_t    evaluate;
+	scale_t        scale;
+	// The evaluator's score is the true result (so far only known draws), and searching any deeper is pointless.
+	bool           exact;
+};
+
+// Returns the entry for the board's material, or nullptr if the ending isn't a known one.
+const entry *probe(const Board &state);
+
+// Runs an entry's evaluator, returning the score from the side to move's point of view.
+eval_t evaluate(const entry &ending, const Board &state);
+
+} // namespace evaluation::endgame
\ No newline at end of file
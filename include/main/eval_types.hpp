@@ -0,0 +1,19 @@
+#pragma once
+
+#include <cstdint>
+
+namespace evaluation
+{
+
+typedef int32_t eval_t;
+
+// A midgame and an endgame score packed into a single integer, so both can be updated with one addition.
+// The endgame score lives in the upper 16 bits and the midgame score in the lower 16 bits.
+typedef int32_t packed_eval_t;
+
+constexpr packed_eval_t make_packed(eval_t mg, eval_t eg) { return (packed_eval_t) ((uint32_t) eg << 16) + mg; }
+constexpr eval_t        mg_value(packed_eval_t score) { return (int16_t) (uint16_t) (uint32_t) score; }
+// Adding 0x8000 undoes the borrow a negative midgame score takes from the endgame half.
+constexpr eval_t eg_value(packed_eval_t score) { return (int16_t) (uint16_t) ((uint32_t) (score + 0x8000) >> 16); }
+
+} // namespace evaluation
\ No newline at end of file
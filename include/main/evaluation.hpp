@@ -0,0 +1,68 @@
+#pragma once
+
+#include "hc_evaluation.hpp"
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+
+class Board;
+
+namespace evaluation
+{
+
+// Evaluates the board from the side to move's point of view. Uses the network when one is loaded,
+// and the hand-crafted evaluation otherwise. Results are cached by position hash.
+eval_t evaluate(const Board &state);
+// Like `evaluate`, but the hand-crafted evaluation may stop early and return a rough estimate
+// if the position is clearly outside the (alpha, beta) window. Such estimates are never cached.
+eval_t evaluate(const Board &state, eval_t alpha, eval_t beta);
+
+// Lazy evaluation is on by default. Turning it off makes the windowed `evaluate` always evaluate fully.
+void set_lazy_eval(bool enabled);
+
+constexpr size_t DEFAULT_CACHE_MB = 8;
+
+// Resizes (and clears) the evaluation cache. The cache is shared by all threads,
+// so this must not be called while anything is being evaluated.
+void set_cache_size(size_t megabytes);
+void clear_cache();
+
+// Evaluation cache counters for the current thread, since the last call to `reset_cache_stats`.
+// A search adds up what each of its threads counted while it ran.
+struct cache_stats
+{
+	uint64_t probes      = 0;
+	uint64_t hits        = 0;
+	// Total time spent in a sample of the lookups, and how many were sampled.
+	// Timing every lookup would cost more than the lookups themselves.
+	std::chrono::nanoseconds timed_lookup_time{ 0 };
+	uint64_t                 timed_lookups = 0;
+
+	cache_stats &operator+=(const cache_stats &other)
+	{
+		probes            += other.probes;
+		hits              += other.hits;
+		timed_lookup_time += other.timed_lookup_time;
+		timed_lookups     += other.timed_lookups;
+		return *this;
+	}
+	cache_stats operator-(const cache_stats &other) const
+	{
+		return { probes - other.probes,
+			     hits - other.hits,
+			     timed_lookup_time - other.timed_lookup_time,
+			     timed_lookups - other.timed_lookups };
+	}
+
+	double hit_rate() const { return probes == 0 ? 0.0 : (double) hits / probes; }
+	double average_lookup_ns() const
+	{
+		return timed_lookups == 0 ? 0.0 : (double) timed_lookup_time.count() / timed_lookups;
+	}
+};
+
+const cache_stats &get_cache_stats();
+void               reset_cache_stats();
+
+}
\ No newline at end of file
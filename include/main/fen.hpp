@@ -1,6 +1,7 @@
 #pragma once
 
 #include <array>
+#include <cstddef>
 #include <string>
 
 /*
@@ -23,6 +24,10 @@
  *
  * The FEN string here shows the starting configuration of a standard chessboard.
  */
+// Eight full ranks with slashes, the side to move, all four castling rights, an en passant square,
+// the largest possible halfmove clock and move number, and the five spaces between the fields.
+constexpr size_t MAX_FEN_LENGTH = 71 + 1 + 4 + 2 + 5 + 10 + 5;
+
 const std::string START_FEN = "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1";
 
 const std::string test_position_2 = "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1";
@@ -40,4 +45,9 @@ const std::array<const std::array<const size_t, 5>, test_positions.size()> num_p
       { { 14, 191, 2812, 43'238, 674'624 } },
       { { 6, 264, 9467, 422'333, 15'833'292 } },
       { { 44, 1486, 62'379, 2'103'487, 89'941'194 } },
-      { { 46, 2079, 89'890, 3'894'594, 164'075'551 } } });
\ No newline at end of file
+      { { 46, 2079, 89'890, 3'894'594, 164'075'551 } } });
+
+class Board;
+
+// Same as `Board::to_fen`, for when an allocation doesn't matter.
+std::string generate_fen_string(const Board &board);
\ No newline at end of file
@@ -1,166 +1,238 @@
 #pragma once
 
 #include <array>
+#include <cstddef>
 #include <cstdint>
+#include <string>
+
+#include "eval_types.hpp"
+#include "hc_parameters.hpp"
+#include "pieces.hpp"
 
 class Board;
 
 namespace evaluation
 {
 
-	typedef int32_t eval_t;
-
 namespace hce
 {
 
+#pragma region Piece_Tables
 
-#pragma region Piece_Values
-
-/**
- * Using a Modified Larry Kaufman's Scoring to make bishops score better than knights
- * Source: https://www.chessprogramming.org/Point_Value#Basic_values
- * Rules:
- * B > N > 3P
- * B + N > R + P
- * B + N = R + 1.5P
- */
-namespace piece_values
+namespace piece_tables
 {
 
-constexpr eval_t KING_MID   = 10'000;
-constexpr eval_t QUEEN_MID  = 1000;
-constexpr eval_t ROOK_MID   = 525;
-constexpr eval_t BISHOP_MID = 360;
-constexpr eval_t KNIGHT_MID = 325;
-constexpr eval_t PAWN_MID   = 100;
+typedef std::array<std::array<std::array<packed_eval_t, 64>, (size_t) PieceType::MAX_TYPE>, 2> packed_table_t;
 
-constexpr eval_t KING_END   = 10'000;
-constexpr eval_t QUEEN_END  = QUEEN_MID * 1.07;
-constexpr eval_t ROOK_END   = ROOK_MID * 1.06;
-constexpr eval_t BISHOP_END = BISHOP_MID * 1.05;
-constexpr eval_t KNIGHT_END = KNIGHT_MID * 1.03;
-constexpr eval_t PAWN_END   = PAWN_MID * 1.08;
+// Material plus piece-square value of every piece on every square, from white's point of view.
+// Black's entries are mirrored vertically and negated, so a board can keep one running sum for both sides.
+// Kings get no material value: both sides always have exactly one, so it would cancel out anyway.
+static consteval packed_table_t _precompute_packed_tables()
+{
+	packed_table_t tables{};
+
+	const std::array<eval_t, (size_t) PieceType::MAX_TYPE> mid_values = {
+		0, piece_values::PAWN_MID, piece_values::KNIGHT_MID, piece_values::BISHOP_MID,
+		piece_values::ROOK_MID, piece_values::QUEEN_MID, 0
+	};
+	const std::array<eval_t, (size_t) PieceType::MAX_TYPE> end_values = {
+		0, piece_values::PAWN_END, piece_values::KNIGHT_END, piece_values::BISHOP_END,
+		piece_values::ROOK_END, piece_values::QUEEN_END, 0
+	};
+	const std::array<const std::array<eval_t, 64> *, (size_t) PieceType::MAX_TYPE> mid_tables = {
+		nullptr, &PAWNS_MID, &KNIGHTS_MID, &BISHOPS_MID, &ROOKS_MID, &QUEENS_MID, &KING_MID
+	};
+	const std::array<const std::array<eval_t, 64> *, (size_t) PieceType::MAX_TYPE> end_tables = {
+		nullptr, &PAWNS_END, &KNIGHTS_END, &BISHOPS_END, &ROOKS_END, &QUEENS_END, &KING_END
+	};
+
+	for (size_t type = (size_t) PieceType::PAWN; type < (size_t) PieceType::MAX_TYPE; type++)
+	{
+		for (size_t square = 0; square < 64; square++)
+		{
+			eval_t mg = mid_values[type] + (*mid_tables[type])[square];
+			eval_t eg = end_values[type] + (*end_tables[type])[square];
+
+			tables[WHITE][type][square]      = make_packed(mg, eg);
+			tables[BLACK][type][square ^ 56] = make_packed(-mg, -eg);
+		}
+	}
+
+	return tables;
+}
 
-} // namespace values
+constexpr packed_table_t PACKED_TABLES = _precompute_packed_tables();
 
-namespace modifier_values
+constexpr packed_eval_t packed_value(PieceType type, color_t color, uint8_t square)
+{
+	return PACKED_TABLES[color][(size_t) type][square];
+}
+constexpr packed_eval_t packed_value(const Piece &piece)
 {
+	return packed_value(piece.get_type(), piece.get_color(), piece.position());
+}
 
-constexpr eval_t ROOK_PAIR       = 0;
-constexpr eval_t BISHOP_PAIR     = 0;
-constexpr eval_t KNIGHT_PAIR     = 0;
-constexpr eval_t NO_PAWN_PENALTY = 0;
+} // namespace piece_tables
 
+#pragma endregion Piece_Tables
+
+#pragma region Mobility
+
+namespace mobility_values
+{
+
+// Builds a table that rises quickly for the first few squares and flattens out towards `max`,
+// since the difference between a trapped and a free piece matters far more than a few extra squares.
+template <size_t N>
+consteval std::array<packed_eval_t, N> _mobility_table(eval_t mg_min, eval_t mg_max, eval_t eg_min, eval_t eg_max)
+{
+	std::array<packed_eval_t, N> table{};
+	for (size_t count = 0; count < N; count++)
+	{
+		const eval_t progress = (eval_t) (count * 1024 / (N - 1));
+		const eval_t curve    = 1024 - (1024 - progress) * (1024 - progress) / 1024;
+		table[count]          = make_packed(mg_min + (mg_max - mg_min) * curve / 1024,
+		                                    eg_min + (eg_max - eg_min) * curve / 1024);
+	}
+	return table;
 }
 
-#pragma endregion Piece_Values
+// Indexed by the number of safe squares the piece attacks.
+constexpr auto KNIGHT = _mobility_table<9>(-30, 20, -40, 15);
+constexpr auto BISHOP = _mobility_table<14>(-25, 45, -30, 50);
+constexpr auto ROOK   = _mobility_table<15>(-30, 30, -40, 80);
+constexpr auto QUEEN  = _mobility_table<28>(-15, 55, -25, 95);
 
-#pragma region Piece_Tables
+} // namespace mobility_values
 
-// Due to the layout of the board indices, the tables will be upside-down
-// The boards are just ripped straight from the chess programming wiki with some exceptions.
-// Might have to mess with these values later...
-namespace piece_tables
+// https://www.chessprogramming.org/King_Safety#Attacking_King_Zone
+namespace king_safety_values
 {
-// clang-format off
-
-constexpr std::array<eval_t, 64> PAWNS_MID = {
-	 0,  0,  0,  0,  0,  0,  0,  0,
-	 5, 10, 10,-20,-20, 10, 10,  5,
-	 5, -5,-10,  0,  0,-10, -5,  5,
-	 0,  0,  0, 20, 20,  0,  0,  0,
-	 5,  5, 10, 25, 25, 10,  5,  5,
-	10, 10, 20, 30, 30, 20, 10, 10,
-	50, 50, 50, 50, 50, 50, 50, 50,
-	 0,  0,  0,  0,  0,  0,  0,  0
-};
 
-constexpr std::array<eval_t, 64> PAWNS_END = {
-	 0,  0,  0,  0,  0,  0,  0,  0,
-	 0,  0,  0,  0,  0,  0,  0,  0,
-	10, 10, 10, 10, 10, 10, 10, 10,
-	10, 10, 10, 10, 10, 10, 10, 10,
-	20, 20, 20, 20, 20, 20, 20, 20,
-	30, 30, 30, 30, 30, 30, 30, 30,
-	50, 50, 50, 50, 50, 50, 50, 50,
-	 0,  0,  0,  0,  0,  0,  0,  0
-};
+// Attack units per attacked square in the king zone, indexed by `PieceType`.
+constexpr std::array<eval_t, (size_t) PieceType::MAX_TYPE> ATTACK_WEIGHTS = { 0, 0, 2, 2, 3, 5, 0 };
 
-constexpr std::array<eval_t, 64> KNIGHTS = {
-	-50,-40,-30,-30,-30,-30,-40,-50,
-	-40,-20,  0,  0,  0,  0,-20,-40,
-	-30,  5, 10, 15, 15, 10,  5,-30,
-	-30,  0, 15, 20, 20, 15,  0,-30,
-	-30,  5, 15, 20, 20, 15,  5,-30,
-	-30,  0, 10, 15, 15, 10,  0,-30,
-	-40,-20,  0,  5,  5,  0,-20,-40,
-	-50,-40,-30,-30,-30,-30,-40,-50
-};
+// A single attacker can't do much on its own, so the penalty only starts at this many.
+constexpr size_t MIN_ATTACKERS = 2;
+constexpr eval_t MAX_PENALTY   = 500;
 
-constexpr std::array<eval_t, 64> BISHOPS = {
-	-20,-10,-10,-10,-10,-10,-10,-20,
-	-10,  5,  0,  0,  0,  0,  5,-10,
-	-10, 10, 10, 10, 10, 10, 10,-10,
-	-10,  0, 10, 10, 10, 10,  0,-10,
-	-10,  5,  5, 10, 10,  5,  5,-10,
-	-10,  0,  5, 10, 10,  5,  0,-10,
-	-10,  0,  0,  0,  0,  0,  0,-10,
-	-20,-10,-10,-10,-10,-10,-10,-20
-};
+// Per square around the king that enemy pawns attack or could attack after advancing.
+constexpr packed_eval_t PAWN_STORM       = make_packed(-3, 0);
+// Per square the enemy king is further than ours from the square in front of one of our passed pawns.
+constexpr packed_eval_t PASSED_PAWN_KING = make_packed(0, 5);
 
-constexpr std::array<eval_t, 64> ROOKS = {
-	 0,  0,  0,  5,  5,  0,  0,  0,
-	-5,  0,  0,  0,  0,  0,  0, -5,
-	-5,  0,  0,  0,  0,  0,  0, -5,
-	-5,  0,  0,  0,  0,  0,  0, -5,
-	 0,  0,  0,  0,  0,  0,  0,  0,
-	-5,  0,  0,  0,  0,  0,  0, -5,
-	 5, 10, 10, 10, 10, 10, 10,  5,
-	-5,  0,  0,  0,  0,  0,  0, -5
+} // namespace king_safety_values
+
+#pragma endregion Mobility
+
+#pragma region Lazy_Evaluation
+
+// https://www.chessprogramming.org/Lazy_Evaluation
+namespace lazy_values
+{
+
+// How far the pawn structure, mobility and king safety terms can plausibly move the score away from the
+// material balance. The closer this is to their real range, the more often the lazy exit can be taken,
+// but the more likely it is to cut off a position those terms would have brought back inside the window.
+constexpr eval_t MARGIN = 350;
+
+} // namespace lazy_values
+
+#pragma endregion Lazy_Evaluation
+
+// Counters for the evaluations done on the current thread, since the last call to `reset_stats`.
+// Like the cache counters, a search adds these up over its threads.
+struct eval_stats
+{
+	uint64_t evaluations = 0;
+	uint64_t pawn_probes = 0;
+	uint64_t pawn_hits   = 0;
+	// Evaluations that returned early, because the material alone was too far outside the window.
+	uint64_t lazy_exits  = 0;
+
+	eval_stats &operator+=(const eval_stats &other)
+	{
+		evaluations += other.evaluations;
+		pawn_probes += other.pawn_probes;
+		pawn_hits   += other.pawn_hits;
+		lazy_exits  += other.lazy_exits;
+		return *this;
+	}
+	eval_stats operator-(const eval_stats &other) const
+	{
+		return { evaluations - other.evaluations,
+			     pawn_probes - other.pawn_probes,
+			     pawn_hits - other.pawn_hits,
+			     lazy_exits - other.lazy_exits };
+	}
+
+	double pawn_hit_rate() const { return pawn_probes == 0 ? 0.0 : (double) pawn_hits / pawn_probes; }
+	double lazy_exit_rate() const { return evaluations == 0 ? 0.0 : (double) lazy_exits / evaluations; }
 };
 
-constexpr std::array<eval_t, 64> QUEENS = {
-	-20,-10,-10, -5, -5,-10,-10,-20,
-	-10,  0,  5,  0,  0,  0,  0,-10,
-	-10,  5,  5,  5,  5,  5,  0,-10,
-	  0,  0,  5,  5,  5,  5,  0, -5,
-	 -5,  0,  5,  5,  5,  5,  0, -5,
-	-10,  0,  5,  5,  5,  5,  0,-10,
-	-10,  0,  0,  0,  0,  0,  0,-10,
-	-20,-10,-10, -5, -5,-10,-10,-20
+const eval_stats &get_stats();
+void              reset_stats();
+
+// Interpolates between a midgame and an endgame score, based on the non-pawn material left on the board.
+eval_t two_phase_lerp(const Board &state, eval_t p1, eval_t p2);
+eval_t four_phase_lerp(const Board &state, eval_t p1, eval_t p2, eval_t p3, eval_t p4);
+
+#pragma region Trace
+
+// The separate terms of the evaluation, as recorded by `trace`.
+enum class term : uint8_t
+{
+	MATERIAL, // Including the piece-square values.
+	MODIFIERS,
+	PAWN_STRUCTURE,
+	KING_SHELTER,
+	MOBILITY,
+	KING_SAFETY,
+	COUNT
 };
 
-constexpr std::array<eval_t, 64> KING_MIDDLE = {
-	 20, 30, 10,  0,  0, 10, 30, 20,
-	 20, 20,  0,  0,  0,  0, 20, 20,
-	-10,-20,-20,-20,-20,-20,-20,-10,
-	-20,-30,-30,-40,-40,-30,-30,-20,
-	-30,-40,-40,-50,-50,-40,-40,-30,
-	-30,-40,-40,-50,-50,-40,-40,-30,
-	-30,-40,-40,-50,-50,-40,-40,-30,
-	-30,-40,-40,-50,-50,-40,-40,-30
+constexpr size_t TERM_COUNT = (size_t) term::COUNT;
+
+constexpr std::array<const char *, TERM_COUNT> TERM_NAMES = {
+	"Material", "Modifiers", "Pawn structure", "King shelter", "Mobility", "King safety"
 };
 
-constexpr std::array<eval_t, 64> KING_END = {
-	-50,-30,-30,-30,-30,-30,-30,-50,
-	-30,-30,  0,  0,  0,  0,-30,-30,
-	-30,-10, 20, 30, 30, 20,-10,-30,
-	-30,-10, 30, 40, 40, 30,-10,-30,
-	-30,-10, 30, 40, 40, 30,-10,-30,
-	-30,-10, 20, 30, 30, 20,-10,-30,
-	-30,-20,-10,  0,  0,-10,-20,-30,
-	-50,-40,-30,-20,-20,-30,-40,-50
+// Midgame and endgame value of every term for both sides, followed by the piece phase and the pawn phase.
+constexpr size_t TRACE_VECTOR_SIZE = TERM_COUNT * 2 * 2 + 2;
+
+// A breakdown of one hand-crafted evaluation.
+struct eval_trace
+{
+	// Each term's score for each side, from that side's point of view.
+	std::array<std::array<packed_eval_t, 2>, TERM_COUNT> terms{};
+	// The phases used by `two_phase_lerp` and `four_phase_lerp`, from 0 with all pieces (or pawns)
+	// on the board to 256 once they are all gone.
+	eval_t piece_phase = 0;
+	eval_t pawn_phase  = 0;
+	// The final score, from white's point of view.
+	eval_t score       = 0;
+
+	// The sum of all terms, white's minus black's.
+	packed_eval_t total() const;
+	// Flattens the trace, so the terms the tuner doesn't fit can be stored alongside each position.
+	// Ordered as [term][side][midgame, endgame], then the two phases.
+	std::array<eval_t, TRACE_VECTOR_SIZE> to_vector() const;
 };
 
-// clang-format on
-} // namespace piece_tables
+// Evaluates the board like `evaluate`, but records every term on the way. This is a separate instantiation
+// of the same code, so the regular evaluation pays nothing for it. Never takes the lazy exit.
+eval_trace trace(const Board &state);
 
-#pragma endregion Piece_Tables
+// Formats a trace as a table with a row per term.
+std::string format_trace(const eval_trace &trace);
 
-eval_t two_phase_lerp(const Board &state, eval_t p1, eval_t p2);
-eval_t four_phase_lerp(const Board &state, eval_t p1, eval_t p2, eval_t p3, eval_t p4);
+#pragma endregion Trace
 
 eval_t evaluate(const Board &state);
+// Skips the expensive terms when the material and piece-square score is more than `lazy_values::MARGIN`
+// outside the (alpha, beta) window. `lazy_exit` is set when that happens, in which case the returned
+// score is only an estimate, good enough to tell that the position fails low or high.
+eval_t evaluate(const Board &state, eval_t alpha, eval_t beta, bool &lazy_exit);
 
 } // namespace hce
 
@@ -0,0 +1,28 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#include "pieces.hpp"
+
+// Perfect knowledge of king and pawn against king: one bit per position, set if the pawn's side wins.
+// https://www.chessprogramming.org/KPK
+namespace evaluation::endgame::kpk
+{
+
+// The pawn only needs to be on files a-d (the rest are mirrored) and ranks 2-7.
+constexpr size_t PAWN_SQUARES   = 4 * 6;
+constexpr size_t POSITION_COUNT = 64 * 64 * 2 * PAWN_SQUARES;
+// 24 KB.
+constexpr size_t BITBASE_BYTES  = POSITION_COUNT / 8;
+
+// Builds the bitbase by retrograde analysis. Probing does this on first use anyway,
+// but calling it up front keeps the first probe from stalling a search.
+void init();
+
+// Whether the side with the pawn wins, with perfect play from both sides.
+// Squares and `to_move` are given as if the side with the pawn were white, so a black pawn's position
+// has to be mirrored vertically first (and `to_move` inverted).
+bool probe(uint8_t strong_king, uint8_t pawn, uint8_t weak_king, color_t to_move);
+
+} // namespace evaluation::endgame::kpk
\ No newline at end of file
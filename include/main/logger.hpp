@@ -2,11 +2,13 @@
 #ifndef _CPP_RCON_LOGGER_
 #define _CPP_RCON_LOGGER_
 
+#include <chrono>
 #include <cstdint>
 #include <ctime>
 #include <iomanip>
 #include <iostream>
 #include <string>
+#include <string_view>
 #include <type_traits>
 
 enum class LOG_LEVEL
@@ -19,6 +21,23 @@ enum class LOG_LEVEL
 	FATAL
 };
 
+// Messages below this level are always dropped. Set with -DLOG_MIN_LEVEL=<n>, from 0 for DEBUG up to 5 for FATAL.
+#ifndef LOG_MIN_LEVEL
+#define LOG_MIN_LEVEL 0
+#endif
+constexpr LOG_LEVEL COMPILED_LOG_LEVEL = static_cast<LOG_LEVEL>(LOG_MIN_LEVEL);
+
+// Same as `logger.print(level, ...)` and `logger.println(level, ...)`, but compiled out entirely (arguments included)
+// when `level` is below COMPILED_LOG_LEVEL. `level` has to be a constant.
+#define LOG_PRINT(logger, level, ...)                                                                                  \
+	do {                                                                                                               \
+		if constexpr ((level) >= COMPILED_LOG_LEVEL) (logger).print((level), __VA_ARGS__);                             \
+	} while (false)
+#define LOG_PRINTLN(logger, level, ...)                                                                                \
+	do {                                                                                                               \
+		if constexpr ((level) >= COMPILED_LOG_LEVEL) (logger).println((level), __VA_ARGS__);                           \
+	} while (false)
+
 enum class TEXT_COLOR
 {
 	NORMAL,
@@ -97,19 +116,23 @@ std::string pad_spaces(const std::string &input, size_t desired_length);
 
 std::string trunc_zeros(const std::string &input, size_t num_digits);
 
-constexpr std::string log_level_to_string(LOG_LEVEL level);
-constexpr std::string text_color_to_string(TEXT_COLOR color);
+constexpr std::string_view log_level_to_string(LOG_LEVEL level);
+constexpr std::string_view text_color_to_string(TEXT_COLOR color);
 
-constexpr std::string log_level_to_escape_seq(LOG_LEVEL level);
-constexpr std::string text_color_to_escape_seq(TEXT_COLOR color);
+constexpr std::string_view log_level_to_escape_seq(LOG_LEVEL level);
+constexpr std::string_view text_color_to_escape_seq(TEXT_COLOR color);
 
 std::string set_color(const std::string &text, TEXT_COLOR color);
 
+class log_output;
+
 class Logger
 {
 private:
 	bool _print_header = true;
 
+	void _print_header_to(log_output &out, LOG_LEVEL level);
+
 public:
 	enum class HeaderType
 	{
@@ -130,6 +153,29 @@ public:
 	 * @returns The current timestamp in the following format: `mm/dd/yyyy hh:mm:ss.mmm tz`
 	 */
 	std::string static get_timestamp();
+	std::string static format_timestamp(std::chrono::system_clock::time_point time);
+
+	/**
+	 * @brief Switches every logger to asynchronous output. Each thread's messages are copied into its own lock-free
+	 * ring buffer, and a background thread writes them out, so logging never waits on I/O (unless a buffer fills
+	 * up). Messages from one thread stay in order, but lines from different threads may interleave differently.
+	 * Everything still buffered is also written out if the program crashes.
+	 * @param path The file to write to, or an empty string for stdout.
+	 * @returns False if the file couldn't be opened, which leaves the output synchronous.
+	 */
+	bool static start_async(const std::string &path = "");
+
+	/**
+	 * @brief Writes out everything logged so far, then switches back to synchronous output on stdout.
+	 * Threads must not be logging while this runs.
+	 */
+	void static stop_async();
+
+	/**
+	 * @brief Blocks until everything the calling thread logged so far has been written. Does nothing when the
+	 * output is synchronous.
+	 */
+	void static flush();
 
 	void static print_color_test();
 
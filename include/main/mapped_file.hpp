@@ -0,0 +1,32 @@
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <string>
+
+// A whole file opened read-only. It is mapped into memory where the platform supports it, and copied into memory
+// otherwise, so large files (networks, training data) can be used in place either way.
+class mapped_file
+{
+	const char             *_data = nullptr;
+	size_t                  _size = 0;
+	// Only used without mmap.
+	std::unique_ptr<char[]> copy;
+
+public:
+	mapped_file() = default;
+	// Check `is_open` afterwards, the file might not exist or be empty.
+	explicit mapped_file(const std::string &path);
+	~mapped_file();
+
+	mapped_file(const mapped_file &)            = delete;
+	mapped_file &operator=(const mapped_file &) = delete;
+	mapped_file(mapped_file &&other) noexcept;
+	mapped_file &operator=(mapped_file &&other) noexcept;
+
+	bool        is_open() const { return this->_data != nullptr; }
+	const char *data() const { return this->_data; }
+	size_t      size() const { return this->_size; }
+
+	void close();
+};
\ No newline at end of file
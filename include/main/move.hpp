@@ -1,6 +1,8 @@
 #pragma once
 
+#include <algorithm>
 #include <array>
+#include <cstddef>
 #include <cstdint>
 #include <string>
 
@@ -87,6 +89,10 @@ constexpr std::array<int, 8> KNIGHT_DIRECTION_OFFSETS = { 6, 15, 17, 10, -6, -15
 
 class Board;
 
+// The longest moves in UCI notation ("e7e8q") and in SAN ("Qa1xb2+" or "exd8=Q#"), without a null terminator.
+constexpr size_t MAX_UCI_LENGTH = 5;
+constexpr size_t MAX_SAN_LENGTH = 7;
+
 enum class PromotionOptions : uint8_t
 {
 	KNIGHT      = 0,
@@ -203,4 +209,25 @@ public:
 	constexpr bool is_none() const noexcept { return this->empty(); }
 
 	std::string to_string(const Board &state, bool short_version = false) const;
+
+	// These write into the caller's buffer and return the length, without a null terminator or any allocation.
+	// UCI notation, like "e2e4" or "e7e8q". An empty move is written as "0000".
+	size_t to_uci(char *buffer) const;
+	// Standard Algebraic Notation, like "Nbd7", "O-O-O" or "exd8=Q#". The move has to be legal in `state`.
+	// Telling mate from check means playing the move, so `state` is changed and restored when the move checks.
+	size_t to_san(char *buffer, Board &state) const;
+
+	// The same, written to any output iterator, like an ostream iterator or a `std::format_context`'s.
+	template <typename OutputIt>
+	OutputIt format_uci(OutputIt out) const
+	{
+		char buffer[MAX_UCI_LENGTH];
+		return std::copy_n(buffer, this->to_uci(buffer), out);
+	}
+	template <typename OutputIt>
+	OutputIt format_san(OutputIt out, Board &state) const
+	{
+		char buffer[MAX_SAN_LENGTH];
+		return std::copy_n(buffer, this->to_san(buffer, state), out);
+	}
 };
\ No newline at end of file
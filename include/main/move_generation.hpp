@@ -118,4 +118,12 @@ static consteval std::array<bitboard::bitboard, 64> _precompute_king_squares()
 
 constexpr std::array<bitboard::bitboard, 64> KING_MOVES = _precompute_king_squares();
 
-std::vector<Move> generate_moves(const Board &state);
\ No newline at end of file
+std::vector<Move> generate_moves(const Board &state);
+
+// Checks a single move (e.g. one taken from a hash table or killer slot) against the current position without
+// generating the full move list. Returns true exactly when `generate_moves(state)` would contain `m`.
+bool is_legal(const Board &state, Move m);
+
+// Same as `!generate_moves(state).empty()`, but stops at the first legal move and doesn't allocate.
+// Made for telling checkmate and stalemate apart from other positions.
+bool has_legal_moves(const Board &state);
\ No newline at end of file
@@ -0,0 +1,92 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+#include "hc_evaluation.hpp"
+#include "pieces.hpp"
+
+class Board;
+
+// An efficiently updatable neural network, used instead of the hand-crafted evaluation when a network is loaded.
+// https://www.chessprogramming.org/NNUE
+namespace evaluation::nnue
+{
+
+// HalfKP inputs: one per (own king square, non-king piece, piece square), seen from each side of the board.
+// Black's inputs are mirrored vertically, so both sides share the same weights.
+constexpr size_t KING_SQUARES  = 64;
+constexpr size_t PIECE_INDICES = 10;
+constexpr size_t INPUTS        = KING_SQUARES * PIECE_INDICES * 64;
+constexpr size_t HIDDEN        = 256;
+
+// The hidden layer is clipped to [0, ACTIVATION_MAX] and the output weights are scaled by WEIGHT_SCALE,
+// so the raw output has to be divided by both to get back to (scaled) centipawns.
+constexpr int32_t ACTIVATION_MAX = 127;
+constexpr int32_t WEIGHT_SCALE   = 64;
+constexpr int32_t EVAL_SCALE     = 400;
+
+// Loaded at startup if it exists. Without it the bot falls back to the hand-crafted evaluation.
+constexpr const char *DEFAULT_NETWORK_FILE = "network.nnue";
+
+// "NNUE" in little-endian.
+constexpr uint32_t FILE_MAGIC   = 0x45554e4e;
+constexpr uint32_t FILE_VERSION = 1;
+
+/**
+ * Network files start with this header, followed directly by (all little-endian, no padding):
+ * int16_t feature_weights[INPUTS][HIDDEN]
+ * int16_t feature_biases[HIDDEN]
+ * int8_t  output_weights[2 * HIDDEN]   (side to move first, then the other side)
+ * int32_t output_bias
+ */
+struct file_header
+{
+	uint32_t magic;
+	uint32_t version;
+	uint32_t inputs;
+	uint32_t hidden;
+};
+
+constexpr size_t FILE_SIZE = sizeof(file_header) + INPUTS * HIDDEN * sizeof(int16_t) + HIDDEN * sizeof(int16_t)
+                             + 2 * HIDDEN * sizeof(int8_t) + sizeof(int32_t);
+
+// The first layer's output for both sides, indexed by color.
+struct accumulator
+{
+	alignas(32) std::array<std::array<int16_t, HIDDEN>, 2> values;
+};
+
+// The pieces a move takes off and puts on the board. A move removes at most three pieces
+// (the mover, a captured piece and a castling rook) and adds at most two (the mover and a castling rook).
+struct delta
+{
+	std::array<Piece, 3> removed;
+	std::array<Piece, 2> added;
+	uint8_t              removed_count = 0;
+	uint8_t              added_count   = 0;
+	// Moving a king changes every input on its side, so that side has to be refreshed instead.
+	std::array<bool, 2>  king_moved    = { false, false };
+
+	void remove(const Piece &piece);
+	void add(const Piece &piece);
+};
+
+// Maps the network file at `path` into memory. Returns false (and keeps the previous network) if it can't be used.
+// Boards set up before loading a network need `Board::update_bitboards` to refresh their accumulators.
+bool load(const std::string &path);
+void unload();
+bool is_loaded();
+
+// Recomputes the accumulator from scratch, for one side or for both.
+void refresh(accumulator &acc, const Board &state, color_t perspective);
+void refresh(accumulator &acc, const Board &state);
+// Applies a move's changes to the accumulator. `state` must already be the position after the move.
+void update(accumulator &acc, const delta &changes, const Board &state);
+
+// Evaluates the board from the side to move's point of view. A network must be loaded.
+eval_t evaluate(const Board &state);
+
+} // namespace evaluation::nnue
\ No newline at end of file
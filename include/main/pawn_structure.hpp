@@ -0,0 +1,92 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "bitboard.hpp"
+#include "hc_evaluation.hpp"
+#include "pieces.hpp"
+#include "zobrist.hpp"
+
+class Board;
+
+// https://www.chessprogramming.org/Pawn_Structure
+// https://www.chessprogramming.org/Pawn_Hash_Table
+namespace evaluation::hce::pawns
+{
+
+namespace pawn_values
+{
+
+constexpr packed_eval_t ISOLATED  = make_packed(-10, -15);
+constexpr packed_eval_t DOUBLED   = make_packed(-10, -25);
+constexpr packed_eval_t BACKWARD  = make_packed(-8, -10);
+constexpr packed_eval_t CONNECTED = make_packed(7, 5);
+
+// Indexed by the rank of the passed pawn, counted from its own side of the board.
+constexpr std::array<packed_eval_t, 8> PASSED = {
+	0,
+	make_packed(5, 10),
+	make_packed(5, 15),
+	make_packed(10, 25),
+	make_packed(25, 45),
+	make_packed(45, 75),
+	make_packed(75, 120),
+	0,
+};
+
+constexpr packed_eval_t SHIELD_NEAR    = make_packed(12, 0);
+constexpr packed_eval_t SHIELD_FAR     = make_packed(6, 0);
+constexpr packed_eval_t OPEN_NEAR_KING = make_packed(-15, 0);
+
+} // namespace pawn_values
+
+// Squares no king can stand on. Marks an entry's shelter as not computed yet.
+constexpr uint8_t NO_KING = 64;
+
+struct entry
+{
+	zobrist::hash_t key   = 0;
+	// Score of the pawn structure, from white's point of view.
+	packed_eval_t   score = 0;
+	// The passed pawns of each side.
+	std::array<bitboard::bitboard, 2> passed{};
+	// Every square each side's pawns attack now, or could attack after advancing.
+	std::array<bitboard::bitboard, 2> attack_span{};
+
+	// The shelter depends on the king as well as the pawns, so it is only computed on demand,
+	// and is recomputed whenever the king has moved to another square.
+	std::array<uint8_t, 2>       shelter_king = { NO_KING, NO_KING };
+	std::array<packed_eval_t, 2> shelter{};
+};
+
+// Evaluates the pawn structure from scratch. The returned entry has no key and no shelter yet.
+entry evaluate_structure(bitboard::bitboard white_pawns, bitboard::bitboard black_pawns);
+
+// Each side's structure score from its own point of view, so `evaluate_structure`'s score is their difference.
+// Only used to break the evaluation down, so nothing is cached.
+std::array<packed_eval_t, 2> side_scores(bitboard::bitboard white_pawns, bitboard::bitboard black_pawns);
+
+// Shelter score for `color`'s king, from `color`'s point of view.
+// The result is cached in `pawn_entry` until the king moves to another square.
+packed_eval_t king_shelter(entry &pawn_entry, const Board &state, color_t color);
+
+constexpr size_t DEFAULT_TABLE_BITS = 13;
+
+class table
+{
+	std::vector<entry> entries;
+	size_t             mask;
+
+public:
+	explicit table(size_t size_bits = DEFAULT_TABLE_BITS);
+
+	// Returns the entry for the board's pawns, evaluating and storing them first if they weren't cached.
+	// `hit` is set to whether the entry was already in the table.
+	entry &probe(const Board &state, bool &hit);
+	void   clear();
+};
+
+} // namespace evaluation::hce::pawns
\ No newline at end of file
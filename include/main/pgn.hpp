@@ -0,0 +1,110 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "board.hpp"
+#include "move.hpp"
+
+// Reading games in Portable Game Notation.
+// https://www.chessprogramming.org/Portable_Game_Notation
+namespace pgn
+{
+
+enum class token_type : uint8_t
+{
+	END,
+	// The text between the brackets, like `Event "Casual game"`.
+	TAG,
+	// A brace comment without its braces, or a semicolon comment up to the end of the line.
+	COMMENT,
+	// A numeric annotation glyph without the dollar sign, like "1" for "$1".
+	NAG,
+	VARIATION_START,
+	VARIATION_END,
+	// A move number with its dots, like "12." or "12...".
+	MOVE_NUMBER,
+	// "1-0", "0-1", "1/2-1/2" or "*".
+	RESULT,
+	// Anything else, which is a move in SAN (like "Nbd7" or "e8=Q+") or an annotation like "e.p.".
+	SYMBOL,
+};
+
+struct token
+{
+	token_type       type = token_type::END;
+	// Points into the tokenized text, nothing is copied.
+	std::string_view text;
+};
+
+// Splits PGN text into tokens without copying or allocating anything.
+class tokenizer
+{
+	std::string_view text;
+	size_t           position = 0;
+
+public:
+	explicit tokenizer(std::string_view text) : text(text) {}
+
+	token  next();
+	// Where the next token starts, so a token can be put back with `rewind`.
+	size_t offset() const { return this->position; }
+	void   rewind(size_t offset) { this->position = offset; }
+};
+
+struct tag
+{
+	std::string_view name;
+	// Without the quotes. Escaped characters are left as they are in the file.
+	std::string_view value;
+};
+
+struct game
+{
+	std::vector<tag>  tags;
+	// The moves of the main line. Comments, annotation glyphs and variations are skipped.
+	std::vector<Move> moves;
+	std::string_view  result;
+	// False if a move couldn't be decoded. `moves` then holds the ones before it.
+	bool              valid = true;
+
+	// Returns an empty view if the game has no such tag.
+	std::string_view tag_value(std::string_view name) const;
+	// The "FEN" tag if there is one, otherwise the standard starting position.
+	std::string_view start_fen() const;
+};
+
+// Finds the legal move written in Standard Algebraic Notation, like "Nbd7", "exd6", "O-O-O" or "e8=Q+".
+// Check and annotation suffixes are ignored, and long forms like "Ng1-f3" are accepted too.
+// Only the pieces that could reach the destination are looked at, the full move list is never generated.
+std::optional<Move> parse_san(const Board &board, std::string_view san);
+
+// Reads games one after another from PGN text. The text has to outlive the games, which point into it.
+class reader
+{
+	tokenizer tokens;
+	Board     board;
+
+public:
+	explicit reader(std::string_view text) : tokens(text) {}
+
+	// Returns false once there are no games left. `result` is reused, so reading a file doesn't allocate much.
+	bool next(game &result);
+	// The position at the end of the last game read.
+	const Board &final_position() const { return this->board; }
+};
+
+// Splits the text into at most `count` pieces of roughly equal size, each starting at the beginning of a game.
+std::vector<std::string_view> split_games(std::string_view text, size_t count);
+
+// Maps the file and reads its games on `threads` threads, each working on its own share of the file.
+// `visit` is called from all of those threads at once. Returns the number of games read, or 0 if the file
+// couldn't be opened.
+size_t read_file(const std::string &path, size_t threads, const std::function<void(const game &)> &visit);
+
+} // namespace pgn
\ No newline at end of file
@@ -1,19 +1,81 @@
 #pragma once
 
-#include "hc_evaluation.hpp"
+#include "evaluation.hpp"
 #include "move.hpp"
 
-#include <cstdint>
+#include <atomic>
 #include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <functional>
+#include <vector>
 
 class Board;
 
+// Checkmate is scored as MATE_SCORE minus the number of plies until the mate, so quicker mates score higher.
+constexpr evaluation::eval_t MATE_SCORE     = 1'000'000;
+// Bigger than any score the search can return, used as the initial alpha-beta window.
+constexpr evaluation::eval_t INFINITE_SCORE = MATE_SCORE + 1;
+// Iterative deepening never goes deeper than this, and mates are never further away.
+constexpr uint32_t           MAX_DEPTH      = 128;
+
+constexpr bool is_mate_score(evaluation::eval_t score)
+{
+	return std::abs(score) >= MATE_SCORE - (evaluation::eval_t) MAX_DEPTH;
+}
+
+// One of the root moves a search ranked, with its score.
+struct pv_line
+{
+	Move               move;
+	evaluation::eval_t score;
+};
+
 struct search_result
 {
 	std::chrono::milliseconds search_time;
 	evaluation::eval_t score;
 	Move move;
+	// Evaluation cache usage and evaluation counters during this search, over all of its threads.
+	evaluation::cache_stats     eval_cache;
+	evaluation::hce::eval_stats eval_stats;
+	// The deepest iteration that finished, and the nodes searched in total.
+	uint32_t depth = 0;
+	uint64_t nodes = 0;
+	// The best `search_limits::multipv` root moves of the deepest finished iteration, best first.
+	std::vector<pv_line> lines;
 };
 
+// 0 means no limit, for all of these.
+struct search_limits
+{
+	uint32_t                  depth = 0;
+	uint64_t                  nodes = 0;
+	std::chrono::milliseconds time{ 0 };
+	// How many of the best root moves get an exact score. Every extra one makes the search slower,
+	// since only moves that can't reach the top `multipv` can be cut off.
+	size_t                    multipv = 1;
+};
+
+// Lets another thread steer a running search.
+struct search_control
+{
+	// Stops the search as soon as possible. The best move of the last finished iteration is returned.
+	std::atomic<bool>    stop{ false };
+	// When the search has to stop, in steady clock nanoseconds, or 0 for no deadline. Unlike `search_limits::time`,
+	// it can be moved while the search is running (when a ponder search turns into a real one, for example).
+	std::atomic<int64_t> deadline{ 0 };
+	// Root moves are shared out between this many threads.
+	size_t               threads = 1;
+	// Called on the searching thread after every finished iteration.
+	std::function<void(const search_result &)> on_iteration;
+};
+
+int64_t to_deadline(std::chrono::steady_clock::time_point time);
+
+// Searches with iterative deepening until one of the limits is reached, or the control says to stop.
+search_result search(const Board &board, const search_limits &limits, search_control &control);
+
 // Use a depth of 0 to search (effectively) infinitely.
 search_result get_best_move(const Board &board, uint32_t depth, std::chrono::milliseconds max_time = std::chrono::milliseconds(0));
\ No newline at end of file
@@ -0,0 +1,40 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <bit>
+#include <cstddef>
+
+// A fixed-size ring buffer for exactly one producer thread and one consumer thread, without locks.
+// Each index is only ever written by one side, so publishing it with release/acquire ordering is all it takes.
+template <typename T, size_t Capacity> class spsc_queue
+{
+	static_assert(std::has_single_bit(Capacity), "The capacity has to be a power of two, so indexing is a mask.");
+	static constexpr size_t MASK = Capacity - 1;
+
+	std::array<T, Capacity> items;
+	// Both only ever grow. Kept on separate cache lines, so the two threads don't keep stealing each other's line.
+	alignas(64) std::atomic<size_t> head{ 0 };
+	alignas(64) std::atomic<size_t> tail{ 0 };
+
+public:
+	// Producer only. Returns false if the queue is full.
+	bool try_push(const T &item)
+	{
+		const size_t write = this->tail.load(std::memory_order_relaxed);
+		if (write - this->head.load(std::memory_order_acquire) == Capacity) return false;
+		this->items[write & MASK] = item;
+		this->tail.store(write + 1, std::memory_order_release);
+		return true;
+	}
+
+	// Consumer only. Returns false if the queue is empty.
+	bool try_pop(T &item)
+	{
+		const size_t read = this->head.load(std::memory_order_relaxed);
+		if (read == this->tail.load(std::memory_order_acquire)) return false;
+		item = this->items[read & MASK];
+		this->head.store(read + 1, std::memory_order_release);
+		return true;
+	}
+};
\ No newline at end of file
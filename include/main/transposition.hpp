@@ -0,0 +1,96 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+#include "eval_types.hpp"
+#include "move.hpp"
+#include "zobrist.hpp"
+
+// Remembers what the search found out about positions, so positions reached again (through a transposition, in
+// the next iteration, or in the next search) can reuse it. The table is shared by every search thread.
+// https://www.chessprogramming.org/Transposition_Table
+namespace transposition
+{
+
+using evaluation::eval_t;
+
+// What the stored score says about the position's real score.
+enum class bound : uint8_t
+{
+	NONE,
+	// The score is exact.
+	EXACT,
+	// The search failed high, so the real score is at least this.
+	LOWER,
+	// The search failed low, so the real score is at most this.
+	UPPER,
+};
+
+struct entry
+{
+	eval_t  score = 0;
+	// The best move found, or an empty move if every move failed low.
+	Move    move;
+	uint8_t depth = 0;
+	bound   type  = bound::NONE;
+};
+
+constexpr size_t DEFAULT_SIZE_MB = 16;
+
+// Resizes (and clears) the table, unless it already has this size. A file-backed table keeps the size of its file,
+// so this returns false for any other size. Like everything below except `probe` and `store`, this must not be called
+// while anything is searching.
+bool   set_size(size_t megabytes);
+size_t get_size();
+void   clear();
+
+// Returns true and fills `found` if the position is in the table. Mate scores are stored relative to the position,
+// so `ply` (the distance from the root) is needed to turn them back into scores relative to the root.
+bool probe(zobrist::hash_t key, uint32_t ply, entry &found);
+void store(zobrist::hash_t key, uint32_t ply, const entry &data);
+
+/**
+ * Table files start with this header, followed directly by the entries. The table is used in place, so files are
+ * only valid on the machine (or at least the byte order) that wrote them, and only with the same hash keys.
+ */
+struct file_header
+{
+	uint32_t magic;
+	uint32_t version;
+	// zobrist::HASH_VERSION when the file was written. Entries from other keys would match the wrong positions.
+	uint32_t hash_version;
+	uint32_t entry_size;
+	uint64_t entries;
+	// Pads the header, so the entries start on a cache line.
+	uint64_t reserved[5];
+};
+
+// "CBTT" in little-endian.
+constexpr uint32_t FILE_MAGIC   = 0x54544243;
+constexpr uint32_t FILE_VERSION = 1;
+
+/**
+ * Keeps the table in the file at `path` from now on, so everything the search stores survives a restart.
+ * An existing file is used as it is, and its pages are only read from disk the first time the search touches them,
+ * so opening even a table of many gigabytes is instant. A missing file is created with `megabytes`, or the current
+ * size if that's 0. Returns false (and keeps the current table) if the file can't be used. An existing file that
+ * isn't a valid table is never changed.
+ */
+bool open_file(const std::string &path, size_t megabytes = 0);
+// Moves the table back into memory, empty. Everything stored so far stays in the file.
+void close_file();
+// Whether the table currently lives in a file opened with `open_file`.
+bool is_file_backed();
+// Whether the table came from a file, through `open_file` or `load`. Such a table is kept for a new game.
+bool is_from_file();
+
+// Writes a snapshot of the table to `path`. If the table lives in `path` already (see `open_file`),
+// this only flushes it to disk, and the table keeps using the file.
+bool save(const std::string &path);
+// Uses a snapshot written by `save` (or a file from `open_file`). Like `open_file`, its pages are read on demand,
+// but changes to the table are never written back to the file. Returns false if the file isn't a valid table.
+bool load(const std::string &path);
+
+} // namespace transposition
\ No newline at end of file
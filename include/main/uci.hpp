@@ -0,0 +1,29 @@
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <iostream>
+
+// The Universal Chess Interface, which lets GUIs and match runners talk to the bot over standard input and output.
+// https://www.chessprogramming.org/UCI
+// https://backscattering.de/chess/uci/
+namespace uci
+{
+
+constexpr const char *ENGINE_NAME   = "chess-bot";
+constexpr const char *ENGINE_AUTHOR = "JD06450";
+
+// Subtracted from every time budget, to cover the time it takes the GUI to see the move.
+constexpr std::chrono::milliseconds MOVE_OVERHEAD{ 30 };
+// Assumed number of moves left in the game when the GUI doesn't send `movestogo`.
+constexpr int64_t                   DEFAULT_MOVES_TO_GO = 30;
+
+constexpr size_t MAX_HASH_MB = 4096;
+constexpr size_t MAX_THREADS = 256;
+
+// Reads commands from `input` and answers on `output` until `quit` is received or the input ends.
+// Commands are read on the calling thread while searches run on another, so `stop` is handled straight away.
+void run(std::istream &input, std::ostream &output);
+
+} // namespace uci
\ No newline at end of file
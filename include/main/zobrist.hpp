@@ -0,0 +1,71 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+
+#include "pieces.hpp"
+
+// https://www.chessprogramming.org/Zobrist_Hashing
+namespace zobrist
+{
+
+typedef uint64_t hash_t;
+
+// Bump this whenever the key generation below changes, so anything that stores hashes can tell they're stale.
+constexpr uint32_t HASH_VERSION = 1;
+
+// SplitMix64, used to fill the key tables at compile time.
+constexpr uint64_t _next_random(uint64_t &state)
+{
+	uint64_t z = (state += 0x9e3779b97f4a7c15);
+	z          = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9;
+	z          = (z ^ (z >> 27)) * 0x94d049bb133111eb;
+	return z ^ (z >> 31);
+}
+
+struct key_tables
+{
+	std::array<std::array<std::array<hash_t, 64>, (size_t) PieceType::MAX_TYPE>, 2> pieces{};
+	std::array<hash_t, 16>                                                           castling{};
+	std::array<hash_t, 8>                                                            en_passant{};
+	hash_t                                                                           black_to_move = 0;
+};
+
+static consteval key_tables _generate_keys()
+{
+	key_tables keys{};
+	uint64_t   state = 0x2545f4914f6cdd1d;
+
+	for (auto &color : keys.pieces)
+		// PieceType::NONE is left as zero, so hashing an empty square is a no-op.
+		for (size_t type = 1; type < color.size(); type++)
+			for (auto &key : color[type]) key = _next_random(state);
+
+	// Index 0 (no castling rights at all) stays zero.
+	for (size_t i = 1; i < keys.castling.size(); i++) keys.castling[i] = _next_random(state);
+	for (auto &key : keys.en_passant) key = _next_random(state);
+	keys.black_to_move = _next_random(state);
+
+	return keys;
+}
+
+constexpr key_tables KEYS = _generate_keys();
+
+constexpr hash_t piece_key(PieceType type, color_t color, uint8_t square)
+{
+	return KEYS.pieces[color][(size_t) type][square];
+}
+constexpr hash_t piece_key(const Piece &piece)
+{
+	return piece_key(piece.get_type(), piece.get_color(), piece.position());
+}
+
+// Only pawns contribute to the pawn hash, so everything else hashes to zero.
+constexpr hash_t pawn_key(const Piece &piece) { return piece.get_type() == PieceType::PAWN ? piece_key(piece) : 0; }
+
+// `rights` packs the castling rights as WK | WQ << 1 | BK << 2 | BQ << 3.
+constexpr hash_t castling_key(uint8_t rights) { return KEYS.castling[rights & 0b1111]; }
+constexpr hash_t en_passant_key(int16_t target) { return target == -1 ? 0 : KEYS.en_passant[target % 8]; }
+constexpr hash_t side_key(color_t color) { return color == BLACK ? KEYS.black_to_move : 0; }
+
+} // namespace zobrist
\ No newline at end of file
@@ -0,0 +1,3 @@
+#pragma once
+
+void test_tuner();
\ No newline at end of file
@@ -0,0 +1,51 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// Labelled positions, each converted once into the sparse set of parameters its evaluation depends on.
+// https://www.chessprogramming.org/Texel%27s_Tuning_Method
+namespace tuner
+{
+
+// Parameter `index` counts `value` times: the number of white pieces using it minus the number of black ones.
+struct coefficient
+{
+	uint16_t index;
+	int8_t   value;
+};
+
+struct position
+{
+	uint32_t first_coefficient;
+	uint16_t coefficient_count;
+	// From 0 with all pieces on the board to 256 once they are all gone, like in `two_phase_lerp`.
+	uint16_t phase;
+	// The evaluation terms the tuner doesn't fit, from white's point of view.
+	int16_t  fixed_mg;
+	int16_t  fixed_eg;
+	// The game's result from white's point of view: 1 for a win, 0.5 for a draw and 0 for a loss.
+	float    result;
+};
+
+struct dataset
+{
+	std::vector<position>    positions;
+	std::vector<coefficient> coefficients;
+	// Lines that couldn't be parsed, or held a position that isn't quiet.
+	size_t                   skipped = 0;
+};
+
+// Reads the game result from an EPD line, and sets `fen_length` to the length of the position in front of it.
+// Understands `[1.0]`, `[0.5]`, `[1-0]`, `c9 "1/2-1/2";` and a bare `0-1` at the end of the line.
+std::optional<float> parse_result(std::string_view line, size_t &fen_length);
+
+// Maps the file into memory and converts every line in parallel.
+// Returns nothing if the file can't be opened.
+std::optional<dataset> load_dataset(const std::string &path);
+
+} // namespace tuner
\ No newline at end of file
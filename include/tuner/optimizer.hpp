@@ -0,0 +1,40 @@
+#pragma once
+
+#include <cstddef>
+#include <functional>
+
+#include "dataset.hpp"
+#include "parameters.hpp"
+
+namespace tuner
+{
+
+// The linear evaluation of a position with the given parameters, from white's point of view.
+double evaluate(const dataset &data, const position &entry, const parameters &params);
+
+// Mean squared error between the results and the evaluations mapped to an expected score,
+// `1 / (1 + 10^(-scaling * eval / 400))`.
+double mean_error(const dataset &data, const parameters &params, double scaling);
+
+// Finds the scaling that best fits the current evaluation to the results, so tuning
+// fixes the evaluation instead of just stretching or shrinking it.
+double fit_scaling(const dataset &data, const parameters &params);
+
+struct adam_settings
+{
+	size_t epochs        = 1000;
+	double learning_rate = 1.0;
+	double beta1         = 0.9;
+	double beta2         = 0.999;
+	double epsilon       = 1e-8;
+};
+
+// Called after every epoch with the epoch number. Return false to stop early.
+typedef std::function<bool(size_t epoch)> epoch_callback;
+
+// Fits `params` with full-batch gradient descent, using Adam to pick each parameter's step size.
+// https://arxiv.org/abs/1412.6980
+void tune(const dataset &data, parameters &params, double scaling, const adam_settings &settings,
+          const epoch_callback &callback);
+
+} // namespace tuner
\ No newline at end of file
@@ -0,0 +1,63 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+#include "pieces.hpp"
+
+// The evaluation parameters in hc_parameters.hpp, flattened so every position can be written as a sparse
+// linear combination of them.
+namespace tuner
+{
+
+// Piece values from pawn to queen. Kings always cancel out, so they have no value to fit.
+constexpr size_t PIECE_VALUE_OFFSET = 0;
+constexpr size_t PIECE_VALUE_COUNT  = 5;
+// Piece-square tables from pawn to king, indexed by the square from white's side.
+constexpr size_t TABLE_OFFSET       = PIECE_VALUE_OFFSET + PIECE_VALUE_COUNT;
+constexpr size_t TABLE_COUNT        = 6 * 64;
+// The `modifier_values`, which have a single value for both phases.
+constexpr size_t MODIFIER_OFFSET    = TABLE_OFFSET + TABLE_COUNT;
+constexpr size_t MODIFIER_COUNT     = 4;
+
+constexpr size_t PARAMETER_COUNT = MODIFIER_OFFSET + MODIFIER_COUNT;
+
+enum modifier : size_t
+{
+	ROOK_PAIR,
+	BISHOP_PAIR,
+	KNIGHT_PAIR,
+	NO_PAWNS
+};
+
+constexpr size_t piece_value_index(PieceType type)
+{
+	return PIECE_VALUE_OFFSET + (size_t) type - (size_t) PieceType::PAWN;
+}
+constexpr size_t table_index(PieceType type, uint8_t square)
+{
+	return TABLE_OFFSET + ((size_t) type - (size_t) PieceType::PAWN) * 64 + square;
+}
+constexpr size_t modifier_index(modifier mod) { return MODIFIER_OFFSET + mod; }
+
+// Tied parameters have to keep the same midgame and endgame value.
+constexpr bool is_tied(size_t index) { return index >= MODIFIER_OFFSET; }
+
+struct parameter
+{
+	double mg = 0;
+	double eg = 0;
+};
+
+typedef std::array<parameter, PARAMETER_COUNT> parameters;
+
+// The parameters the evaluation is currently compiled with.
+parameters current_parameters();
+
+// Writes `params` as a replacement for hc_parameters.hpp, rounding every value to a whole centipawn.
+// `comment` is added to the top of the file. Returns false if the file can't be written.
+bool write_header(const std::string &path, const parameters &params, const std::string &comment);
+
+} // namespace tuner
\ No newline at end of file
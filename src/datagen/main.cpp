@@ -0,0 +1,151 @@
+#include "selfplay.hpp"
+#include "spsc_queue.hpp"
+
+#include "binary_position.hpp"
+#include "board.hpp"
+#include "evaluation.hpp"
+#include "kpk.hpp"
+#include "nnue.hpp"
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cxxopts.hpp>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <thread>
+#include <vector>
+
+using Clock = std::chrono::steady_clock;
+using namespace std::chrono_literals;
+
+// Each worker's positions wait here until the writer gets to them. A worker only blocks once it's this far ahead.
+typedef spsc_queue<binary::position, 1 << 14> position_queue;
+
+int main(int argc, char **argv)
+{
+	cxxopts::Options options("datagen", "Generates scored positions from self-play games");
+	options.add_options()
+		("o,output", "Binary position file to append to", cxxopts::value<std::string>())
+		("p,positions", "Stop after writing this many positions",
+		 cxxopts::value<uint64_t>()->default_value("1000000"))
+		("t,threads", "Number of games played at once, one per thread",
+		 cxxopts::value<size_t>()->default_value(std::to_string(std::max(std::thread::hardware_concurrency(), 1u))))
+		("n,nodes", "Nodes searched per move", cxxopts::value<uint64_t>()->default_value("5000"))
+		("r,random-plies", "Random moves at the start of every game", cxxopts::value<uint32_t>()->default_value("8"))
+		("s,seed", "Seed for the random openings", cxxopts::value<uint64_t>()->default_value("1"))
+		("h,help", "Print this help");
+	options.parse_positional({ "output" });
+	const cxxopts::ParseResult args = options.parse(argc, argv);
+
+	if (args.count("help") || !args.count("output"))
+	{
+		std::cout << options.help() << std::endl;
+		return args.count("help") ? 0 : 1;
+	}
+
+	const std::string path = args["output"].as<std::string>();
+	binary::writer    output(path, true);
+	if (!output.good())
+	{
+		std::cerr << "Couldn't open " << path << std::endl;
+		return 1;
+	}
+
+	datagen::settings config;
+	config.nodes        = args["nodes"].as<uint64_t>();
+	config.random_plies = args["random-plies"].as<uint32_t>();
+
+	const uint64_t target       = args["positions"].as<uint64_t>();
+	const size_t   thread_count = std::max<size_t>(args["threads"].as<size_t>(), 1);
+	const uint64_t seed         = args["seed"].as<uint64_t>();
+
+	(void) evaluation::nnue::load(evaluation::nnue::DEFAULT_NETWORK_FILE);
+	// Built up front, so no self-play game stalls on the first KPK probe.
+	evaluation::endgame::kpk::init();
+
+	std::vector<std::unique_ptr<position_queue>> queues;
+	for (size_t i = 0; i < thread_count; i++) queues.push_back(std::make_unique<position_queue>());
+
+	std::atomic<bool>                    stop{ false };
+	std::atomic<size_t>                  running{ thread_count };
+	std::atomic<uint64_t>                games{ 0 };
+	// Indexed by result, like `binary::position::result`.
+	std::array<std::atomic<uint64_t>, 3> results{};
+
+	std::vector<std::thread> workers;
+	for (size_t index = 0; index < thread_count; index++)
+	{
+		workers.emplace_back(
+		    [&, index]
+		    {
+			    std::seed_seq                 seeds{ seed, (uint64_t) index };
+			    std::mt19937_64               rng(seeds);
+			    Board                         board;
+			    std::vector<binary::position> positions;
+			    position_queue               &queue = *queues[index];
+
+			    while (!stop.load(std::memory_order_relaxed))
+			    {
+				    positions.clear();
+				    results[datagen::play_game(board, rng, config, positions)]++;
+				    games++;
+				    for (const binary::position &packed : positions)
+					    while (!queue.try_push(packed)) std::this_thread::sleep_for(100us);
+			    }
+			    running--;
+		    });
+	}
+
+	// This thread is the only writer, so the output needs no locking.
+	const Clock::time_point start   = Clock::now();
+	Clock::time_point       report  = start;
+	uint64_t                written = 0;
+	const auto              print_progress = [&]
+	{
+		const double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+		std::cout << written << " positions from " << games << " games (" << (uint64_t) (written / seconds)
+		          << "/s), white won " << results[binary::WHITE_WIN] << ", drew " << results[binary::DRAW]
+		          << ", lost " << results[binary::BLACK_WIN] << std::endl;
+	};
+
+	while (true)
+	{
+		// Workers push their last game before they stop running, so if they had all stopped before this pass,
+		// it's the last one needed.
+		const bool       finished = running == 0;
+		bool             drained  = false;
+		binary::position packed;
+		for (auto &queue : queues)
+		{
+			while (queue->try_pop(packed))
+			{
+				output.write(packed);
+				written++;
+				drained = true;
+			}
+		}
+
+		if (written >= target) stop = true;
+		if (finished && !drained) break;
+		if (!drained) std::this_thread::sleep_for(1ms);
+		if (Clock::now() - report >= 10s)
+		{
+			report = Clock::now();
+			print_progress();
+		}
+	}
+	print_progress();
+
+	for (auto &worker : workers) worker.join();
+	output.flush();
+	if (!output.good())
+	{
+		std::cerr << "Couldn't write " << path << std::endl;
+		return 1;
+	}
+	std::cout << "Wrote " << written << " positions to " << path << std::endl;
+	return 0;
+}
\ No newline at end of file
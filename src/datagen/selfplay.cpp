@@ -0,0 +1,109 @@
+#include "selfplay.hpp"
+
+#include "board.hpp"
+#include "endgame.hpp"
+#include "fen.hpp"
+#include "move_generation.hpp"
+#include "search.hpp"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+
+namespace datagen
+{
+
+// Plays random moves from the start position until it finds an opening that's still roughly balanced.
+static void random_opening(Board &board, std::mt19937_64 &rng, const settings &config, search_control &control)
+{
+	while (true)
+	{
+		(void) board.set_fen(START_FEN);
+		board.update_bitboards();
+
+		bool game_over = false;
+		for (uint32_t ply = 0; ply < config.random_plies && !game_over; ply++)
+		{
+			const std::vector<Move> moves = generate_moves(board);
+			if (moves.empty()) game_over = true;
+			else board.make_move(moves[std::uniform_int_distribution<size_t>(0, moves.size() - 1)(rng)]);
+		}
+		if (game_over || generate_moves(board).empty()) continue;
+
+		const search_result result = search(board, search_limits{ 0, config.nodes }, control);
+		if (std::abs(result.score) <= config.max_opening_score) return;
+	}
+}
+
+// Returns true and sets `result` if the game is over by the rules.
+static bool game_over(const Board &board, const std::vector<Move> &moves, uint8_t &result)
+{
+	if (moves.empty())
+	{
+		if (!board.is_in_check()) result = binary::DRAW;
+		else result = board.turn_to_move() == WHITE ? binary::BLACK_WIN : binary::WHITE_WIN;
+		return true;
+	}
+
+	const evaluation::endgame::entry *ending = evaluation::endgame::probe(board);
+	if (board.is_fifty_move_draw() || board.is_repetition() || (ending != nullptr && ending->exact))
+	{
+		result = binary::DRAW;
+		return true;
+	}
+	return false;
+}
+
+uint8_t play_game(Board                         &board,
+                  std::mt19937_64               &rng,
+                  const settings                &config,
+                  std::vector<binary::position> &positions)
+{
+	search_control control;
+	random_opening(board, rng, config, control);
+
+	const size_t first_position = positions.size();
+	uint8_t      result         = binary::DRAW;
+	uint32_t     white_streak = 0, black_streak = 0, draw_streak = 0;
+
+	for (uint32_t ply = 0; ply < config.max_plies; ply++)
+	{
+		const std::vector<Move> moves = generate_moves(board);
+		if (game_over(board, moves, result)) break;
+
+		const search_result best  = search(board, search_limits{ 0, config.nodes }, control);
+		const eval_t        score = board.turn_to_move() == WHITE ? best.score : -best.score;
+
+		// Both sides' searches have to agree for a few plies, so one bad search can't end the game.
+		white_streak = score >= config.win_score ? white_streak + 1 : 0;
+		black_streak = score <= -config.win_score ? black_streak + 1 : 0;
+		draw_streak  = ply >= config.draw_start && std::abs(score) <= config.draw_score ? draw_streak + 1 : 0;
+		if (white_streak >= config.win_plies || black_streak >= config.win_plies)
+		{
+			result = white_streak != 0 ? binary::WHITE_WIN : binary::BLACK_WIN;
+			break;
+		}
+		if (draw_streak >= config.draw_plies)
+		{
+			result = binary::DRAW;
+			break;
+		}
+
+		// Only quiet positions are worth keeping: the static evaluation can't judge a position in the middle
+		// of an exchange, or one where the side to move is in check.
+		if (!board.is_in_check() && !best.move.is_capture() && !best.move.is_promotion() && !is_mate_score(score))
+		{
+			// Mate scores were left out above, so only won endings could come near the limits.
+			binary::position packed = board.to_packed();
+			packed.score            = (int16_t) std::clamp<eval_t>(score, -INT16_MAX, INT16_MAX);
+			positions.push_back(packed);
+		}
+
+		board.make_move(best.move);
+	}
+
+	for (size_t i = first_position; i < positions.size(); i++) positions[i].result = result;
+	return result;
+}
+
+} // namespace datagen
\ No newline at end of file
@@ -0,0 +1,639 @@
+#include "analysis_server.hpp"
+
+#include "board.hpp"
+#include "fen.hpp"
+#include "move_generation.hpp"
+#include "search.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <charconv>
+#include <chrono>
+#include <cmath>
+#include <condition_variable>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <sstream>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#define HAS_UNIX_SOCKETS 1
+#endif
+
+namespace analysis
+{
+
+using Clock = std::chrono::steady_clock;
+using evaluation::eval_t;
+
+#pragma region JSON
+
+// Just enough JSON to read requests. Values a request doesn't use are checked and skipped, but not kept.
+class json_parser
+{
+	std::string_view text;
+	size_t           position = 0;
+
+public:
+	explicit json_parser(std::string_view text) : text(text) {}
+
+	bool at_end()
+	{
+		this->skip_space();
+		return this->position == this->text.size();
+	}
+
+	bool consume(char expected)
+	{
+		this->skip_space();
+		if (this->position == this->text.size() || this->text[this->position] != expected) return false;
+		this->position++;
+		return true;
+	}
+
+	std::optional<std::string> parse_string()
+	{
+		if (!this->consume('"')) return std::nullopt;
+
+		std::string result;
+		while (this->position < this->text.size())
+		{
+			const char c = this->text[this->position++];
+			if (c == '"') return result;
+			if (c != '\\')
+			{
+				result += c;
+				continue;
+			}
+
+			if (this->position == this->text.size()) break;
+			switch (const char escaped = this->text[this->position++])
+			{
+			case 'b': result += '\b'; break;
+			case 'f': result += '\f'; break;
+			case 'n': result += '\n'; break;
+			case 'r': result += '\r'; break;
+			case 't': result += '\t'; break;
+			case 'u':
+			{
+				// Nothing a request needs is outside ASCII, so anything else is kept as a placeholder.
+				unsigned code = 0;
+				const char *digits = this->text.data() + this->position;
+				if (this->position + 4 > this->text.size()
+				    || std::from_chars(digits, digits + 4, code, 16).ptr != digits + 4)
+					return std::nullopt;
+				this->position += 4;
+				result         += code < 0x80 ? (char) code : '?';
+				break;
+			}
+			default: result += escaped;
+			}
+		}
+		return std::nullopt;
+	}
+
+	std::optional<double> parse_number()
+	{
+		this->skip_space();
+		const char *begin = this->text.data() + this->position;
+		double      value = 0;
+		const auto [end, error] = std::from_chars(begin, this->text.data() + this->text.size(), value);
+		if (error != std::errc()) return std::nullopt;
+		this->position += end - begin;
+		return value;
+	}
+
+	// Calls `read_field(key)` for every field of an object, which has to read the field's value.
+	template <typename F> bool parse_object(F &&read_field)
+	{
+		if (!this->consume('{')) return false;
+		if (this->consume('}')) return true;
+		do
+		{
+			const std::optional<std::string> key = this->parse_string();
+			if (!key.has_value() || !this->consume(':') || !read_field(key.value())) return false;
+		} while (this->consume(','));
+		return this->consume('}');
+	}
+
+	// Calls `read_element()` for every element of an array, which has to read the element.
+	template <typename F> bool parse_array(F &&read_element)
+	{
+		if (!this->consume('[')) return false;
+		if (this->consume(']')) return true;
+		do
+			if (!read_element()) return false;
+		while (this->consume(','));
+		return this->consume(']');
+	}
+
+	// Skips any value, returning its text.
+	std::optional<std::string_view> skip_value()
+	{
+		this->skip_space();
+		if (this->position == this->text.size()) return std::nullopt;
+
+		const size_t start = this->position;
+		bool         valid = false;
+		const auto   skip  = [&] { return this->skip_value().has_value(); };
+		switch (this->text[this->position])
+		{
+		case '"': valid = this->parse_string().has_value(); break;
+		case '{': valid = this->parse_object([&](const std::string &) { return skip(); }); break;
+		case '[': valid = this->parse_array(skip); break;
+		case 't': valid = this->consume_word("true"); break;
+		case 'f': valid = this->consume_word("false"); break;
+		case 'n': valid = this->consume_word("null"); break;
+		default: valid = this->parse_number().has_value();
+		}
+		if (!valid) return std::nullopt;
+		return this->text.substr(start, this->position - start);
+	}
+
+private:
+	void skip_space()
+	{
+		constexpr std::string_view SPACE = " \t\r\n";
+		while (this->position < this->text.size() && SPACE.contains(this->text[this->position])) this->position++;
+	}
+
+	bool consume_word(std::string_view word)
+	{
+		if (this->text.substr(this->position, word.size()) != word) return false;
+		this->position += word.size();
+		return true;
+	}
+};
+
+static std::string quote(std::string_view text)
+{
+	std::string quoted = "\"";
+	for (char c : text)
+	{
+		if (c == '"' || c == '\\') quoted += '\\';
+		if ((unsigned char) c < 0x20) quoted += ' ';
+		else quoted += c;
+	}
+	return quoted + '"';
+}
+
+#pragma endregion JSON
+
+#pragma region REQUESTS
+
+struct request
+{
+	// Kept as the raw JSON it was sent as, so it can be echoed back without caring what type it is.
+	std::string              id = "null";
+	std::string              command;
+	std::string              fen = START_FEN;
+	std::vector<std::string> moves;
+	search_limits            limits;
+	int64_t                  priority = 0;
+};
+
+// Returns the error to send back, or an empty string if the request is fine.
+static std::string parse_request(std::string_view line, request &parsed)
+{
+	json_parser parser(line);
+
+	// JSON numbers are doubles, and these have to be whole numbers that fit one.
+	const auto read_integer = [&](double min) -> std::optional<int64_t>
+	{
+		const std::optional<double> number = parser.parse_number();
+		if (!number.has_value() || number.value() < min || number.value() != std::floor(number.value())
+		    || std::abs(number.value()) > (double) (1LL << 53))
+			return std::nullopt;
+		return (int64_t) number.value();
+	};
+	const auto read_string = [&](std::string &value)
+	{
+		std::optional<std::string> text = parser.parse_string();
+		if (text.has_value()) value = std::move(text.value());
+		return text.has_value();
+	};
+	const auto read_limit = [&](auto &value)
+	{
+		const std::optional<int64_t> number = read_integer(0);
+		if (number.has_value()) value = std::remove_reference_t<decltype(value)>(number.value());
+		return number.has_value();
+	};
+
+	std::string error;
+	bool        has_limit  = false;
+	const auto  read_field = [&](const std::string &key)
+	{
+		bool read = false;
+		if (key == "id")
+		{
+			const std::optional<std::string_view> raw = parser.skip_value();
+			if (raw.has_value()) parsed.id = raw.value();
+			read = raw.has_value();
+		}
+		else if (key == "command") read = read_string(parsed.command);
+		else if (key == "fen") read = read_string(parsed.fen);
+		else if (key == "moves") read = parser.parse_array([&] { return read_string(parsed.moves.emplace_back()); });
+		else if (key == "depth" || key == "nodes" || key == "time")
+		{
+			uint64_t limit = 0;
+			read           = read_limit(limit);
+			has_limit      = has_limit || limit != 0;
+			if (key == "depth") parsed.limits.depth = (uint32_t) std::min<uint64_t>(limit, MAX_DEPTH);
+			else if (key == "nodes") parsed.limits.nodes = limit;
+			else parsed.limits.time = std::chrono::milliseconds(limit);
+		}
+		else if (key == "multipv") read = read_limit(parsed.limits.multipv);
+		else if (key == "priority")
+		{
+			const std::optional<int64_t> priority = read_integer(-(double) (1LL << 53));
+			if (priority.has_value()) parsed.priority = priority.value();
+			read = priority.has_value();
+		}
+		else read = parser.skip_value().has_value();
+
+		if (!read && error.empty()) error = "invalid value for " + quote(key);
+		return read;
+	};
+
+	const bool valid = parser.parse_object(read_field);
+	if (!valid || !parser.at_end()) return error.empty() ? "invalid JSON" : error;
+	// An unlimited search would hold its worker forever.
+	if (!has_limit) parsed.limits.depth = DEFAULT_DEPTH;
+	return "";
+}
+
+static std::string format_error(const std::string &id, std::string_view error)
+{
+	return "{\"id\": " + id + ", \"error\": " + quote(error) + "}";
+}
+
+static std::string format_score(eval_t score)
+{
+	if (!is_mate_score(score)) return "{\"cp\": " + std::to_string(score) + "}";
+
+	// Mate scores count plies, but like UCI the result counts moves. Negative means the side to move is getting mated.
+	const eval_t moves = (MATE_SCORE - std::abs(score) + 1) / 2;
+	return "{\"mate\": " + std::to_string(score > 0 ? moves : -moves) + "}";
+}
+
+static std::string format_result(const std::string &id, const search_result &result, Clock::duration queue_time)
+{
+	char               buffer[MAX_UCI_LENGTH];
+	std::ostringstream line;
+	line << "{\"id\": " << id << ", \"bestmove\": \"" << std::string_view(buffer, result.move.to_uci(buffer))
+	     << "\", \"depth\": " << result.depth << ", \"nodes\": " << result.nodes
+	     << ", \"time\": " << result.search_time.count()
+	     << ", \"queue_time\": " << std::chrono::duration_cast<std::chrono::milliseconds>(queue_time).count()
+	     << ", \"lines\": [";
+	for (size_t i = 0; i < result.lines.size(); i++)
+	{
+		const pv_line &pv = result.lines[i];
+		line << (i == 0 ? "" : ", ") << "{\"move\": \"" << std::string_view(buffer, pv.move.to_uci(buffer))
+		     << "\", \"score\": " << format_score(pv.score) << "}";
+	}
+	line << "]}";
+	return line.str();
+}
+
+// Finds the legal move written as `text` in long algebraic notation, like "e2e4" or "e7e8q".
+static std::optional<Move> parse_move(const Board &board, const std::string &text)
+{
+	char buffer[MAX_UCI_LENGTH];
+	for (const Move &move : generate_moves(board))
+		if (std::string_view(buffer, move.to_uci(buffer)) == text) return move;
+	return std::nullopt;
+}
+
+// Sets `board` up for the request and searches it. Returns the error to send back, or an empty string.
+static std::string analyse(Board &board, search_control &control, const request &details, search_result &result)
+{
+	if (!board.set_fen(details.fen)) return "invalid FEN " + details.fen;
+	board.update_bitboards();
+
+	for (const std::string &text : details.moves)
+	{
+		const std::optional<Move> move = parse_move(board, text);
+		if (!move.has_value()) return "illegal move " + text;
+		board.make_move(move.value());
+	}
+
+	control.stop     = false;
+	control.deadline = 0;
+	result           = search(board, details.limits, control);
+	return "";
+}
+
+#pragma endregion REQUESTS
+
+#pragma region SCHEDULING
+
+// Where a request's results go. Kept alive by the requests still waiting for results,
+// so a client that disconnects early doesn't leave them writing to nothing.
+class client
+{
+public:
+	virtual ~client() = default;
+	// Called from every worker, so it has to lock.
+	virtual void send(const std::string &line) = 0;
+};
+
+class stream_client : public client
+{
+	std::ostream &output;
+	std::mutex    output_mutex;
+
+public:
+	explicit stream_client(std::ostream &output) : output(output) {}
+
+	void send(const std::string &line) override
+	{
+		std::lock_guard<std::mutex> lock(this->output_mutex);
+		this->output << line << std::endl;
+	}
+};
+
+struct job
+{
+	request                 details;
+	std::shared_ptr<client> sender;
+	uint64_t                sequence;
+	Clock::time_point       queued;
+};
+
+// Heap order: higher priorities first, then the order requests came in.
+static bool runs_later(const job &a, const job &b)
+{
+	if (a.details.priority != b.details.priority) return a.details.priority < b.details.priority;
+	return a.sequence > b.sequence;
+}
+
+class scheduler
+{
+	std::mutex               mutex;
+	std::condition_variable  work_available;
+	std::condition_variable  idle;
+	// A heap ordered by `runs_later`.
+	std::vector<job>         queue;
+	std::vector<std::thread> workers;
+	size_t                   running       = 0;
+	uint64_t                 next_sequence = 0;
+	bool                     stopping      = false;
+
+	// Counters for `format_stats`.
+	Clock::time_point started   = Clock::now();
+	uint64_t          completed = 0;
+	uint64_t          errors    = 0;
+	uint64_t          nodes     = 0;
+	Clock::duration   total_queue_time{ 0 };
+	Clock::duration   max_queue_time{ 0 };
+
+public:
+	explicit scheduler(size_t worker_count)
+	{
+		for (size_t i = 0; i < std::max<size_t>(worker_count, 1); i++)
+			this->workers.emplace_back([this] { this->work(); });
+	}
+	// Requests still in the queue are dropped, but the ones being searched are finished first.
+	~scheduler()
+	{
+		{
+			std::lock_guard<std::mutex> lock(this->mutex);
+			this->stopping = true;
+		}
+		this->work_available.notify_all();
+		for (std::thread &worker : this->workers) worker.join();
+	}
+
+	void submit(request details, std::shared_ptr<client> sender)
+	{
+		{
+			std::lock_guard<std::mutex> lock(this->mutex);
+			this->queue.push_back(job{ std::move(details), std::move(sender), this->next_sequence++, Clock::now() });
+			std::push_heap(this->queue.begin(), this->queue.end(), runs_later);
+		}
+		this->work_available.notify_one();
+	}
+
+	// Waits until every submitted request has its result sent.
+	void wait_idle()
+	{
+		std::unique_lock<std::mutex> lock(this->mutex);
+		this->idle.wait(lock, [&] { return this->queue.empty() && this->running == 0; });
+	}
+
+	std::string format_stats()
+	{
+		std::lock_guard<std::mutex> lock(this->mutex);
+		const double seconds  = std::chrono::duration<double>(Clock::now() - this->started).count();
+		const double finished = (double) (this->completed + this->errors);
+
+		std::ostringstream line;
+		line << std::fixed << std::setprecision(1) << "{\"stats\": {\"workers\": " << this->workers.size()
+		     << ", \"queued\": " << this->queue.size() << ", \"running\": " << this->running
+		     << ", \"completed\": " << this->completed << ", \"errors\": " << this->errors
+		     << ", \"uptime\": " << (int64_t) (seconds * 1000)
+		     << ", \"positions_per_second\": " << finished / std::max(seconds, 1e-3)
+		     << ", \"nodes_per_second\": " << (double) this->nodes / std::max(seconds, 1e-3)
+		     << ", \"average_queue_time\": "
+		     << (finished == 0 ? 0.0
+		                       : std::chrono::duration<double, std::milli>(this->total_queue_time).count() / finished)
+		     << ", \"max_queue_time\": " << std::chrono::duration<double, std::milli>(this->max_queue_time).count()
+		     << "}}";
+		return line.str();
+	}
+
+private:
+	void work()
+	{
+		// Kept for the worker's whole life, so every request reuses the board's buffers, and the thread's
+		// pawn and evaluation tables stay warm from one position to the next.
+		Board          board;
+		search_control control;
+
+		std::unique_lock<std::mutex> lock(this->mutex);
+		while (true)
+		{
+			this->work_available.wait(lock, [&] { return this->stopping || !this->queue.empty(); });
+			if (this->stopping) return;
+
+			std::pop_heap(this->queue.begin(), this->queue.end(), runs_later);
+			job next = std::move(this->queue.back());
+			this->queue.pop_back();
+			this->running++;
+			lock.unlock();
+
+			const Clock::time_point start      = Clock::now();
+			const Clock::duration   queue_time = start - next.queued;
+			search_result           result;
+			const std::string       error = analyse(board, control, next.details, result);
+			next.sender->send(error.empty() ? format_result(next.details.id, result, queue_time)
+			                                : format_error(next.details.id, error));
+
+			lock.lock();
+			this->running--;
+			(error.empty() ? this->completed : this->errors)++;
+			this->nodes            += result.nodes;
+			this->total_queue_time += queue_time;
+			this->max_queue_time    = std::max(this->max_queue_time, queue_time);
+			if (this->queue.empty() && this->running == 0) this->idle.notify_all();
+		}
+	}
+};
+
+static void handle_line(scheduler &pool, const std::shared_ptr<client> &sender, std::string_view line)
+{
+	if (line.find_first_not_of(" \t\r") == std::string_view::npos) return;
+
+	request           details;
+	const std::string error = parse_request(line, details);
+	if (!error.empty()) sender->send(format_error(details.id, error));
+	else if (details.command == "stats") sender->send(pool.format_stats());
+	else if (!details.command.empty()) sender->send(format_error(details.id, "unknown command " + details.command));
+	else pool.submit(std::move(details), sender);
+}
+
+#pragma endregion SCHEDULING
+
+size_t default_workers() { return std::max<size_t>(std::thread::hardware_concurrency(), 1); }
+
+void run(std::istream &input, std::ostream &output, size_t workers)
+{
+	scheduler                     pool(workers);
+	const std::shared_ptr<client> sender = std::make_shared<stream_client>(output);
+
+	std::string line;
+	while (std::getline(input, line)) handle_line(pool, sender, line);
+	pool.wait_idle();
+}
+
+#pragma region SOCKETS
+
+#ifdef HAS_UNIX_SOCKETS
+
+class socket_client : public client
+{
+	int        socket;
+	std::mutex socket_mutex;
+
+public:
+	explicit socket_client(int socket) : socket(socket) {}
+	~socket_client() override { ::close(this->socket); }
+
+	void send(const std::string &line) override
+	{
+		const std::string           message = line + '\n';
+		std::lock_guard<std::mutex> lock(this->socket_mutex);
+		// A client that went away just doesn't get its results.
+		for (size_t sent = 0; sent < message.size();)
+		{
+			const ssize_t count = ::send(this->socket, message.data() + sent, message.size() - sent, MSG_NOSIGNAL);
+			if (count <= 0) return;
+			sent += count;
+		}
+	}
+
+	// Reads requests until the client disconnects or `close` is called.
+	void read_requests(scheduler &pool, const std::shared_ptr<client> &self)
+	{
+		std::string pending;
+		char        buffer[4096];
+		ssize_t     count;
+		while ((count = ::recv(this->socket, buffer, sizeof(buffer), 0)) > 0)
+		{
+			pending.append(buffer, count);
+			size_t line_start = 0;
+			for (size_t end; (end = pending.find('\n', line_start)) != std::string::npos; line_start = end + 1)
+				handle_line(pool, self, std::string_view(pending).substr(line_start, end - line_start));
+			pending.erase(0, line_start);
+		}
+	}
+
+	void close() { ::shutdown(this->socket, SHUT_RDWR); }
+};
+
+struct connection
+{
+	std::shared_ptr<socket_client>     client;
+	std::thread                        reader;
+	std::shared_ptr<std::atomic<bool>> finished = std::make_shared<std::atomic<bool>>(false);
+};
+
+static void read_connection(scheduler                         &pool,
+                            std::shared_ptr<socket_client>     client,
+                            std::shared_ptr<std::atomic<bool>> finished)
+{
+	client->read_requests(pool, client);
+	*finished = true;
+}
+
+bool serve(const std::string &path, size_t workers)
+{
+	sockaddr_un address{};
+	address.sun_family = AF_UNIX;
+	if (path.empty() || path.size() >= sizeof(address.sun_path)) return false;
+	std::copy(path.begin(), path.end(), address.sun_path);
+
+	const int listener = ::socket(AF_UNIX, SOCK_STREAM, 0);
+	if (listener < 0) return false;
+	// A socket file left behind by an earlier run would make `bind` fail.
+	(void) ::unlink(path.c_str());
+	if (::bind(listener, reinterpret_cast<const sockaddr *>(&address), sizeof(address)) != 0
+	    || ::listen(listener, SOMAXCONN) != 0)
+	{
+		::close(listener);
+		return false;
+	}
+
+	// All clients share the workers, so one client's batch can't starve another's high priority requests.
+	scheduler               pool(workers);
+	std::vector<connection> connections;
+	while (true)
+	{
+		const int socket = ::accept(listener, nullptr, nullptr);
+		if (socket < 0)
+		{
+			if (errno == EINTR) continue;
+			break;
+		}
+
+		// Clients come and go, so the threads of the ones that left are cleaned up as new ones arrive.
+		std::erase_if(connections,
+		              [](connection &old)
+		              {
+			              if (!old.finished->load()) return false;
+			              old.reader.join();
+			              return true;
+		              });
+
+		connection &added = connections.emplace_back();
+		added.client      = std::make_shared<socket_client>(socket);
+		added.reader      = std::thread(read_connection, std::ref(pool), added.client, added.finished);
+	}
+
+	for (connection &open : connections)
+	{
+		open.client->close();
+		open.reader.join();
+	}
+	::close(listener);
+	return false;
+}
+
+#else
+
+bool serve(const std::string &, size_t) { return false; }
+
+#endif
+
+#pragma endregion SOCKETS
+
+} // namespace analysis
\ No newline at end of file
@@ -0,0 +1,125 @@
+#include "binary_position.hpp"
+
+#include "board.hpp"
+#include "pieces.hpp"
+
+#include <algorithm>
+#include <bit>
+
+namespace binary
+{
+
+static_assert(std::endian::native == std::endian::little, "Binary positions are read in place as little-endian.");
+
+constexpr uint8_t BLACK_PIECE = 8;
+
+std::span<const position> positions(const mapped_file &file)
+{
+	return { reinterpret_cast<const position *>(file.data()), file.size() / sizeof(position) };
+}
+
+writer::writer(const std::string &path, bool append)
+    : stream(path, std::ios::binary | (append ? std::ios::app : std::ios::trunc))
+{
+	this->buffer.reserve(CHUNK_POSITIONS);
+}
+
+void writer::write(const position &pos)
+{
+	this->buffer.push_back(pos);
+	if (this->buffer.size() == CHUNK_POSITIONS) this->flush();
+}
+
+void writer::flush()
+{
+	if (this->buffer.empty()) return;
+	this->stream.write(reinterpret_cast<const char *>(this->buffer.data()), this->buffer.size() * sizeof(position));
+	this->stream.flush();
+	this->buffer.clear();
+}
+
+reader::reader(const std::string &path) : stream(path, std::ios::binary) {}
+
+bool reader::read(position &pos)
+{
+	if (this->next == this->buffer.size())
+	{
+		this->buffer.resize(CHUNK_POSITIONS);
+		this->stream.read(reinterpret_cast<char *>(this->buffer.data()), CHUNK_POSITIONS * sizeof(position));
+		this->buffer.resize(this->stream.gcount() / sizeof(position));
+		this->next = 0;
+		if (this->buffer.empty()) return false;
+	}
+
+	pos = this->buffer[this->next++];
+	return true;
+}
+
+} // namespace binary
+
+bool Board::set_packed(const binary::position &packed)
+{
+	this->_clear();
+
+	if (std::popcount(packed.occupancy) > 32) return false;
+	size_t index = 0;
+	for (uint64_t occupied = packed.occupancy; occupied != 0; occupied &= occupied - 1, index++)
+	{
+		const uint8_t code = (packed.pieces[index / 2] >> (index % 2 * 4)) & 0xf;
+		const uint8_t type = code & ~binary::BLACK_PIECE;
+		if (type == (uint8_t) PieceType::NONE || type >= (uint8_t) PieceType::MAX_TYPE) return false;
+
+		Piece piece;
+		piece.position(std::countr_zero(occupied));
+		piece.set_color(code & binary::BLACK_PIECE ? BLACK : WHITE);
+		piece.set_piece((PieceType) type);
+		this->add_piece(piece);
+	}
+	if (!this->_has_valid_pieces()) return false;
+
+	this->rights[WHITE].kingside  = packed.flags & binary::WHITE_KINGSIDE;
+	this->rights[WHITE].queenside = packed.flags & binary::WHITE_QUEENSIDE;
+	this->rights[BLACK].kingside  = packed.flags & binary::BLACK_KINGSIDE;
+	this->rights[BLACK].queenside = packed.flags & binary::BLACK_QUEENSIDE;
+
+	if (packed.en_passant != binary::NO_SQUARE)
+	{
+		if (packed.en_passant > 63) return false;
+		this->en_passant_target = packed.en_passant;
+	}
+	if (packed.move_number == 0) return false;
+
+	this->fifty_move_clock = packed.fifty_move_clock;
+	this->halfmove         = (packed.move_number - 1) * 2 + (packed.flags & binary::BLACK_TO_MOVE ? 1 : 0);
+	this->hash             = this->generate_hash();
+	return true;
+}
+
+binary::position Board::to_packed() const
+{
+	binary::position packed;
+
+	size_t index = 0;
+	for (uint8_t square = 0; square < 64; square++)
+	{
+		const piece_set_t::const_iterator piece = this->piece_board[square];
+		if (piece == piece_set_t::const_iterator{}) continue;
+
+		const uint8_t color_bit   = piece->get_color() == BLACK ? binary::BLACK_PIECE : 0;
+		const uint8_t code        = (uint8_t) piece->get_type() | color_bit;
+		packed.occupancy         |= 1ULL << square;
+		packed.pieces[index / 2] |= code << (index % 2 * 4);
+		index++;
+	}
+
+	if (this->turn_to_move() == BLACK) packed.flags |= binary::BLACK_TO_MOVE;
+	if (this->rights[WHITE].kingside) packed.flags |= binary::WHITE_KINGSIDE;
+	if (this->rights[WHITE].queenside) packed.flags |= binary::WHITE_QUEENSIDE;
+	if (this->rights[BLACK].kingside) packed.flags |= binary::BLACK_KINGSIDE;
+	if (this->rights[BLACK].queenside) packed.flags |= binary::BLACK_QUEENSIDE;
+
+	if (this->can_en_passant()) packed.en_passant = this->en_passant_target;
+	packed.fifty_move_clock = std::min<uint16_t>(this->fifty_move_clock, UINT8_MAX);
+	packed.move_number      = std::min<uint32_t>(this->halfmove / 2 + 1, UINT16_MAX);
+	return packed;
+}
\ No newline at end of file
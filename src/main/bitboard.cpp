@@ -4,6 +4,7 @@
 #include "move.hpp"
 #include "move_generation.hpp"
 #include "pieces.hpp"
+#include <bit>
 #include <cassert>
 #include <cstddef>
 #include <sstream>
@@ -29,14 +30,14 @@ bitboard generate_piece_board(const piece_set_t::PieceList &list)
 // 	return board;
 // }
 
-piece_boards generate_piece_boards(const Board &state, color_t color)
+piece_boards generate_piece_boards(const Board &state, color_t color, attack_boards &attacks)
 {
 	const piece_set_t &set = state.pieces[(size_t) color];
 
 	piece_boards pieces = { generate_piece_board(set.pawns),   generate_piece_board(set.knights),
 		                    generate_piece_board(set.bishops), generate_piece_board(set.rooks),
 		                    generate_piece_board(set.queens),  generate_piece_board(set.kings) };
-	pieces.visible = generate_piece_visibility(set, color, state.get_bitboards());
+	pieces.visible = generate_piece_visibility(set, color, state.get_bitboards(), attacks);
 	pieces.calculate_combined();
 	return pieces;
 }
@@ -123,41 +124,46 @@ bitboard generate_king_visibility(const Piece &king)
 	return moves;
 }
 
-bitboard generate_piece_visibility(const piece_set_t &piece_set, color_t color, const full_set &old_boards)
+bitboard generate_piece_visibility(const piece_set_t &piece_set,
+                                   color_t            color,
+                                   const full_set    &old_boards,
+                                   attack_boards     &attacks)
 {
 	const piece_boards &our_bb_set   = old_boards[color].pieces;
 	const piece_boards &enemy_bb_set = old_boards[invert_color(color)].pieces;
 
 	bitboard break_board = (our_bb_set.all_pieces | enemy_bb_set.all_pieces) & ~enemy_bb_set.kings;
-	bitboard visibility  = generate_king_visibility(piece_set.kings.front());
+
+	attacks                                   = attack_boards{};
+	attacks.by_type[(size_t) PieceType::KING] = generate_king_visibility(piece_set.kings.front());
 
 	for (auto &queen : piece_set.queens)
 	{
 		assert(queen.get_type() == PieceType::QUEEN && "Piece type mismatch in queen piece set.");
-		visibility |= generate_queen_visibility(queen, break_board);
+		attacks.add(PieceType::QUEEN, generate_queen_visibility(queen, break_board));
 	}
 	for (auto &rook : piece_set.rooks)
 	{
 		assert(rook.get_type() == PieceType::ROOK && "Piece type mismatch in rook piece set.");
-		visibility |= generate_rook_visibility(rook, break_board);
+		attacks.add(PieceType::ROOK, generate_rook_visibility(rook, break_board));
 	}
 	for (auto &bishop : piece_set.bishops)
 	{
 		assert(bishop.get_type() == PieceType::BISHOP && "Piece type mismatch in bishop piece set.");
-		visibility |= generate_bishop_visibility(bishop, break_board);
+		attacks.add(PieceType::BISHOP, generate_bishop_visibility(bishop, break_board));
 	}
 	for (auto &knight : piece_set.knights)
 	{
 		assert(knight.get_type() == PieceType::KNIGHT && "Piece type mismatch in knight piece set.");
-		visibility |= generate_knight_visibility(knight);
+		attacks.add(PieceType::KNIGHT, generate_knight_visibility(knight));
 	}
 	for (auto &pawn : piece_set.pawns)
 	{
 		assert(pawn.get_type() == PieceType::PAWN && "Piece type mismatch in pawn piece set.");
-		visibility |= generate_pawn_visibility(pawn);
+		attacks.by_type[(size_t) PieceType::PAWN] |= generate_pawn_visibility(pawn);
 	}
 
-	return visibility;
+	return std::reduce(attacks.by_type.begin(), attacks.by_type.end(), bitboard(0), std::bit_or<bitboard>());
 }
 
 #pragma endregion Piece_Visibility
@@ -168,13 +174,13 @@ void generate_checks_for_pawn(const Piece &pawn, const Piece &enemy_king, threat
 {
 	bitboard captures = PAWN_CAPTURES[pawn.get_color()][pawn.position()];
 
-	if (captures.test(enemy_king.position())) threats.checks.boards.push_back(bitboard().set(pawn.position()));
+	if (captures.test(enemy_king.position())) threats.checks.push_back(bitboard().set(pawn.position()));
 }
 
 void generate_checks_for_knight(const Piece &knight, const Piece &enemy_king, threat_boards &threats)
 {
 	if (KNIGHT_MOVES[knight.position()].test(enemy_king.position()))
-		threats.checks.boards.push_back(bitboard().set(knight.position()));
+		threats.checks.push_back(bitboard().set(knight.position()));
 }
 
 // Returns `true` if the line is a check, and `false` when it's a pin.
@@ -235,8 +241,8 @@ void generate_threats_for_bishop(const Piece   &bishop,
 		                                        squares_to_edge[i]);
 
 		if (line.line.none()) continue;
-		if (line.is_check) threats.checks.boards.push_back(line.line);
-		else threats.pins.boards.push_back(line.line);
+		if (line.is_check) threats.checks.push_back(line.line);
+		else threats.pins.push_back(line.line);
 	}
 }
 
@@ -259,8 +265,8 @@ void generate_threats_for_rook(const Piece   &rook,
 		                                          squares_to_edge[i]);
 
 		if (threat.line.none()) continue;
-		if (threat.is_check) threats.checks.boards.push_back(threat.line);
-		else threats.pins.boards.push_back(threat.line);
+		if (threat.is_check) threats.checks.push_back(threat.line);
+		else threats.pins.push_back(threat.line);
 	}
 }
 
@@ -295,26 +301,78 @@ threat_boards generate_threat_lines(const Board &state, color_t color, const ful
 	return threats;
 }
 
+check_squares generate_check_squares(const full_set &boards, color_t color)
+{
+	const piece_boards &ours   = boards[color].pieces;
+	const piece_boards &theirs = boards[invert_color(color)].pieces;
+	const bitboard      all    = ours.all_pieces | theirs.all_pieces;
+
+	check_squares checks{};
+	checks.enemy_king = std::countr_zero(theirs.kings.to_ullong());
+	assert(checks.enemy_king < 64 && "Enemy king missing.");
+
+	const std::array<size_t, 8> &squares_to_edge = NUM_SQUARES_TO_EDGE[checks.enemy_king];
+
+	// Walk outwards from the enemy king. Everything up to the first blocker is a checking square for sliders,
+	// and if that blocker is ours with one of our matching sliders right behind it, it's a discovered check candidate.
+	for (size_t i = 0; i < DIRECTION_OFFSETS.size(); i++)
+	{
+		const bool diagonal = i >= 4;
+		bitboard  &line     = checks.squares[(size_t) (diagonal ? PieceType::BISHOP : PieceType::ROOK)];
+		bitboard   sliders  = (diagonal ? ours.bishops : ours.rooks) | ours.queens;
+		int        blocker  = -1;
+		int        to       = checks.enemy_king;
+
+		for (size_t step = 0; step < squares_to_edge[i]; step++)
+		{
+			to += (int) DIRECTION_OFFSETS[i];
+			if (blocker == -1) line.set(to);
+			if (!all.test(to)) continue;
+
+			if (blocker != -1)
+			{
+				if (sliders.test(to)) checks.discovered.set(blocker);
+				break;
+			}
+			if (!ours.all_pieces.test(to)) break;
+			blocker = to;
+		}
+	}
+
+	checks.squares[(size_t) PieceType::PAWN]   = PAWN_CAPTURES[invert_color(color)][checks.enemy_king];
+	checks.squares[(size_t) PieceType::KNIGHT] = KNIGHT_MOVES[checks.enemy_king];
+	checks.squares[(size_t) PieceType::QUEEN]  = checks.squares[(size_t) PieceType::BISHOP]
+	                                            | checks.squares[(size_t) PieceType::ROOK];
+
+	return checks;
+}
+
 #pragma endregion Checks
 
 #pragma region Sets
 
 single_set generate_single_set(const Board &state, color_t color)
 {
-	return {
-		generate_piece_boards(state, color),
-		generate_threat_lines(state, color, state.get_bitboards())
-	};
+	single_set set{};
+	set.pieces  = generate_piece_boards(state, color, set.attacks);
+	set.threats = generate_threat_lines(state, color, state.get_bitboards());
+	return set;
 }
 
 full_set generate_full_set(const Board &state)
 {
 	full_set new_set{};
-	new_set[WHITE].pieces = generate_piece_boards(state, WHITE);
-	new_set[BLACK].pieces = generate_piece_boards(state, BLACK);
+	new_set[WHITE].pieces = generate_piece_boards(state, WHITE, new_set[WHITE].attacks);
+	new_set[BLACK].pieces = generate_piece_boards(state, BLACK, new_set[BLACK].attacks);
 
-	new_set[WHITE].pieces.visible = generate_piece_visibility(state.pieces[WHITE], WHITE, new_set);
-	new_set[BLACK].pieces.visible = generate_piece_visibility(state.pieces[BLACK], BLACK, new_set);
+	// The first pass saw the old boards, so the visibility has to be redone with the new ones.
+	for (color_t color : { WHITE, BLACK })
+	{
+		new_set[color].pieces.visible = generate_piece_visibility(state.pieces[color],
+		                                                          color,
+		                                                          new_set,
+		                                                          new_set[color].attacks);
+	}
 
 	new_set[WHITE].threats = generate_threat_lines(state, WHITE, new_set);
 	new_set[BLACK].threats = generate_threat_lines(state, BLACK, new_set);
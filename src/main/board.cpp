@@ -7,9 +7,12 @@
 #include <array>
 #include <cassert>
 #include <cstdint>
+#include <iterator>
 #include <sstream>
 #include <stdexcept>
 
+namespace piece_tables = evaluation::hce::piece_tables;
+
 void Board::_setup_piece_iterators()
 {
 	// pieces[this->pieces[WHITE].kings.front().position()] = this->pieces[WHITE].kings.begin();
@@ -45,18 +48,24 @@ void Board::_setup_piece_iterators()
 
 Board::Board(const Board &b) :
     // pieces_setup(false),
-    piece_board({}), pieces(b.pieces), rights(b.rights), moves(b.moves), halfmove(b.halfmove),
-    fifty_move_clock(b.fifty_move_clock), en_passant_target(b.en_passant_target), bitboards(b.bitboards),
-    history(b.history)
+    piece_board({}), moves(b.moves), history(b.history), hash_history(b.hash_history),
+    derived_history(b.derived_history), accumulator_history(b.accumulator_history), bitboards(b.bitboards),
+    pieces(b.pieces), halfmove(b.halfmove), fifty_move_clock(b.fifty_move_clock), plies_from_null(b.plies_from_null),
+    en_passant_target(b.en_passant_target), rights(b.rights), _in_check(b._in_check), check_info(b.check_info),
+    hash(b.hash), pawn_hash(b.pawn_hash), packed_material(b.packed_material), accumulator(b.accumulator)
 {
 	this->_setup_piece_iterators();
 }
 
-Board::Board(const Board &&b) :
+Board::Board(Board &&b) :
     // pieces_setup(false),
-    piece_board(std::move(b.piece_board)), pieces(std::move(b.pieces)), rights(std::move(b.rights)),
-    moves(std::move(b.moves)), halfmove(b.halfmove), fifty_move_clock(b.fifty_move_clock),
-    en_passant_target(b.en_passant_target), bitboards(std::move(b.bitboards)), history(std::move(b.history))
+    piece_board(std::move(b.piece_board)), moves(std::move(b.moves)), history(std::move(b.history)),
+    hash_history(std::move(b.hash_history)), derived_history(std::move(b.derived_history)),
+    accumulator_history(std::move(b.accumulator_history)), bitboards(std::move(b.bitboards)),
+    pieces(std::move(b.pieces)), halfmove(b.halfmove), fifty_move_clock(b.fifty_move_clock),
+    plies_from_null(b.plies_from_null), en_passant_target(b.en_passant_target), rights(std::move(b.rights)),
+    _in_check(b._in_check), check_info(b.check_info), hash(b.hash), pawn_hash(b.pawn_hash),
+    packed_material(b.packed_material), accumulator(b.accumulator)
 {
 }
 
@@ -72,17 +81,30 @@ Board &Board::operator=(const Board &b)
 	this->fifty_move_clock  = b.fifty_move_clock;
 	this->en_passant_target = b.en_passant_target;
 
-	this->moves   = b.moves;
-	this->history = b.history;
+	this->moves           = b.moves;
+	this->history         = b.history;
+	this->hash_history    = b.hash_history;
+	this->derived_history = b.derived_history;
+	this->_in_check       = b._in_check;
+	this->check_info      = b.check_info;
+	this->hash            = b.hash;
+	this->pawn_hash       = b.pawn_hash;
+	this->packed_material = b.packed_material;
+	this->plies_from_null = b.plies_from_null;
+
+	this->accumulator         = b.accumulator;
+	this->accumulator_history = b.accumulator_history;
 
 	this->rights = b.rights;
 
+	// Squares that are empty in `b` could still point at this board's old pieces.
+	this->piece_board.fill(piece_set_t::iterator{});
 	this->_setup_piece_iterators();
 
 	return *this;
 }
 
-Board &Board::operator=(const Board &&b)
+Board &Board::operator=(Board &&b)
 {
 	if (this == &b) return *this;
 
@@ -95,8 +117,19 @@ Board &Board::operator=(const Board &&b)
 	this->fifty_move_clock  = b.fifty_move_clock;
 	this->en_passant_target = b.en_passant_target;
 
-	this->moves   = std::move(b.moves);
-	this->history = std::move(b.history);
+	this->moves           = std::move(b.moves);
+	this->history         = std::move(b.history);
+	this->hash_history    = std::move(b.hash_history);
+	this->derived_history = std::move(b.derived_history);
+	this->_in_check       = b._in_check;
+	this->check_info      = b.check_info;
+	this->hash            = b.hash;
+	this->pawn_hash       = b.pawn_hash;
+	this->packed_material = b.packed_material;
+	this->plies_from_null = b.plies_from_null;
+
+	this->accumulator         = b.accumulator;
+	this->accumulator_history = std::move(b.accumulator_history);
 
 	this->rights = std::move(b.rights);
 
@@ -126,35 +159,30 @@ std::string Board::to_string() const
 
 void Board::add_piece(Piece piece)
 {
-	color_t color = piece.get_color();
-	// These lines are really long. Should maybe look for a better way to do this
+	color_t color          = piece.get_color();
+	this->packed_material += piece_tables::packed_value(piece);
+	this->pawn_hash       ^= zobrist::pawn_key(piece);
+
+	piece_set_t::PieceList *list = nullptr;
 	switch (piece.get_type())
 	{
-	case PieceType::PAWN:
-		this->piece_board.at(piece.position()) = this->pieces[color].pawns.insert(this->pieces[color].pawns.end(),
-		                                                                          piece);
-		break;
-	case PieceType::KNIGHT:
-		this->piece_board.at(piece.position()) = this->pieces[color].knights.insert(this->pieces[color].knights.end(),
-		                                                                            piece);
-		break;
-	case PieceType::BISHOP:
-		this->piece_board.at(piece.position()) = this->pieces[color].bishops.insert(this->pieces[color].bishops.end(),
-		                                                                            piece);
-		break;
-	case PieceType::ROOK:
-		this->piece_board.at(piece.position()) = this->pieces[color].rooks.insert(this->pieces[color].rooks.end(),
-		                                                                          piece);
-		break;
-	case PieceType::QUEEN:
-		this->piece_board.at(piece.position()) = this->pieces[color].queens.insert(this->pieces[color].queens.end(),
-		                                                                           piece);
-		break;
-	case PieceType::KING:
-		this->piece_board.at(piece.position()) = this->pieces[color].kings.insert(this->pieces[color].kings.end(),
-		                                                                          piece);
-		break;
-	default: this->piece_board.at(piece.position()) = piece_set_t::iterator{};
+	case PieceType::PAWN:   list = &this->pieces[color].pawns; break;
+	case PieceType::KNIGHT: list = &this->pieces[color].knights; break;
+	case PieceType::BISHOP: list = &this->pieces[color].bishops; break;
+	case PieceType::ROOK:   list = &this->pieces[color].rooks; break;
+	case PieceType::QUEEN:  list = &this->pieces[color].queens; break;
+	case PieceType::KING:   list = &this->pieces[color].kings; break;
+	default:
+		this->piece_board.at(piece.position()) = piece_set_t::iterator{};
+		return;
+	}
+
+	if (this->spare_pieces.empty()) this->piece_board.at(piece.position()) = list->insert(list->end(), piece);
+	else
+	{
+		list->splice(list->end(), this->spare_pieces, this->spare_pieces.begin());
+		list->back()                           = piece;
+		this->piece_board.at(piece.position()) = std::prev(list->end());
 	}
 }
 
@@ -173,6 +201,12 @@ inline bitboard::bitboard &get_piece_bitboard(bitboard::single_set &set, Piece p
 	}
 }
 
+inline uint8_t pack_castling_rights(const std::array<Board::CastlingRights, 2> &rights)
+{
+	return rights[WHITE].kingside | rights[WHITE].queenside << 1 | rights[BLACK].kingside << 2
+	       | rights[BLACK].queenside << 3;
+}
+
 bool in_check(const Board *state)
 {
 	color_t                     c         = state->turn_to_move();
@@ -226,12 +260,13 @@ void Board::_handle_castling_rights(Move                       &m,
 		if (from_piece->position() == our_test_positions.queenside) our_rights.queenside = false;
 		else if (from_piece->position() == our_test_positions.kingside) our_rights.kingside = false;
 	}
-	else if (rook_captured)
+	// A capturing rook or king can take a rook on its home square, so these aren't exclusive with the others.
+	if (rook_captured)
 	{
 		if (target_piece->position() == enemy_test_positions.queenside) enemy_rights.queenside = false;
 		else if (target_piece->position() == enemy_test_positions.kingside) enemy_rights.kingside = false;
 	}
-	else if (*from_piece == PieceType::KING)
+	if (*from_piece == PieceType::KING)
 	{
 		our_rights.kingside  = false;
 		our_rights.queenside = false;
@@ -394,7 +429,41 @@ void Board::make_move(Move m)
 	old_state.rights            = this->rights;
 	old_state.en_passant_target = this->en_passant_target;
 	old_state.fifty_move_clock  = this->fifty_move_clock;
+	old_state.plies_from_null   = this->plies_from_null;
 	if (target_piece != piece_set_t::null_iterator) old_state.captured_piece = *target_piece;
+	this->derived_history.push_back(
+	    { this->bitboards, this->check_info, this->packed_material, this->pawn_hash, this->_in_check });
+	this->hash_history.push_back(this->hash);
+
+	evaluation::nnue::delta nnue_delta;
+
+	// The moving piece is hashed out here, and hashed back in at its destination (with its promoted type) below.
+	zobrist::hash_t new_hash  = this->hash ^ zobrist::side_key(current_color) ^ zobrist::side_key(other_color);
+	new_hash                 ^= zobrist::castling_key(pack_castling_rights(this->rights));
+	new_hash                 ^= zobrist::en_passant_key(this->en_passant_target);
+	new_hash                 ^= zobrist::piece_key(*from_piece);
+	this->packed_material    -= piece_tables::packed_value(*from_piece);
+	this->pawn_hash          ^= zobrist::pawn_key(*from_piece);
+	nnue_delta.remove(*from_piece);
+	if (m.is_capture() && target_piece != piece_set_t::null_iterator)
+	{
+		new_hash              ^= zobrist::piece_key(*target_piece);
+		this->packed_material -= piece_tables::packed_value(*target_piece);
+		this->pawn_hash       ^= zobrist::pawn_key(*target_piece);
+		nnue_delta.remove(*target_piece);
+	}
+	if (is_castle_move)
+	{
+		const bool    kingside   = flags == move_flags::KINGSIDE_CASTLE;
+		const uint8_t rook_from  = from_square + (kingside ? KINGSIDE_CASTLE_PIECE_OFFSET : QUEENSIDE_CASTLE_PIECE_OFFSET);
+		const uint8_t rook_to    = to_square + (kingside ? KINGSIDE_CASTLE_END_OFFSET : QUEENSIDE_CASTLE_END_OFFSET);
+		new_hash                ^= zobrist::piece_key(PieceType::ROOK, current_color, rook_from);
+		new_hash                ^= zobrist::piece_key(PieceType::ROOK, current_color, rook_to);
+		this->packed_material   -= piece_tables::packed_value(PieceType::ROOK, current_color, rook_from);
+		this->packed_material   += piece_tables::packed_value(PieceType::ROOK, current_color, rook_to);
+		nnue_delta.remove(Piece(PieceType::ROOK, current_color, rook_from));
+		nnue_delta.add(Piece(PieceType::ROOK, current_color, rook_to));
+	}
 
 	this->en_passant_target = -1;
 
@@ -408,36 +477,59 @@ void Board::make_move(Move m)
 	_move_piece(from_square, to_square, from_piece, set);
 
 	this->moves.push_back(m);
-	this->history.push(std::move(old_state));
+	this->history.push_back(old_state);
 	this->halfmove++;
+	this->plies_from_null++;
 	// due to moves like en passant where to_piece is not necessarily on the same square as
 	// the target square, we cannot rely on the to_piece iterator to be accurate here.
 	// We can't use from_piece either, because it also gets zeroed in _move_piece.
 	if (m.is_capture() || m.is_promotion() || *to_piece == PieceType::PAWN) this->fifty_move_clock = 0;
 	else this->fifty_move_clock++;
 
+	new_hash              ^= zobrist::piece_key(*to_piece);
+	new_hash              ^= zobrist::castling_key(pack_castling_rights(this->rights));
+	new_hash              ^= zobrist::en_passant_key(this->en_passant_target);
+	this->hash             = new_hash;
+	this->packed_material += piece_tables::packed_value(*to_piece);
+	this->pawn_hash       ^= zobrist::pawn_key(*to_piece);
+	nnue_delta.add(*to_piece);
+
 	const piece_set_t &current_pieces = this->pieces[current_color];
 	const piece_set_t &enemy_pieces   = this->pieces[other_color];
 
-	set.pieces.visible       = bitboard::generate_piece_visibility(current_pieces, current_color, this->bitboards);
-	other_set.pieces.visible = bitboard::generate_piece_visibility(enemy_pieces, other_color, this->bitboards);
+	set.pieces.visible       = bitboard::generate_piece_visibility(current_pieces,
+	                                                               current_color,
+	                                                               this->bitboards,
+	                                                               set.attacks);
+	other_set.pieces.visible = bitboard::generate_piece_visibility(enemy_pieces,
+	                                                               other_color,
+	                                                               this->bitboards,
+	                                                               other_set.attacks);
 	set.threats              = bitboard::generate_threat_lines(*this, current_color, this->bitboards);
 	other_set.threats        = bitboard::generate_threat_lines(*this, other_color, this->bitboards);
 	this->_in_check          = in_check(this);
+	this->check_info         = bitboard::generate_check_squares(this->bitboards, other_color);
+
+	if (evaluation::nnue::is_loaded())
+	{
+		this->accumulator_history.push_back(this->accumulator);
+		evaluation::nnue::update(this->accumulator, nnue_delta, *this);
+	}
 }
 
 // FIXME: Pawn list grows after undoing an en passant, causing mayhem in the move generator.
 
 void Board::unmake_move()
 {
-	IrreversableState last_state = this->history.top();
+	IrreversableState last_state = this->history.back();
 	Move              last_move  = this->moves.back();
-	this->history.pop();
+	this->history.pop_back();
 	this->moves.pop_back();
 
 	this->rights = last_state.rights;
 	this->en_passant_target     = last_state.en_passant_target;
 	this->fifty_move_clock      = last_state.fifty_move_clock;
+	this->plies_from_null       = last_state.plies_from_null;
 	Piece captured              = last_state.captured_piece;
 
 	this->halfmove--;
@@ -464,18 +556,201 @@ void Board::unmake_move()
 	                      || last_move.get_flags() == move_flags::QUEENSIDE_CASTLE;
 	if (is_castle_move) _handle_undo_castling(last_move, last_move.get_flags() == move_flags::KINGSIDE_CASTLE);
 
-	const piece_set_t &current_pieces = this->pieces[current_color];
-	const piece_set_t &enemy_pieces   = this->pieces[other_color];
+	// The piece bitboards were already put back above, so the snapshot just needs to restore
+	// the visibility and threat boards that make_move derived from them.
+	const DerivedState &last_derived = this->derived_history.back();
+	this->bitboards                  = last_derived.bitboards;
+	this->check_info                 = last_derived.check_info;
+	this->packed_material            = last_derived.packed_material;
+	this->pawn_hash                  = last_derived.pawn_hash;
+	this->_in_check                  = last_derived.in_check;
+	this->derived_history.pop_back();
+	this->hash = this->hash_history.back();
+	this->hash_history.pop_back();
+
+	if (!this->accumulator_history.empty())
+	{
+		this->accumulator = this->accumulator_history.back();
+		this->accumulator_history.pop_back();
+	}
+}
 
-	set.pieces.visible       = bitboard::generate_piece_visibility(current_pieces, current_color, this->bitboards);
-	other_set.pieces.visible = bitboard::generate_piece_visibility(enemy_pieces, other_color, this->bitboards);
-	set.threats              = bitboard::generate_threat_lines(*this, current_color, this->bitboards);
-	other_set.threats        = bitboard::generate_threat_lines(*this, other_color, this->bitboards);
-	this->_in_check          = in_check(this);
+void Board::make_null_move()
+{
+	assert(!this->_in_check && "Cannot pass while in check.");
+
+	IrreversableState old_state;
+	old_state.rights            = this->rights;
+	old_state.en_passant_target = this->en_passant_target;
+	old_state.fifty_move_clock  = this->fifty_move_clock;
+	old_state.plies_from_null   = this->plies_from_null;
+
+	this->derived_history.push_back(
+	    { this->bitboards, this->check_info, this->packed_material, this->pawn_hash, this->_in_check });
+	this->hash_history.push_back(this->hash);
+	this->history.push_back(old_state);
+	this->moves.push_back(Move());
+
+	this->hash              ^= zobrist::side_key(BLACK) ^ zobrist::en_passant_key(this->en_passant_target);
+	this->en_passant_target  = -1;
+	this->fifty_move_clock++;
+	this->plies_from_null = 0;
+	this->halfmove++;
+
+	// No piece moved, so the visibility and threat boards of both sides are still valid.
+	// Only the side-relative state needs updating.
+	this->_in_check  = in_check(this);
+	this->check_info = bitboard::generate_check_squares(this->bitboards, this->turn_to_move());
+}
+
+void Board::unmake_null_move()
+{
+	assert(!this->moves.empty() && this->moves.back().is_none() && "Last move was not a null move.");
+
+	const IrreversableState &last_state   = this->history.back();
+	const DerivedState      &last_derived = this->derived_history.back();
+
+	this->rights            = last_state.rights;
+	this->en_passant_target = last_state.en_passant_target;
+	this->fifty_move_clock  = last_state.fifty_move_clock;
+	this->plies_from_null   = last_state.plies_from_null;
+	this->bitboards         = last_derived.bitboards;
+	this->check_info        = last_derived.check_info;
+	this->_in_check         = last_derived.in_check;
+	this->hash              = this->hash_history.back();
+	this->halfmove--;
+
+	this->history.pop_back();
+	this->derived_history.pop_back();
+	this->hash_history.pop_back();
+	this->moves.pop_back();
+}
+
+void Board::update_bitboards()
+{
+	this->bitboards  = bitboard::generate_full_set(*this);
+	this->_in_check  = in_check(this);
+	this->check_info = bitboard::generate_check_squares(this->bitboards, this->turn_to_move());
+	if (evaluation::nnue::is_loaded()) evaluation::nnue::refresh(this->accumulator, *this);
+}
+
+// True if `square` lies on the line through `a` and `b`. `a` and `b` must share a rank, file or diagonal.
+inline bool on_line(uint8_t a, uint8_t b, uint8_t square)
+{
+	const int file_ab = (int) get_file_from_square(b) - (int) get_file_from_square(a);
+	const int rank_ab = (int) get_rank_from_square(b) - (int) get_rank_from_square(a);
+	const int file_as = (int) get_file_from_square(square) - (int) get_file_from_square(a);
+	const int rank_as = (int) get_rank_from_square(square) - (int) get_rank_from_square(a);
+	return file_ab * rank_as == rank_ab * file_as;
+}
+
+bool Board::gives_check(Move m) const
+{
+	const color_t                 us    = this->turn_to_move();
+	const uint16_t                from  = m.get_from();
+	const uint16_t                to    = m.get_to();
+	const uint16_t                flags = m.get_flags();
+	const uint8_t                 king  = this->check_info.enemy_king;
+	const bitboard::piece_boards &ours  = this->bitboards[us].pieces;
+
+	piece_set_t::const_iterator piece = this->piece_board[from];
+	assert(piece != piece_set_t::null_iterator && "Move does not start on a piece.");
+
+	// Direct check. Promotions are handled below, since the promoted piece could be looking through `from`.
+	if (!m.is_promotion() && this->check_info.squares[(size_t) piece->get_type()].test(to)) return true;
+
+	// Discovered check by moving a blocker off its line to the enemy king.
+	if (this->check_info.discovered.test(from) && !on_line(from, king, to)) return true;
+
+	bitboard::bitboard occupied = ours.all_pieces | this->bitboards[invert_color(us)].pieces.all_pieces;
+	occupied.reset(from);
+
+	if (m.is_promotion())
+	{
+		const Piece promoted(PieceType::QUEEN, us, to);
+		switch (m.get_special())
+		{
+		case move_flags::KNIGHT: return KNIGHT_MOVES[to].test(king);
+		case move_flags::BISHOP: return bitboard::generate_bishop_visibility(promoted, occupied).test(king);
+		case move_flags::ROOK:   return bitboard::generate_rook_visibility(promoted, occupied).test(king);
+		default:
+			return (bitboard::generate_bishop_visibility(promoted, occupied)
+			        | bitboard::generate_rook_visibility(promoted, occupied))
+			    .test(king);
+		}
+	}
+
+	if (flags == move_flags::EN_PASSANT)
+	{
+		// The captured pawn also leaves its square, which might uncover a slider that isn't a known candidate.
+		const uint8_t captured = to + (int) PAWN_MOVE_OFFSETS[invert_color(us)];
+		occupied.reset(captured).set(to);
+
+		const Piece enemy_king(PieceType::KING, invert_color(us), king);
+		return (bitboard::generate_rook_visibility(enemy_king, occupied) & (ours.rooks | ours.queens)).any()
+		       || (bitboard::generate_bishop_visibility(enemy_king, occupied) & (ours.bishops | ours.queens)).any();
+	}
+
+	if (flags == move_flags::KINGSIDE_CASTLE || flags == move_flags::QUEENSIDE_CASTLE)
+	{
+		const bool    kingside = flags == move_flags::KINGSIDE_CASTLE;
+		const uint8_t rook_to  = to + (kingside ? KINGSIDE_CASTLE_END_OFFSET : QUEENSIDE_CASTLE_END_OFFSET);
+		const uint8_t rook     = from + (kingside ? KINGSIDE_CASTLE_PIECE_OFFSET : QUEENSIDE_CASTLE_PIECE_OFFSET);
+		occupied.reset(rook).set(to).set(rook_to);
+		return bitboard::generate_rook_visibility(Piece(PieceType::ROOK, us, rook_to), occupied).test(king);
+	}
+
+	return false;
 }
 
 #pragma endregion MOVE_PROCESSING
 
+zobrist::hash_t Board::generate_hash() const
+{
+	zobrist::hash_t new_hash = 0;
+
+	for (auto &piece : this->piece_board)
+		if (piece != piece_set_t::null_iterator) new_hash ^= zobrist::piece_key(*piece);
+
+	new_hash ^= zobrist::side_key(this->turn_to_move());
+	new_hash ^= zobrist::castling_key(pack_castling_rights(this->rights));
+	new_hash ^= zobrist::en_passant_key(this->en_passant_target);
+	return new_hash;
+}
+
+zobrist::hash_t Board::generate_pawn_hash() const
+{
+	zobrist::hash_t new_hash = 0;
+
+	for (auto &piece : this->piece_board)
+		if (piece != piece_set_t::null_iterator) new_hash ^= zobrist::pawn_key(*piece);
+
+	return new_hash;
+}
+
+evaluation::packed_eval_t Board::generate_packed_material() const
+{
+	evaluation::packed_eval_t material = 0;
+
+	for (auto &piece : this->piece_board)
+		if (piece != piece_set_t::null_iterator) material += piece_tables::packed_value(*piece);
+
+	return material;
+}
+
+bool Board::is_repetition() const
+{
+	// Positions from before the last capture, pawn move or promotion can never come back,
+	// and positions from before this board's first recorded move aren't known.
+	const size_t plies     = this->hash_history.size();
+	const size_t max_plies = std::min<size_t>({ this->fifty_move_clock, this->plies_from_null, plies });
+
+	for (size_t back = 4; back <= max_plies; back += 2)
+		if (this->hash_history[plies - back] == this->hash) return true;
+
+	return false;
+}
+
 unsigned int square_to_index(const std::string &square)
 {
 	char file = square.at(0) - 'a';
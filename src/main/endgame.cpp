@@ -0,0 +1,230 @@
+#include "endgame.hpp"
+
+#include "board.hpp"
+#include "kpk.hpp"
+
+#include <algorithm>
+#include <bit>
+#include <cstdlib>
+
+namespace evaluation::endgame
+{
+
+// The largest known endings (like KBNK or KRKP) have four pieces, counting the kings.
+// Positions with more pieces than that skip the table lookup.
+constexpr size_t MAX_ENDGAME_PIECES = 4;
+
+#pragma region HELPERS
+
+inline uint8_t square_of(bitboard::bitboard bb) { return std::countr_zero(bb.bits); }
+
+// Squares as seen from `strong`'s side, so the strong side always plays "up" the board.
+inline uint8_t relative_square(uint8_t square, color_t strong) { return strong == WHITE ? square : square ^ 56; }
+
+inline int file_of(uint8_t square) { return (int) get_file_from_square(square); }
+inline int rank_of(uint8_t square) { return (int) get_rank_from_square(square); }
+
+inline int distance(uint8_t a, uint8_t b)
+{
+	return std::max(std::abs(file_of(a) - file_of(b)), std::abs(rank_of(a) - rank_of(b)));
+}
+
+inline bool is_dark_square(uint8_t square) { return (file_of(square) + rank_of(square)) % 2 == 0; }
+
+// Bigger the further `square` is from the centre. Used to drive the losing king to the edge.
+inline eval_t push_to_edge(uint8_t square)
+{
+	const int file_distance = file_of(square) < 4 ? 3 - file_of(square) : file_of(square) - 4;
+	const int rank_distance = rank_of(square) < 4 ? 3 - rank_of(square) : rank_of(square) - 4;
+	return 20 * (file_distance + rank_distance);
+}
+
+// Bigger the closer the two kings are. The winning king has to help with the mate.
+inline eval_t push_close(uint8_t a, uint8_t b) { return 20 * (8 - distance(a, b)); }
+
+// Endgame material balance from the strong side's point of view.
+inline eval_t material(const Board &state, color_t strong)
+{
+	const eval_t balance = eg_value(state.get_packed_material());
+	return strong == WHITE ? balance : -balance;
+}
+
+#pragma endregion HELPERS
+
+#pragma region EVALUATORS
+
+// Neither side can ever mate.
+eval_t evaluate_draw(const Board &, color_t) { return 0; }
+
+// King and a major piece against a bare king: push the king to the edge and bring ours closer.
+eval_t evaluate_kxk(const Board &state, color_t strong)
+{
+	const uint8_t strong_king = square_of(state.bitboards[strong].pieces.kings);
+	const uint8_t weak_king   = square_of(state.bitboards[invert_color(strong)].pieces.kings);
+
+	return KNOWN_WIN + material(state, strong) + push_to_edge(weak_king) + push_close(strong_king, weak_king);
+}
+
+// Bishop and knight can only mate in a corner the bishop controls, so the king has to be driven there.
+eval_t evaluate_kbnk(const Board &state, color_t strong)
+{
+	const uint8_t strong_king = square_of(state.bitboards[strong].pieces.kings);
+	const uint8_t weak_king   = square_of(state.bitboards[invert_color(strong)].pieces.kings);
+	const uint8_t bishop      = square_of(state.bitboards[strong].pieces.bishops);
+
+	// a1 and h8 are dark, h1 and a8 are light.
+	const bool    dark_corners  = is_dark_square(bishop);
+	const uint8_t corner_a      = dark_corners ? 0 : 7;
+	const uint8_t corner_b      = dark_corners ? 63 : 56;
+	const int     corner_offset = std::min(std::abs(file_of(weak_king) - file_of(corner_a))
+	                                           + std::abs(rank_of(weak_king) - rank_of(corner_a)),
+	                                       std::abs(file_of(weak_king) - file_of(corner_b))
+	                                           + std::abs(rank_of(weak_king) - rank_of(corner_b)));
+
+	return KNOWN_WIN + material(state, strong) + push_close(strong_king, weak_king) + 10 * (14 - corner_offset);
+}
+
+// Rook against pawn. Won if our king stops the pawn or theirs is too far away to support it,
+// drawish if the pawn is far advanced with its king next to it.
+eval_t evaluate_krkp(const Board &state, color_t strong)
+{
+	const color_t weak        = invert_color(strong);
+	const uint8_t strong_king = relative_square(square_of(state.bitboards[strong].pieces.kings), strong);
+	const uint8_t weak_king   = relative_square(square_of(state.bitboards[weak].pieces.kings), strong);
+	const uint8_t rook        = relative_square(square_of(state.bitboards[strong].pieces.rooks), strong);
+	const uint8_t pawn        = relative_square(square_of(state.bitboards[weak].pieces.pawns), strong);
+
+	// The pawn runs down the board towards our first rank.
+	const uint8_t queening    = file_of(pawn);
+	const uint8_t stop_square = pawn - 8;
+	const int     tempo       = state.turn_to_move() == weak ? 1 : 0;
+
+	if (file_of(strong_king) == file_of(pawn) && rank_of(strong_king) < rank_of(pawn))
+		return hce::piece_values::ROOK_END - distance(strong_king, pawn);
+
+	if (distance(weak_king, pawn) >= 3 + tempo && distance(weak_king, rook) >= 3)
+		return hce::piece_values::ROOK_END - distance(strong_king, pawn);
+
+	if (rank_of(weak_king) <= 2 && distance(weak_king, pawn) == 1 && rank_of(strong_king) >= 3
+	    && distance(strong_king, pawn) > 2 + (1 - tempo))
+		return 80 - 8 * distance(strong_king, pawn);
+
+	return 200
+	       - 8 * (distance(strong_king, stop_square) - distance(weak_king, stop_square) - distance(pawn, queening));
+}
+
+// King and pawn against king is looked up in the bitbase. Won positions still reward pushing the pawn,
+// so the search makes progress towards promoting it.
+eval_t evaluate_kpk(const Board &state, color_t strong)
+{
+	const uint8_t strong_king = relative_square(square_of(state.bitboards[strong].pieces.kings), strong);
+	const uint8_t weak_king   = relative_square(square_of(state.bitboards[invert_color(strong)].pieces.kings), strong);
+	const uint8_t pawn        = relative_square(square_of(state.bitboards[strong].pieces.pawns), strong);
+	const color_t to_move     = state.turn_to_move() == strong ? WHITE : BLACK;
+
+	if (!kpk::probe(strong_king, pawn, weak_king, to_move)) return 0;
+	return KNOWN_WIN + hce::piece_values::PAWN_END + 10 * rank_of(pawn);
+}
+
+#pragma endregion EVALUATORS
+
+#pragma region SCALING
+
+// A minor piece against a rook is usually enough to hold the draw.
+eval_t scale_rook_vs_minor(const Board &, color_t) { return SCALE_NORMAL / 4; }
+
+// A rook pawn with a bishop that doesn't control the queening square can't win against a king in the corner.
+eval_t scale_kbpk(const Board &state, color_t strong)
+{
+	const uint8_t pawn      = square_of(state.bitboards[strong].pieces.pawns);
+	const uint8_t bishop    = square_of(state.bitboards[strong].pieces.bishops);
+	const uint8_t weak_king = square_of(state.bitboards[invert_color(strong)].pieces.kings);
+
+	if (file_of(pawn) != 0 && file_of(pawn) != 7) return SCALE_NORMAL;
+
+	const uint8_t queening = relative_square(file_of(pawn) + 56, strong);
+	if (is_dark_square(queening) != is_dark_square(bishop) && distance(weak_king, queening) <= 1) return SCALE_DRAW;
+	return SCALE_NORMAL;
+}
+
+#pragma endregion SCALING
+
+#pragma region TABLE
+
+constexpr entry make_evaluator(std::string_view signature, color_t strong, evaluator_t evaluator, bool exact = false)
+{
+	return entry{ make_key(signature, strong), strong, evaluator, nullptr, exact };
+}
+
+constexpr entry make_scale(std::string_view signature, color_t strong, scale_t scale)
+{
+	return entry{ make_key(signature, strong), strong, nullptr, scale, false };
+}
+
+// clang-format off
+constexpr std::array ENDGAMES = {
+	make_evaluator("KK",   WHITE, evaluate_draw, true),
+	make_evaluator("KNK",  WHITE, evaluate_draw, true),
+	make_evaluator("KNK",  BLACK, evaluate_draw, true),
+	make_evaluator("KBK",  WHITE, evaluate_draw, true),
+	make_evaluator("KBK",  BLACK, evaluate_draw, true),
+	// Mate is possible with two knights, but can't be forced, so it's only exact if the search can't find one.
+	make_evaluator("KNNK", WHITE, evaluate_draw),
+	make_evaluator("KNNK", BLACK, evaluate_draw),
+
+	make_evaluator("KQK",  WHITE, evaluate_kxk),
+	make_evaluator("KQK",  BLACK, evaluate_kxk),
+	make_evaluator("KRK",  WHITE, evaluate_kxk),
+	make_evaluator("KRK",  BLACK, evaluate_kxk),
+	make_evaluator("KBNK", WHITE, evaluate_kbnk),
+	make_evaluator("KBNK", BLACK, evaluate_kbnk),
+	make_evaluator("KRKP", WHITE, evaluate_krkp),
+	make_evaluator("KRKP", BLACK, evaluate_krkp),
+	make_evaluator("KPK",  WHITE, evaluate_kpk),
+	make_evaluator("KPK",  BLACK, evaluate_kpk),
+
+	make_scale("KRKN", WHITE, scale_rook_vs_minor),
+	make_scale("KRKN", BLACK, scale_rook_vs_minor),
+	make_scale("KRKB", WHITE, scale_rook_vs_minor),
+	make_scale("KRKB", BLACK, scale_rook_vs_minor),
+	make_scale("KBPK", WHITE, scale_kbpk),
+	make_scale("KBPK", BLACK, scale_kbpk),
+};
+// clang-format on
+
+material_key_t material_key(const Board &state)
+{
+	material_key_t key = 0;
+	for (color_t color : { WHITE, BLACK })
+	{
+		const bitboard::piece_boards &pieces  = state.bitboards[color].pieces;
+		key                                  += pieces.pawns.count() << material_shift(PieceType::PAWN, color);
+		key                                  += pieces.knights.count() << material_shift(PieceType::KNIGHT, color);
+		key                                  += pieces.bishops.count() << material_shift(PieceType::BISHOP, color);
+		key                                  += pieces.rooks.count() << material_shift(PieceType::ROOK, color);
+		key                                  += pieces.queens.count() << material_shift(PieceType::QUEEN, color);
+	}
+	return key;
+}
+
+const entry *probe(const Board &state)
+{
+	const bitboard::bitboard occupied = state.bitboards[WHITE].pieces.all_pieces
+	                                    | state.bitboards[BLACK].pieces.all_pieces;
+	if (occupied.count() > MAX_ENDGAME_PIECES) return nullptr;
+
+	const material_key_t key = material_key(state);
+	for (const entry &ending : ENDGAMES)
+		if (ending.key == key) return &ending;
+	return nullptr;
+}
+
+eval_t evaluate(const entry &ending, const Board &state)
+{
+	const eval_t score = ending.evaluate(state, ending.strong);
+	return state.turn_to_move() == ending.strong ? score : -score;
+}
+
+#pragma endregion TABLE
+
+} // namespace evaluation::endgame
\ No newline at end of file
@@ -0,0 +1,135 @@
+#include "evaluation.hpp"
+
+#include "board.hpp"
+#include "endgame.hpp"
+#include "nnue.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <limits>
+#include <memory>
+
+namespace evaluation
+{
+
+using Clock = std::chrono::steady_clock;
+
+// Lockless hashing: https://www.chessprogramming.org/Shared_Hash_Table#Lockless
+// Each entry stores the key xor-ed with the data, so an entry torn by two threads writing
+// at once no longer matches its key and just reads as a miss.
+struct cache_entry
+{
+	std::atomic<uint64_t> check{ 0 };
+	std::atomic<uint64_t> data{ 0 };
+};
+
+// Marks an entry as filled, so the all-zero empty entries never match a position whose key happens to be zero.
+constexpr uint64_t VALID_BIT = 1ULL << 32;
+// Mixed into the key while a network is loaded, so network and hand-crafted scores never get mixed up.
+constexpr uint64_t NNUE_KEY  = 0x9d39247e33776d41;
+// One in this many lookups gets timed.
+constexpr uint64_t TIMING_SAMPLE_RATE = 256;
+
+struct cache_table
+{
+	std::unique_ptr<cache_entry[]> entries;
+	size_t                         mask;
+};
+
+// Rounds down to a power of two entries, so indexing is just a mask.
+static cache_table make_table(size_t megabytes)
+{
+	const size_t entries = std::bit_floor(std::max<size_t>(megabytes * 1024 * 1024 / sizeof(cache_entry), 1));
+	return { std::make_unique<cache_entry[]>(entries), entries - 1 };
+}
+
+static cache_table       cache     = make_table(DEFAULT_CACHE_MB);
+static bool              lazy_eval = true;
+thread_local cache_stats stats;
+
+void set_cache_size(size_t megabytes) { cache = make_table(megabytes); }
+
+void set_lazy_eval(bool enabled) { lazy_eval = enabled; }
+
+void clear_cache()
+{
+	for (size_t i = 0; i <= cache.mask; i++)
+	{
+		cache.entries[i].check.store(0, std::memory_order_relaxed);
+		cache.entries[i].data.store(0, std::memory_order_relaxed);
+	}
+}
+
+const cache_stats &get_cache_stats() { return stats; }
+void               reset_cache_stats() { stats = cache_stats{}; }
+
+// Returns true and sets `score` if the position is cached.
+static bool probe(uint64_t key, eval_t &score)
+{
+	const cache_entry &entry = cache.entries[key & cache.mask];
+	const uint64_t     data  = entry.data.load(std::memory_order_relaxed);
+	const uint64_t     check = entry.check.load(std::memory_order_relaxed);
+
+	if ((check ^ data) != key || !(data & VALID_BIT)) return false;
+	score = (int32_t) (uint32_t) data;
+	return true;
+}
+
+static void store(uint64_t key, eval_t score)
+{
+	cache_entry   &entry = cache.entries[key & cache.mask];
+	const uint64_t data  = VALID_BIT | (uint32_t) score;
+	entry.check.store(key ^ data, std::memory_order_relaxed);
+	entry.data.store(data, std::memory_order_relaxed);
+}
+
+eval_t evaluate(const Board &state, eval_t alpha, eval_t beta)
+{
+	const bool     use_nnue = nnue::is_loaded();
+	const uint64_t key      = state.get_hash() ^ (use_nnue ? NNUE_KEY : 0);
+	const bool     timed    = stats.probes++ % TIMING_SAMPLE_RATE == 0;
+
+	eval_t score = 0;
+	bool   hit   = false;
+	if (timed)
+	{
+		const Clock::time_point start = Clock::now();
+		hit                           = probe(key, score);
+		stats.timed_lookup_time      += Clock::now() - start;
+		stats.timed_lookups++;
+	}
+	else hit = probe(key, score);
+
+	if (hit)
+	{
+		stats.hits++;
+		return score;
+	}
+
+	// Known endings replace the regular evaluation, or scale it towards a draw.
+	const endgame::entry *ending = endgame::probe(state);
+	if (ending != nullptr && ending->evaluate != nullptr) score = endgame::evaluate(*ending, state);
+	else if (use_nnue) score = nnue::evaluate(state);
+	// Scaling moves the score towards zero, so a lazy estimate outside the window might not stay outside it.
+	else if (lazy_eval && ending == nullptr)
+	{
+		bool lazy_exit = false;
+		score          = hce::evaluate(state, alpha, beta, lazy_exit);
+		if (lazy_exit) return score;
+	}
+	else score = hce::evaluate(state);
+
+	if (ending != nullptr && ending->scale != nullptr)
+		score = score * ending->scale(state, ending->strong) / endgame::SCALE_NORMAL;
+
+	store(key, score);
+	return score;
+}
+
+eval_t evaluate(const Board &state)
+{
+	return evaluate(state, std::numeric_limits<eval_t>::min(), std::numeric_limits<eval_t>::max());
+}
+
+}
\ No newline at end of file
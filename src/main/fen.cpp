@@ -1,9 +1,12 @@
 #include "fen.hpp"
+#include <algorithm>
 #include <array>
+#include <charconv>
 #include <cstddef>
-#include <cstdlib>
+#include <cstring>
 #include <optional>
 #include <string>
+#include <string_view>
 
 #include "board.hpp"
 #include "pieces.hpp"
@@ -35,89 +38,217 @@ Piece parse_piece(char p, uint8_t idx)
 	return piece;
 }
 
-bool add_pieces_to_board(Board &board, std::string pieces_str)
+// Splits off the next space-separated field. Returns an empty view once the string runs out.
+static std::string_view next_field(std::string_view &rest)
 {
-	std::array<std::string, 8> pieces;
+	const size_t start = rest.find_first_not_of(' ');
+	if (start == std::string_view::npos) return rest = {};
+	const size_t     end   = std::min(rest.find(' ', start), rest.size());
+	std::string_view field = rest.substr(start, end - start);
+	rest.remove_prefix(end);
+	return field;
+}
 
-	size_t prev_offset = 0, offset = 0;
+template <typename T> static bool parse_number(std::string_view field, T &value)
+{
+	const auto [end, error] = std::from_chars(field.data(), field.data() + field.size(), value);
+	return error == std::errc{} && end == field.data() + field.size();
+}
 
-	for (int i = 7; i >= 0; i--)
-	{
-		offset = pieces_str.find('/', offset);
-		if (i == 0) offset = pieces_str.length();
-		if (offset == std::string::npos) return false;
-		pieces.at(i) = pieces_str.substr(prev_offset, offset - prev_offset);
-		prev_offset  = ++offset;
-	}
+static bool is_number(std::string_view field)
+{
+	return !field.empty() && std::all_of(field.begin(), field.end(), [](char c) { return c >= '0' && c <= '9'; });
+}
 
-	for (int rank = 0; rank < pieces.size(); rank++)
+bool add_pieces_to_board(Board &board, std::string_view pieces_str)
+{
+	// The placement starts at a8 and goes rank by rank down to h1.
+	int rank = 7, file = 0;
+	for (char p : pieces_str)
 	{
-		const std::string &file_str = pieces.at(rank);
-		if (file_str.size() > 8) return false;
-		int offset = 0;
-		for (int file = 0; file < file_str.size(); file++)
+		if (p == '/')
 		{
-			char p = file_str.at(file);
-			if (std::isdigit(p))
-			{
-				offset += p - '0' - 1;
-				continue;
-			}
-			Piece new_piece = parse_piece(p, rank * 8 + file + offset);
+			if (file != 8 || rank == 0) return false;
+			rank--;
+			file = 0;
+		}
+		else if (p >= '1' && p <= '8') file += p - '0';
+		else
+		{
+			if (file >= 8) return false;
+			Piece new_piece = parse_piece(p, rank * 8 + file++);
 			if (new_piece.is_none()) return false;
 			board.add_piece(new_piece);
 		}
+		if (file > 8) return false;
 	}
 
-	return true;
+	return rank == 0 && file == 8;
 }
 
-std::array<Board::CastlingRights, 2> parse_castling_rights(const std::string &rights_string)
+bool parse_castling_rights(std::string_view rights_string, std::array<Board::CastlingRights, 2> &rights)
 {
-	// I have no idea why this set of bracketing is the only one that works, this isn't an array of four bools,
-	// it's an array of 2 structs, which hold 2 bools each.
-
-	if (rights_string == "-") return { false, false, false, false };
+	rights = { false, false, false, false };
+	if (rights_string == "-") return true;
 
-	return { rights_string.contains('K'),
-		     rights_string.contains('Q'),
-		     rights_string.contains('k'),
-		     rights_string.contains('q') };
+	for (char right : rights_string)
+	{
+		switch (right)
+		{
+		case 'K': rights[WHITE].kingside = true; break;
+		case 'Q': rights[WHITE].queenside = true; break;
+		case 'k': rights[BLACK].kingside = true; break;
+		case 'q': rights[BLACK].queenside = true; break;
+		default:  return false;
+		}
+	}
+	return !rights_string.empty();
 }
 
-std::optional<Board> Board::from_fen(const std::string &fen_string)
+void Board::_clear()
 {
-	std::array<std::string, 6> fields;
+	// The nodes are kept for the next position's pieces, so setting up a position doesn't allocate once warmed up.
+	for (piece_set_t &set : this->pieces)
+	{
+		this->spare_pieces.splice(this->spare_pieces.end(), set.kings);
+		this->spare_pieces.splice(this->spare_pieces.end(), set.queens);
+		this->spare_pieces.splice(this->spare_pieces.end(), set.rooks);
+		this->spare_pieces.splice(this->spare_pieces.end(), set.bishops);
+		this->spare_pieces.splice(this->spare_pieces.end(), set.knights);
+		this->spare_pieces.splice(this->spare_pieces.end(), set.pawns);
+	}
+	this->piece_board.fill(piece_set_t::iterator{});
+
+	this->moves.clear();
+	this->history.clear();
+	this->hash_history.clear();
+	this->derived_history.clear();
+	this->accumulator_history.clear();
+
+	this->halfmove          = 0;
+	this->fifty_move_clock  = 0;
+	this->plies_from_null   = 0;
+	this->en_passant_target = -1;
+	this->_in_check         = false;
+	this->hash              = 0;
+	this->pawn_hash         = 0;
+	this->packed_material   = 0;
+}
 
-	size_t prev_offset = 0, offset = 0;
+bool Board::_has_valid_pieces() const
+{
+	for (const piece_set_t &set : this->pieces)
+	{
+		const size_t count = set.kings.size() + set.queens.size() + set.rooks.size() + set.bishops.size()
+		                   + set.knights.size() + set.pawns.size();
+		if (set.kings.size() != 1 || count > 16 || set.pawns.size() > 8) return false;
+		for (const Piece &pawn : set.pawns)
+			if (pawn.position() < 8 || pawn.position() >= 56) return false;
+	}
+	return true;
+}
 
-	for (size_t i = 0; i < fields.size(); i++)
+bool Board::set_fen(std::string_view fen_string)
+{
+	this->_clear();
+
+	std::string_view rest       = fen_string;
+	std::string_view placement  = next_field(rest);
+	std::string_view turn       = next_field(rest);
+	std::string_view castling   = next_field(rest);
+	std::string_view en_passant = next_field(rest);
+
+	if (!add_pieces_to_board(*this, placement)) return false;
+	if (!this->_has_valid_pieces()) return false;
+	if (turn != "w" && turn != "b") return false;
+	if (!parse_castling_rights(castling, this->rights)) return false;
+
+	if (en_passant.size() == 2 && en_passant[0] >= 'a' && en_passant[0] <= 'h' && en_passant[1] >= '1'
+	    && en_passant[1] <= '8')
+		this->en_passant_target = (en_passant[1] - '1') * 8 + (en_passant[0] - 'a');
+	else if (en_passant != "-") return false;
+
+	// EPD positions leave out the move counters, and can be followed by operations like `bm Nf3;`.
+	// So the fields after the position are only counters if they are numbers, and everything else is ignored.
+	uint32_t         turn_number = 1;
+	std::string_view counter     = next_field(rest);
+	if (is_number(counter))
 	{
-		offset = fen_string.find(' ', offset);
-		if (i == fields.size() - 1) offset = fen_string.length();
-		if (offset == std::string::npos) return std::nullopt;
-		fields.at(i) = fen_string.substr(prev_offset, offset - prev_offset);
-		prev_offset  = ++offset;
+		if (!parse_number(counter, this->fifty_move_clock)) return false;
+		counter = next_field(rest);
+		if (is_number(counter) && (!parse_number(counter, turn_number) || turn_number == 0)) return false;
 	}
+	this->halfmove = (turn_number - 1) * 2 + (turn == "b");
+
+	this->hash = this->generate_hash();
+	return true;
+}
 
+std::optional<Board> Board::from_fen(std::string_view fen_string)
+{
 	Board board{};
-	if (!add_pieces_to_board(board, fields[0])) return std::nullopt;
+	if (!board.set_fen(fen_string)) return std::nullopt;
+	return board;
+}
+
+size_t Board::to_fen(char *buffer, size_t size) const
+{
+	// Written out in full first, so a buffer that's too small is left untouched.
+	char  fen[MAX_FEN_LENGTH];
+	char *cursor = fen;
 
-	int turn_number = std::strtol(fields[5].c_str(), 0, 10);
-	int turn_offset = 0;
-	if (fields[1][0] == 'b') turn_offset = 1;
-	else if (fields[1][0] != 'w') return std::nullopt;
-	if (turn_number == 0) return std::nullopt;
+	for (int rank = 7; rank >= 0; rank--)
+	{
+		int empty = 0;
+		for (int file = 0; file < 8; file++)
+		{
+			const piece_set_t::const_iterator piece = this->piece_board[rank * 8 + file];
+			if (piece == piece_set_t::const_iterator{})
+			{
+				empty++;
+				continue;
+			}
+			if (empty != 0) *cursor++ = '0' + empty;
+			empty     = 0;
+			*cursor++ = piece->to_string();
+		}
+		if (empty != 0) *cursor++ = '0' + empty;
+		if (rank != 0) *cursor++ = '/';
+	}
+
+	*cursor++ = ' ';
+	*cursor++ = this->turn_to_move() == WHITE ? 'w' : 'b';
+	*cursor++ = ' ';
 
-	board.halfmove = (turn_number - 1) * 2 + turn_offset;
+	const char *castling_start = cursor;
+	if (this->rights[WHITE].kingside) *cursor++ = 'K';
+	if (this->rights[WHITE].queenside) *cursor++ = 'Q';
+	if (this->rights[BLACK].kingside) *cursor++ = 'k';
+	if (this->rights[BLACK].queenside) *cursor++ = 'q';
+	if (cursor == castling_start) *cursor++ = '-';
+	*cursor++ = ' ';
 
-	board.fifty_move_clock = std::strtol(fields[4].c_str(), 0, 10);
-	if (board.fifty_move_clock == 0 && fields[4][0] != '0') return std::nullopt;
+	if (this->can_en_passant())
+	{
+		*cursor++ = 'a' + this->en_passant_target % 8;
+		*cursor++ = '1' + this->en_passant_target / 8;
+	}
+	else *cursor++ = '-';
 
-	board.rights = parse_castling_rights(fields[2]);
-	if (fields[3] != "-") board.en_passant_target = square_to_index(fields[3]);
+	*cursor++ = ' ';
+	cursor    = std::to_chars(cursor, std::end(fen) - 1, this->fifty_move_clock).ptr;
+	*cursor++ = ' ';
+	cursor    = std::to_chars(cursor, std::end(fen), this->halfmove / 2 + 1).ptr;
 
-	return board;
+	const size_t length = cursor - fen;
+	if (length > size) return 0;
+	std::memcpy(buffer, fen, length);
+	return length;
 }
 
-std::string generate_fen_string(const Board &board) { return ""; }
\ No newline at end of file
+std::string generate_fen_string(const Board &board)
+{
+	char         fen[MAX_FEN_LENGTH];
+	const size_t length = board.to_fen(fen, sizeof(fen));
+	return std::string(fen, length);
+}
\ No newline at end of file
@@ -2,8 +2,16 @@
 
 #include "bitboard.hpp"
 #include "board.hpp"
+#include "pawn_structure.hpp"
 #include "pieces.hpp"
 
+#include <algorithm>
+#include <bit>
+#include <cstdlib>
+#include <iomanip>
+#include <limits>
+#include <sstream>
+
 
 namespace phase_values
 {
@@ -23,64 +31,309 @@ constexpr eval_t HALF_PAWNS  = MAX_PAWNS / 2;
 namespace evaluation::hce
 {
 
-eval_t two_phase_lerp(const Board &state, eval_t mg, eval_t eg)
+// Every search thread gets its own pawn table, so probing it never needs a lock.
+thread_local pawns::table pawn_table;
+thread_local eval_stats   stats;
+
+const eval_stats &get_stats() { return stats; }
+void              reset_stats() { stats = eval_stats{}; }
+
+// Weighted count of the non-pawn material on the board, capped at the starting amount.
+eval_t piece_phase(const Board &state)
 {
 	const bitboard::piece_boards &white_bits = state.bitboards[WHITE].pieces;
 	const bitboard::piece_boards &black_bits = state.bitboards[BLACK].pieces;
 
-	eval_t phase  = phase_values::MAX_PIECES;
-	phase        -= (white_bits.knights | black_bits.knights).count();
-	phase        -= (white_bits.bishops | black_bits.bishops).count();
-	phase        -= (white_bits.rooks | black_bits.rooks).count();
-	phase        -= (white_bits.queens | black_bits.queens).count();
-	phase         = (phase * 256) / phase_values::MAX_PIECES;
+	eval_t phase  = 0;
+	phase        += (white_bits.knights.count() + black_bits.knights.count()) * phase_values::KNIGHT;
+	phase        += (white_bits.bishops.count() + black_bits.bishops.count()) * phase_values::BISHOP;
+	phase        += (white_bits.rooks.count() + black_bits.rooks.count()) * phase_values::ROOK;
+	phase        += (white_bits.queens.count() + black_bits.queens.count()) * phase_values::QUEEN;
+	return std::min(phase, phase_values::MAX_PIECES);
+}
+
+// Bonuses for pairs of pieces, and the penalty for having no pawns left.
+packed_eval_t evaluate_modifiers(const Board &state, color_t color)
+{
+	const bitboard::piece_boards &pieces = state.bitboards[color].pieces;
 
-	return (mg * (phase_values::MAX_PIECES - phase) + eg * phase) / 256;
+	eval_t score = 0;
+	if (pieces.rooks.count() >= 2) score += modifier_values::ROOK_PAIR;
+	if (pieces.bishops.count() >= 2) score += modifier_values::BISHOP_PAIR;
+	if (pieces.knights.count() >= 2) score += modifier_values::KNIGHT_PAIR;
+	if (pieces.pawns.none()) score += modifier_values::NO_PAWN_PENALTY;
+	return make_packed(score, score);
 }
 
-eval_t four_phase_lerp(const Board &state, eval_t p1, eval_t p2, eval_t p3, eval_t p4)
+// Scores how many safe squares each of `color`'s pieces attacks.
+// Squares with our own pieces or covered by enemy pawns don't count.
+packed_eval_t evaluate_mobility(const Board &state, color_t color)
 {
-	const bitboard::piece_boards &white_bits = state.bitboards[WHITE].pieces;
-	const bitboard::piece_boards &black_bits = state.bitboards[BLACK].pieces;
+	const bitboard::attack_boards &attacks      = state.bitboards[color].attacks;
+	const bitboard::attack_boards &enemy_attack = state.bitboards[invert_color(color)].attacks;
+	const bitboard::bitboard       area         = ~state.bitboards[color].pieces.all_pieces
+	                                              & ~enemy_attack.by_type[(size_t) PieceType::PAWN];
+
+	packed_eval_t score = 0;
+	for (size_t i = 0; i < attacks.count; i++)
+	{
+		const size_t squares = (attacks.pieces[i] & area).count();
+		switch (attacks.types[i])
+		{
+		case PieceType::KNIGHT: score += mobility_values::KNIGHT[squares]; break;
+		case PieceType::BISHOP: score += mobility_values::BISHOP[squares]; break;
+		case PieceType::ROOK:   score += mobility_values::ROOK[squares]; break;
+		case PieceType::QUEEN:  score += mobility_values::QUEEN[squares]; break;
+		default:                break;
+		}
+	}
+	return score;
+}
+
+// Penalty for enemy pieces attacking the squares around `color`'s king.
+inline eval_t square_distance(uint8_t a, uint8_t b)
+{
+	return std::max(std::abs((int) get_file_from_square(a) - (int) get_file_from_square(b)),
+	                std::abs((int) get_rank_from_square(a) - (int) get_rank_from_square(b)));
+}
+
+// The king's endgame job around passed pawns: the closer ours is to the square in front of our passed pawns,
+// and the further theirs is, the more likely the pawn gets through. Read from the cached pawn entry.
+packed_eval_t evaluate_passed_pawn_kings(const Board &state, const pawns::entry &pawn_entry, color_t color)
+{
+	const uint8_t our_king   = std::countr_zero(state.bitboards[color].pieces.kings.bits);
+	const uint8_t their_king = std::countr_zero(state.bitboards[invert_color(color)].pieces.kings.bits);
+
+	eval_t             proximity = 0;
+	bitboard::bitboard passed    = pawn_entry.passed[color];
+	while (passed.any())
+	{
+		const uint8_t pawn = std::countr_zero(passed.bits);
+		const uint8_t stop = color == WHITE ? pawn + 8 : pawn - 8;
+		proximity         += square_distance(their_king, stop) - square_distance(our_king, stop);
+		passed.bits       &= passed.bits - 1;
+	}
+	return proximity * king_safety_values::PASSED_PAWN_KING;
+}
 
-	eval_t piece_phase  = phase_values::MAX_PIECES;
-	eval_t pawn_phase   = phase_values::MAX_PAWNS;
-	piece_phase        -= (white_bits.knights | black_bits.knights).count();
-	piece_phase        -= (white_bits.bishops | black_bits.bishops).count();
-	piece_phase        -= (white_bits.rooks | black_bits.rooks).count();
-	piece_phase        -= (white_bits.queens | black_bits.queens).count();
-	piece_phase         = (piece_phase * 256) / phase_values::MAX_PIECES;
-	pawn_phase         -= (white_bits.pawns | black_bits.pawns).count();
-	pawn_phase          = (pawn_phase * 256) / phase_values::MAX_PAWNS;
+packed_eval_t evaluate_king_safety(const Board &state, const pawns::entry &pawn_entry, color_t color)
+{
+	const bitboard::attack_boards &enemy_attacks = state.bitboards[invert_color(color)].attacks;
+	const bitboard::bitboard       king          = state.bitboards[color].pieces.kings;
+	const bitboard::bitboard       king_row      = king | bitboard::east(king) | bitboard::west(king);
+	const bitboard::bitboard       king_zone     = king_row | bitboard::north(king_row) | bitboard::south(king_row);
+
+	// Enemy pawns that attack, or could still advance to attack, the squares around the king.
+	const bitboard::bitboard storm      = pawn_entry.attack_span[invert_color(color)] & king_zone;
+	const packed_eval_t      pawn_terms = (packed_eval_t) storm.count() * king_safety_values::PAWN_STORM
+	                                      + evaluate_passed_pawn_kings(state, pawn_entry, color);
+
+	size_t attackers    = 0;
+	eval_t attack_units = 0;
+	for (size_t i = 0; i < enemy_attacks.count; i++)
+	{
+		const bitboard::bitboard zone_attacks = enemy_attacks.pieces[i] & king_zone;
+		if (zone_attacks.none()) continue;
+		attackers++;
+		attack_units += king_safety_values::ATTACK_WEIGHTS[(size_t) enemy_attacks.types[i]] * zone_attacks.count();
+	}
+
+	if (attackers < king_safety_values::MIN_ATTACKERS) return pawn_terms;
+
+	// Grows quadratically, since coordinated attacks are far more dangerous than their parts.
+	const eval_t penalty = std::min(attack_units * attack_units / 4, king_safety_values::MAX_PENALTY);
+	return pawn_terms + make_packed(-penalty, -penalty / 8);
+}
 
+// 0 with all pieces on the board, 256 once they are all gone.
+eval_t scaled_piece_phase(const Board &state)
+{
+	return ((phase_values::MAX_PIECES - piece_phase(state)) * 256) / phase_values::MAX_PIECES;
+}
+
+// 0 with all pawns on the board, 256 once they are all gone.
+eval_t scaled_pawn_phase(const Board &state)
+{
+	const bitboard::bitboard pawns = state.bitboards[WHITE].pieces.pawns | state.bitboards[BLACK].pieces.pawns;
+	return ((phase_values::MAX_PAWNS - (eval_t) pawns.count()) * 256) / phase_values::MAX_PAWNS;
+}
+
+eval_t two_phase_lerp(const Board &state, eval_t mg, eval_t eg)
+{
+	const eval_t phase = scaled_piece_phase(state);
+
+	return (mg * (256 - phase) + eg * phase) / 256;
+}
+
+eval_t four_phase_lerp(const Board &state, eval_t p1, eval_t p2, eval_t p3, eval_t p4)
+{
+	const eval_t piece_phase_value = scaled_piece_phase(state);
+	const eval_t pawn_phase        = scaled_pawn_phase(state);
+
+	// The four weights always add up to 1024.
 	eval_t final_value  = 0;
-	final_value        += (p1 * (512 - piece_phase - pawn_phase));
-	final_value        += (p2 * (256 - piece_phase + pawn_phase));
-	final_value        += (p3 * (256 + piece_phase - pawn_phase));
-	final_value        += (p4 * (0 + piece_phase + pawn_phase));
-	return final_value;
+	final_value        += (p1 * (512 - piece_phase_value - pawn_phase));
+	final_value        += (p2 * (256 - piece_phase_value + pawn_phase));
+	final_value        += (p3 * (256 + piece_phase_value - pawn_phase));
+	final_value        += (p4 * (0 + piece_phase_value + pawn_phase));
+	return final_value / 1024;
+}
+
+// Turns a score from white's point of view into one from the side to move's.
+inline eval_t relative_to_mover(const Board &state, eval_t score)
+{
+	return state.turn_to_move() == WHITE ? score : -score;
+}
+
+// Material and piece-square score of `color`'s pieces, from `color`'s point of view.
+packed_eval_t side_material(const Board &state, color_t color)
+{
+	packed_eval_t material = 0;
+	for (auto &piece : state.piece_board)
+		if (piece != piece_set_t::null_iterator && piece->get_color() == color)
+			material += piece_tables::packed_value(*piece);
+	return color == WHITE ? material : -material;
+}
+
+// The whole evaluation. With `Trace` set, every term is recorded in `trace` as well,
+// and the lazy exit is never taken.
+template <bool Trace>
+eval_t evaluate_terms(const Board &state, eval_t alpha, eval_t beta, bool &lazy_exit, eval_trace *trace)
+{
+	stats.evaluations++;
+
+	// Material and piece-square values are kept up to date by the board as moves are made.
+	const std::array<packed_eval_t, 2> modifiers = { evaluate_modifiers(state, WHITE),
+		                                             evaluate_modifiers(state, BLACK) };
+
+	packed_eval_t score     = state.get_packed_material() + modifiers[WHITE] - modifiers[BLACK];
+	const eval_t  lazy_eval = relative_to_mover(state, two_phase_lerp(state, mg_value(score), eg_value(score)));
+
+	lazy_exit = !Trace && (lazy_eval + lazy_values::MARGIN <= alpha || lazy_eval - lazy_values::MARGIN >= beta);
+	if (lazy_exit)
+	{
+		stats.lazy_exits++;
+		return lazy_eval;
+	}
+
+	bool          pawn_hit   = false;
+	pawns::entry &pawn_entry = pawn_table.probe(state, pawn_hit);
+	stats.pawn_probes++;
+	if (pawn_hit) stats.pawn_hits++;
+
+	const std::array<packed_eval_t, 2> shelter     = { pawns::king_shelter(pawn_entry, state, WHITE),
+		                                               pawns::king_shelter(pawn_entry, state, BLACK) };
+	const std::array<packed_eval_t, 2> mobility    = { evaluate_mobility(state, WHITE),
+		                                               evaluate_mobility(state, BLACK) };
+	const std::array<packed_eval_t, 2> king_safety = { evaluate_king_safety(state, pawn_entry, WHITE),
+		                                               evaluate_king_safety(state, pawn_entry, BLACK) };
+
+	score += pawn_entry.score;
+	score += shelter[WHITE] - shelter[BLACK];
+	score += mobility[WHITE] - mobility[BLACK];
+	score += king_safety[WHITE] - king_safety[BLACK];
+
+	const eval_t total_eval = two_phase_lerp(state, mg_value(score), eg_value(score));
+
+	if constexpr (Trace)
+	{
+		const bitboard::bitboard white_pawns = state.bitboards[WHITE].pieces.pawns;
+		const bitboard::bitboard black_pawns = state.bitboards[BLACK].pieces.pawns;
+
+		trace->terms[(size_t) term::MATERIAL]       = { side_material(state, WHITE), side_material(state, BLACK) };
+		trace->terms[(size_t) term::MODIFIERS]      = modifiers;
+		trace->terms[(size_t) term::PAWN_STRUCTURE] = pawns::side_scores(white_pawns, black_pawns);
+		trace->terms[(size_t) term::KING_SHELTER]   = shelter;
+		trace->terms[(size_t) term::MOBILITY]       = mobility;
+		trace->terms[(size_t) term::KING_SAFETY]    = king_safety;
+		trace->piece_phase                          = scaled_piece_phase(state);
+		trace->pawn_phase                           = scaled_pawn_phase(state);
+		trace->score                                = total_eval;
+	}
+
+	return relative_to_mover(state, total_eval);
+}
+
+eval_t evaluate(const Board &state, eval_t alpha, eval_t beta, bool &lazy_exit)
+{
+	return evaluate_terms<false>(state, alpha, beta, lazy_exit, nullptr);
 }
 
 eval_t evaluate(const Board &state)
 {
-	eval_t white_piece_eval = 0, black_piece_eval = 0;
-	// Start off with simple piece evaluation
-	white_piece_eval += state.pieces[WHITE].queens.size() * piece_values::QUEEN_MID;
-	white_piece_eval += state.pieces[WHITE].rooks.size() * piece_values::ROOK_MID;
-	white_piece_eval += state.pieces[WHITE].bishops.size() * piece_values::BISHOP_MID;
-	white_piece_eval += state.pieces[WHITE].knights.size() * piece_values::KNIGHT_MID;
-	white_piece_eval += state.pieces[WHITE].pawns.size() * piece_values::PAWN_MID;
+	bool lazy_exit = false;
+	return evaluate(state, std::numeric_limits<eval_t>::min(), std::numeric_limits<eval_t>::max(), lazy_exit);
+}
+
+#pragma region Trace
+
+packed_eval_t eval_trace::total() const
+{
+	packed_eval_t sum = 0;
+	for (const auto &sides : this->terms) sum += sides[WHITE] - sides[BLACK];
+	return sum;
+}
+
+std::array<eval_t, TRACE_VECTOR_SIZE> eval_trace::to_vector() const
+{
+	std::array<eval_t, TRACE_VECTOR_SIZE> vector{};
+	size_t                                index = 0;
+	for (const auto &sides : this->terms)
+	{
+		for (packed_eval_t side : sides)
+		{
+			vector[index++] = mg_value(side);
+			vector[index++] = eg_value(side);
+		}
+	}
+	vector[index++] = this->piece_phase;
+	vector[index++] = this->pawn_phase;
+	return vector;
+}
 
-	black_piece_eval += state.pieces[BLACK].queens.size() * piece_values::QUEEN_MID;
-	black_piece_eval += state.pieces[BLACK].rooks.size() * piece_values::ROOK_MID;
-	black_piece_eval += state.pieces[BLACK].bishops.size() * piece_values::BISHOP_MID;
-	black_piece_eval += state.pieces[BLACK].knights.size() * piece_values::KNIGHT_MID;
-	black_piece_eval += state.pieces[BLACK].pawns.size() * piece_values::PAWN_MID;
+eval_trace trace(const Board &state)
+{
+	eval_trace result;
+	bool       lazy_exit = false;
+	(void) evaluate_terms<true>(state,
+	                            std::numeric_limits<eval_t>::min(),
+	                            std::numeric_limits<eval_t>::max(),
+	                            lazy_exit,
+	                            &result);
+	return result;
+}
 
-	eval_t total_piece_eval = white_piece_eval - black_piece_eval;
+std::string format_trace(const eval_trace &trace)
+{
+	std::ostringstream table;
+	const auto         row = [&table](const std::string &name, packed_eval_t white, packed_eval_t black)
+	{
+		const packed_eval_t total = white - black;
+		table << std::left << std::setw(16) << name << std::right;
+		for (packed_eval_t value : { white, black, total })
+			table << " | " << std::setw(6) << mg_value(value) << std::setw(6) << eg_value(value);
+		table << '\n';
+	};
+
+	table << std::left << std::setw(16) << "Term" << std::right;
+	for (const char *column : { "White", "Black", "Total" }) table << " | " << std::setw(12) << column;
+	table << '\n' << std::string(16 + 3 * 15, '-') << '\n';
 
-	if (state.turn_to_move() == BLACK) total_piece_eval *= -1;
-	return total_piece_eval;
+	std::array<packed_eval_t, 2> sums{};
+	for (size_t i = 0; i < TERM_COUNT; i++)
+	{
+		row(TERM_NAMES[i], trace.terms[i][WHITE], trace.terms[i][BLACK]);
+		sums[WHITE] += trace.terms[i][WHITE];
+		sums[BLACK] += trace.terms[i][BLACK];
+	}
+	table << std::string(16 + 3 * 15, '-') << '\n';
+	row("Total", sums[WHITE], sums[BLACK]);
+
+	table << "\nPiece phase: " << trace.piece_phase << "/256, pawn phase: " << trace.pawn_phase << "/256\n";
+	table << "Score: " << trace.score << " (white's point of view)\n";
+	return table.str();
 }
 
+#pragma endregion Trace
+
 }
\ No newline at end of file
@@ -0,0 +1,184 @@
+#include "kpk.hpp"
+
+#include "move.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cstdlib>
+#include <mutex>
+#include <vector>
+
+namespace evaluation::endgame::kpk
+{
+
+static std::array<uint32_t, POSITION_COUNT / 32> bitbase;
+static std::once_flag                            built;
+
+enum result : uint8_t
+{
+	INVALID = 0,
+	UNKNOWN = 1,
+	DRAW    = 2,
+	WIN     = 4
+};
+
+inline int file_of(uint8_t square) { return (int) get_file_from_square(square); }
+inline int rank_of(uint8_t square) { return (int) get_rank_from_square(square); }
+
+inline int distance(uint8_t a, uint8_t b)
+{
+	return std::max(std::abs(file_of(a) - file_of(b)), std::abs(rank_of(a) - rank_of(b)));
+}
+
+// The pawn is on files a-d and ranks 2-7, white is always the side with the pawn.
+inline size_t index(color_t to_move, uint8_t weak_king, uint8_t strong_king, uint8_t pawn)
+{
+	return strong_king | (weak_king << 6) | ((size_t) to_move << 12) | (file_of(pawn) << 13)
+	       | ((size_t) (6 - rank_of(pawn)) << 15);
+}
+
+// Every square a king on `square` can move to.
+static std::vector<uint8_t> king_moves(uint8_t square)
+{
+	std::vector<uint8_t> moves;
+	for (int file = file_of(square) - 1; file <= file_of(square) + 1; file++)
+		for (int rank = rank_of(square) - 1; rank <= rank_of(square) + 1; rank++)
+			if (file >= 0 && file < 8 && rank >= 0 && rank < 8 && (file != file_of(square) || rank != rank_of(square)))
+				moves.push_back(rank * 8 + file);
+	return moves;
+}
+
+static const std::array<std::vector<uint8_t>, 64> KING_TARGETS = []
+{
+	std::array<std::vector<uint8_t>, 64> targets;
+	for (uint8_t square = 0; square < 64; square++) targets[square] = king_moves(square);
+	return targets;
+}();
+
+inline bool pawn_attacks(uint8_t pawn, uint8_t square)
+{
+	return rank_of(square) == rank_of(pawn) + 1 && std::abs(file_of(square) - file_of(pawn)) == 1;
+}
+
+struct kpk_position
+{
+	color_t to_move;
+	uint8_t weak_king;
+	uint8_t strong_king;
+	uint8_t pawn;
+	result  value;
+};
+
+// Decodes `idx` and classifies it if the result doesn't need any other positions.
+static kpk_position classify_static(size_t idx)
+{
+	kpk_position pos;
+	pos.strong_king = idx & 63;
+	pos.weak_king   = (idx >> 6) & 63;
+	pos.to_move     = (color_t) ((idx >> 12) & 1);
+	pos.pawn        = (uint8_t) (((idx >> 13) & 3) + (6 - ((idx >> 15) & 7)) * 8);
+
+	const uint8_t promotion = pos.pawn + 8;
+
+	// Kings next to each other, pieces on the same square, or the side not to move in check.
+	if (distance(pos.strong_king, pos.weak_king) <= 1 || pos.strong_king == pos.pawn || pos.weak_king == pos.pawn
+	    || (pos.to_move == WHITE && pawn_attacks(pos.pawn, pos.weak_king)))
+		pos.value = INVALID;
+	// The pawn promotes and can't be taken right away.
+	else if (pos.to_move == WHITE && rank_of(pos.pawn) == 6 && pos.strong_king != promotion
+	         && pos.weak_king != promotion
+	         && (distance(pos.weak_king, promotion) > 1 || distance(pos.strong_king, promotion) == 1))
+		pos.value = WIN;
+	// The weak king takes an undefended pawn, or is stalemated.
+	else if (pos.to_move == BLACK
+	         && ((distance(pos.weak_king, pos.pawn) == 1 && distance(pos.strong_king, pos.pawn) > 1)
+	             || (!pawn_attacks(pos.pawn, pos.weak_king)
+	                 && std::all_of(KING_TARGETS[pos.weak_king].begin(),
+	                                KING_TARGETS[pos.weak_king].end(),
+	                                [&](uint8_t target) {
+		                                return distance(target, pos.strong_king) <= 1 || pawn_attacks(pos.pawn, target);
+	                                }))))
+		pos.value = DRAW;
+	else pos.value = UNKNOWN;
+
+	return pos;
+}
+
+// Looks at every move from an unknown position. The side to move wins (or draws) if any move does,
+// and loses only once every move is known to lose.
+static result classify(const kpk_position &pos, const std::vector<result> &results)
+{
+	const result good = pos.to_move == WHITE ? WIN : DRAW;
+	const result bad  = pos.to_move == WHITE ? DRAW : WIN;
+
+	uint8_t found = 0;
+	if (pos.to_move == WHITE)
+	{
+		for (uint8_t target : KING_TARGETS[pos.strong_king])
+			if (target != pos.pawn) found |= results[index(BLACK, pos.weak_king, target, pos.pawn)];
+
+		const uint8_t push = pos.pawn + 8;
+		if (rank_of(pos.pawn) < 6 && push != pos.weak_king && push != pos.strong_king)
+		{
+			found |= results[index(BLACK, pos.weak_king, pos.strong_king, push)];
+			const uint8_t double_push = push + 8;
+			if (rank_of(pos.pawn) == 1 && double_push != pos.weak_king && double_push != pos.strong_king)
+				found |= results[index(BLACK, pos.weak_king, pos.strong_king, double_push)];
+		}
+	}
+	else
+	{
+		for (uint8_t target : KING_TARGETS[pos.weak_king])
+			found |= results[index(WHITE, target, pos.strong_king, pos.pawn)];
+	}
+
+	if (found & good) return good;
+	if (found & UNKNOWN) return UNKNOWN;
+	return bad;
+}
+
+static void build()
+{
+	std::vector<kpk_position> positions(POSITION_COUNT);
+	std::vector<result>       results(POSITION_COUNT);
+	for (size_t idx = 0; idx < POSITION_COUNT; idx++)
+	{
+		positions[idx] = classify_static(idx);
+		results[idx]   = positions[idx].value;
+	}
+
+	// Keep going until a whole pass changes nothing. Whatever is still unknown then is a draw,
+	// since neither side can force anything from it.
+	for (bool changed = true; changed;)
+	{
+		changed = false;
+		for (size_t idx = 0; idx < POSITION_COUNT; idx++)
+		{
+			if (results[idx] != UNKNOWN) continue;
+			results[idx] = classify(positions[idx], results);
+			changed     |= results[idx] != UNKNOWN;
+		}
+	}
+
+	for (size_t idx = 0; idx < POSITION_COUNT; idx++)
+		if (results[idx] == WIN) bitbase[idx / 32] |= 1u << (idx % 32);
+}
+
+void init() { std::call_once(built, build); }
+
+bool probe(uint8_t strong_king, uint8_t pawn, uint8_t weak_king, color_t to_move)
+{
+	init();
+	// The board is symmetric left to right, so pawns on files e-h are mirrored onto a-d.
+	if (file_of(pawn) >= 4)
+	{
+		strong_king ^= 7;
+		weak_king   ^= 7;
+		pawn        ^= 7;
+	}
+
+	const size_t idx = index(to_move, weak_king, strong_king, pawn);
+	return bitbase[idx / 32] & (1u << (idx % 32));
+}
+
+} // namespace evaluation::endgame::kpk
\ No newline at end of file
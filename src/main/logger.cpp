@@ -1,6 +1,18 @@
 #include "logger.hpp"
 
+#include "spsc_queue.hpp"
+
+#include <array>
+#include <atomic>
 #include <chrono>
+#include <condition_variable>
+#include <csignal>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <thread>
 
 constexpr char ESC_SEQ_MARK_BOLD[] = "\033[1m";
 constexpr char ESC_SEQ_MARK_RESET[] = "\033[0m";
@@ -25,7 +37,7 @@ std::string trunc_zeros(const std::string &input, size_t num_zeros)
 	return input.substr(0, std::min(point_position + num_zeros, input.length()));
 }
 
-constexpr std::string log_level_to_string(LOG_LEVEL level)
+constexpr std::string_view log_level_to_string(LOG_LEVEL level)
 {
 	switch (level)
 	{
@@ -45,7 +57,7 @@ constexpr std::string log_level_to_string(LOG_LEVEL level)
 	}
 }
 
-constexpr std::string text_color_to_string(TEXT_COLOR color)
+constexpr std::string_view text_color_to_string(TEXT_COLOR color)
 {
 	switch (color) {
 	case TEXT_COLOR::DEBUG: return log_level_to_string(LOG_LEVEL::DEBUG);
@@ -79,7 +91,7 @@ constexpr std::string text_color_to_string(TEXT_COLOR color)
 	}
 }
 
-constexpr std::string log_level_to_escape_seq(LOG_LEVEL level)
+constexpr std::string_view log_level_to_escape_seq(LOG_LEVEL level)
 {
 	switch (level)
 	{
@@ -105,7 +117,7 @@ constexpr std::string log_level_to_escape_seq(LOG_LEVEL level)
 	}
 }
 
-constexpr std::string text_color_to_escape_seq(TEXT_COLOR color)
+constexpr std::string_view text_color_to_escape_seq(TEXT_COLOR color)
 {
 	switch (color)
 	{
@@ -141,10 +153,10 @@ constexpr std::string text_color_to_escape_seq(TEXT_COLOR color)
 	}
 }
 
-std::string Logger::get_timestamp()
-{
-	std::chrono::system_clock::time_point now = std::chrono::system_clock::now();
+std::string Logger::get_timestamp() { return Logger::format_timestamp(std::chrono::system_clock::now()); }
 
+std::string Logger::format_timestamp(std::chrono::system_clock::time_point now)
+{
 	// Convert the time point to a time_t type (Unix timestamp)
 	std::time_t current_time = std::chrono::system_clock::to_time_t(now);
 
@@ -180,7 +192,7 @@ std::string Logger::get_timestamp()
 
 std::string set_color(const std::string &text, TEXT_COLOR color)
 {
-	return text_color_to_escape_seq(color) + text;
+	return std::string(text_color_to_escape_seq(color)) + text;
 }
 
 void Logger::print_color_test()
@@ -199,37 +211,342 @@ void Logger::print_color_test()
 	std::cout << "\n";
 }
 
+#pragma region ASYNC
+
+// A preformatted piece of a message. Longer messages are split over several records.
+struct log_record
+{
+	// When the message was logged, in nanoseconds since the epoch. Only set if the header shows the time,
+	// which the background thread formats, so the logging thread doesn't have to.
+	int64_t  timestamp = 0;
+	uint16_t length    = 0;
+	// The next record in the ring holds more of the same message.
+	bool     continued = false;
+	char     text[245];
+};
+
+static_assert(sizeof(log_record) == 256, "Records are meant to fill four cache lines exactly.");
+
+constexpr size_t RING_RECORDS    = 1024;
+constexpr size_t MAX_LOG_THREADS = 256;
+
+struct log_ring
+{
+	spsc_queue<log_record, RING_RECORDS> records;
+	// Set once the owning thread exits. The writer frees the ring after emptying it.
+	std::atomic<bool>                    closed = false;
+};
+
+// Rings are only ever registered in a free slot and only ever freed by the writer, so no lock is needed.
+static std::array<std::atomic<log_ring *>, MAX_LOG_THREADS> rings{};
+
+static std::atomic<bool>       async_enabled = false;
+static std::atomic<bool>       writer_running = false;
+// The crash handler takes over the rings, which only have room for one consumer. The writer holds `writer_draining`
+// while it pops and checks `crashing` between pops, so once the handler has set one and seen the other clear,
+// the writer won't touch a ring again.
+static std::atomic<bool>       crashing = false;
+static std::atomic<bool>       writer_draining = false;
+static thread_local bool       is_writer = false;
+static std::thread             writer;
+static std::FILE              *async_file = nullptr;
+static std::mutex              flush_mutex;
+static std::condition_variable flush_condition;
+static uint64_t                flush_requested = 0;
+static uint64_t                flush_completed = 0;
+
+// Unregisters the thread's ring when the thread exits.
+struct ring_owner
+{
+	log_ring *ring = nullptr;
+	~ring_owner()
+	{
+		if (this->ring) this->ring->closed.store(true, std::memory_order_release);
+	}
+};
+
+static thread_local ring_owner this_thread_ring;
+
+static log_ring *get_thread_ring()
+{
+	if (this_thread_ring.ring) return this_thread_ring.ring;
+
+	auto ring = std::make_unique<log_ring>();
+	for (auto &slot : rings)
+	{
+		log_ring *empty = nullptr;
+		if (slot.compare_exchange_strong(empty, ring.get(), std::memory_order_acq_rel))
+			return this_thread_ring.ring = ring.release();
+	}
+	// Out of slots. This thread's messages are written synchronously instead.
+	return nullptr;
+}
+
+static void write_record(const log_record &record, std::FILE *file)
+{
+	if (record.timestamp != 0)
+	{
+		using std::chrono::system_clock;
+		const auto time = system_clock::time_point(
+		    std::chrono::duration_cast<system_clock::duration>(std::chrono::nanoseconds(record.timestamp)));
+		const std::string header = "[ " + Logger::format_timestamp(time) + " ]";
+		std::fwrite(header.data(), 1, header.size(), file);
+	}
+	std::fwrite(record.text, 1, record.length, file);
+}
+
+// Writes out every record waiting in any ring. The writer thread also frees the rings of threads that have exited,
+// and waits for the rest of a message it has started, so messages from different threads never interleave.
+// The crash handler can't wait, since the thread that crashed may never finish its message.
+// Returns whether anything was written.
+static bool drain_rings(std::FILE *file, bool from_writer)
+{
+	bool       wrote = false;
+	log_record record;
+	for (auto &slot : rings)
+	{
+		log_ring *ring = slot.load(std::memory_order_acquire);
+		if (!ring) continue;
+
+		// Checked before draining, so nothing the thread pushed before exiting is left behind.
+		const bool closed    = ring->closed.load(std::memory_order_acquire);
+		bool       continued = false;
+		for (;;)
+		{
+			if (from_writer && crashing.load()) return wrote;
+			if (!ring->records.try_pop(record))
+			{
+				if (!continued || !from_writer) break;
+				std::this_thread::yield();
+				continue;
+			}
+			write_record(record, file);
+			continued = record.continued;
+			wrote     = true;
+		}
+		if (closed && from_writer)
+		{
+			slot.store(nullptr, std::memory_order_release);
+			delete ring;
+		}
+	}
+	return wrote;
+}
+
+static void run_writer()
+{
+	using namespace std::chrono_literals;
+
+	is_writer = true;
+	for (;;)
+	{
+		// Read first, so the last pass after stopping still drains everything pushed before.
+		const bool running = writer_running.load(std::memory_order_acquire);
+		uint64_t   flush_target;
+		{
+			std::lock_guard<std::mutex> lock(flush_mutex);
+			flush_target = flush_requested;
+		}
+
+		writer_draining.store(true);
+		const bool wrote = drain_rings(async_file, true);
+		writer_draining.store(false);
+		if (crashing.load()) return;
+		if (wrote || flush_target != flush_completed) std::fflush(async_file);
+		if (flush_target != flush_completed)
+		{
+			{
+				std::lock_guard<std::mutex> lock(flush_mutex);
+				flush_completed = flush_target;
+			}
+			flush_condition.notify_all();
+		}
+
+		if (!running) return;
+		if (!wrote)
+		{
+			std::unique_lock<std::mutex> lock(flush_mutex);
+			flush_condition.wait_for(lock, 1ms, [] { return flush_requested != flush_completed; });
+		}
+	}
+}
+
+// On a crash, whatever is still buffered is written out before the program dies. The writer thread is stopped first
+// (unless it's the one that crashed), so the rings still only have one consumer. None of this is async-signal-safe,
+// but the alternative is losing the messages leading up to the crash.
+static void crash_handler(int signal)
+{
+	crashing.store(true);
+	while (!is_writer && writer_draining.load()) std::this_thread::yield();
+	if (async_file) drain_rings(async_file, false);
+	if (async_file) std::fflush(async_file);
+	std::signal(signal, SIG_DFL);
+	std::raise(signal);
+}
+
+bool Logger::start_async(const std::string &path)
+{
+	if (async_enabled.load()) Logger::stop_async();
+
+	std::FILE *file = path.empty() ? stdout : std::fopen(path.c_str(), "w");
+	if (!file) return false;
+
+	std::cout.flush();
+	async_file = file;
+	writer_running.store(true);
+	writer = std::thread(run_writer);
+	async_enabled.store(true, std::memory_order_release);
+
+	for (int signal : { SIGSEGV, SIGABRT, SIGFPE, SIGILL, SIGTERM }) std::signal(signal, crash_handler);
+	// A program that returns from main without stopping still gets everything written (and its writer joined).
+	static const bool stop_at_exit = std::atexit([] { Logger::stop_async(); }) == 0;
+	(void) stop_at_exit;
+	return true;
+}
+
+void Logger::stop_async()
+{
+	if (!async_enabled.exchange(false)) return;
+
+	writer_running.store(false, std::memory_order_release);
+	flush_condition.notify_all();
+	writer.join();
+
+	for (int signal : { SIGSEGV, SIGABRT, SIGFPE, SIGILL, SIGTERM }) std::signal(signal, SIG_DFL);
+	if (async_file != stdout) std::fclose(async_file);
+	else std::fflush(stdout);
+	async_file = nullptr;
+}
+
+void Logger::flush()
+{
+	if (!async_enabled.load(std::memory_order_acquire)) return;
+
+	std::unique_lock<std::mutex> lock(flush_mutex);
+	const uint64_t               target = ++flush_requested;
+	flush_condition.notify_all();
+	flush_condition.wait(lock, [target] { return flush_completed >= target; });
+}
+
+// Where one call's text goes: into the calling thread's ring when logging asynchronously, otherwise to stdout.
+class log_output
+{
+	log_ring  *ring = nullptr;
+	log_record record;
+
+	// `continued` is set while more of the same call's text is still to come.
+	void push(bool continued)
+	{
+		this->record.continued = continued;
+		// The only time logging waits: the writer has fallen a whole ring behind.
+		while (!this->ring->records.try_push(this->record)) std::this_thread::yield();
+		this->record.timestamp = 0;
+		this->record.length    = 0;
+	}
+
+public:
+	log_output()
+	{
+		if (async_enabled.load(std::memory_order_acquire)) this->ring = get_thread_ring();
+	}
+	~log_output()
+	{
+		if (this->ring && (this->record.length != 0 || this->record.timestamp != 0)) this->push(false);
+	}
+
+	// Writes "[ timestamp ]", now or (when asynchronous) once the record is written out.
+	void timestamp()
+	{
+		if (!this->ring)
+		{
+			std::cout << "[ " << Logger::get_timestamp() << " ]";
+			return;
+		}
+		if (this->record.length != 0) this->push(true);
+		this->record.timestamp = std::chrono::duration_cast<std::chrono::nanoseconds>(
+		                             std::chrono::system_clock::now().time_since_epoch())
+		                             .count();
+	}
+
+	void write(std::string_view text)
+	{
+		if (!this->ring)
+		{
+			std::cout << text;
+			return;
+		}
+		while (!text.empty())
+		{
+			// A full record is only pushed once there's more to add, so the last one is always pushed as the end.
+			if (this->record.length == sizeof(this->record.text)) this->push(true);
+			const size_t length = std::min(text.size(), sizeof(this->record.text) - this->record.length);
+			std::memcpy(this->record.text + this->record.length, text.data(), length);
+			this->record.length += length;
+			text.remove_prefix(length);
+		}
+	}
+};
+
+#pragma endregion ASYNC
+
 void Logger::print_header(LOG_LEVEL level)
 {
-	std::string time = Logger::get_timestamp();
+	log_output out;
+	this->_print_header_to(out, level);
+}
 
-	if (this->header_level == HeaderType::FULL) std::cout << "[ " << time << " ]";
+void Logger::_print_header_to(log_output &out, LOG_LEVEL level)
+{
+	if (this->header_level == HeaderType::FULL) out.timestamp();
 	if (this->header_level >= HeaderType::SHORT)
 	{
-		if (this->label != "") std::cout << "[ " << this->label << " ]";
-		std::cout << "[ " << ESC_SEQ_MARK_BOLD << log_level_to_escape_seq(level) << log_level_to_string(level) << ESC_SEQ_MARK_RESET << " ]: ";
+		if (this->label != "")
+		{
+			out.write("[ ");
+			out.write(this->label);
+			out.write(" ]");
+		}
+		out.write("[ ");
+		out.write(ESC_SEQ_MARK_BOLD);
+		out.write(log_level_to_escape_seq(level));
+		out.write(log_level_to_string(level));
+		out.write(ESC_SEQ_MARK_RESET);
+		out.write(" ]: ");
 	}
 }
 
 void Logger::print(LOG_LEVEL level, const std::string &output, TEXT_COLOR color, bool bold)
 {
-	if (level < this->log_level) return;
+	if (level < COMPILED_LOG_LEVEL || level < this->log_level) return;
+
+	log_output out;
 	if (this->_print_header)
 	{
-		if (this->header_level > HeaderType::NONE) this->print_header(level);
+		if (this->header_level > HeaderType::NONE) this->_print_header_to(out, level);
 		this->_print_header = false;
 	}
-	std::cout << set_color((bold ? ESC_SEQ_MARK_BOLD : "") + output, color) << ESC_SEQ_MARK_RESET;
+	out.write(text_color_to_escape_seq(color));
+	if (bold) out.write(ESC_SEQ_MARK_BOLD);
+	out.write(output);
+	out.write(ESC_SEQ_MARK_RESET);
 };
 
 void Logger::println(LOG_LEVEL level, const std::string &output, TEXT_COLOR color, bool bold)
 {
-	if (level < this->log_level) return;
-	std::string time = Logger::get_timestamp();
+	if (level < COMPILED_LOG_LEVEL || level < this->log_level) return;
 
-	if (this->_print_header && this->header_level > HeaderType::NONE) this->print_header(level);
+	log_output out;
+	if (this->_print_header && this->header_level > HeaderType::NONE) this->_print_header_to(out, level);
 	else if (!this->_print_header) this->_print_header = true;
 
-	if (output == "") { std::cout << "\n"; return; }
-	std::cout << set_color((bold ? ESC_SEQ_MARK_BOLD : "") + output, color) << ESC_SEQ_MARK_RESET << '\n';
+	if (output == "")
+	{
+		out.write("\n");
+		return;
+	}
+	out.write(text_color_to_escape_seq(color));
+	if (bold) out.write(ESC_SEQ_MARK_BOLD);
+	out.write(output);
+	out.write(ESC_SEQ_MARK_RESET);
+	out.write("\n");
 }
\ No newline at end of file
@@ -1,13 +1,69 @@
+#include "analysis_server.hpp"
 #include "board.hpp"
-#include "fen.hpp"
+#include "hc_evaluation.hpp"
+#include "kpk.hpp"
+#include "nnue.hpp"
+#include "transposition.hpp"
+#include "uci.hpp"
+
+#include <cxxopts.hpp>
 #include <iostream>
 
-int main() {
-	// std::cout << "Hello, World!" << std::endl;
-	// std::cout << (new Board())->to_string() << std::endl;
-	auto board = Board::from_fen(std::string(START_FEN));
-	if (!board.has_value()) return 1;
-	board->make_move(Move(square_to_index("e2"), square_to_index("e7")));
-	std::cout << board->to_string() << std::endl;
+// Prints the hand-crafted evaluation's breakdown for a position.
+int print_trace(const std::string &fen)
+{
+	auto result = Board::from_fen(fen);
+	if (!result.has_value())
+	{
+		std::cerr << "Invalid FEN: " << fen << std::endl;
+		return 1;
+	}
+
+	Board board = result.value();
+	board.update_bitboards();
+	std::cout << board.to_string() << std::endl;
+	std::cout << evaluation::hce::format_trace(evaluation::hce::trace(board));
+	return 0;
+}
+
+int main(int argc, char **argv) {
+	cxxopts::Options options("bot", "A chess engine");
+	options.add_options()
+		("t,trace", "Print the hand-crafted evaluation of a FEN term by term", cxxopts::value<std::string>())
+		("s,server", "Analyse JSON-lines requests from stdin, or from a Unix socket with --server=PATH",
+		 cxxopts::value<std::string>()->implicit_value(""))
+		("hash-file", "Keep the transposition table in this file, so it survives restarts",
+		 cxxopts::value<std::string>())
+		("w,workers", "Positions the server analyses at once",
+		 cxxopts::value<size_t>()->default_value(std::to_string(analysis::default_workers())))
+		("h,help", "Print this help");
+	const cxxopts::ParseResult args = options.parse(argc, argv);
+
+	if (args.count("help"))
+	{
+		std::cout << options.help() << std::endl;
+		return 0;
+	}
+	if (args.count("trace")) return print_trace(args["trace"].as<std::string>());
+
+	(void) evaluation::nnue::load(evaluation::nnue::DEFAULT_NETWORK_FILE);
+	// Built now rather than on the first probe, which would stall whichever search reaches KPK first.
+	evaluation::endgame::kpk::init();
+	if (args.count("hash-file") && !transposition::open_file(args["hash-file"].as<std::string>()))
+		std::cerr << "Can't open hash file " << args["hash-file"].as<std::string>() << std::endl;
+	if (args.count("server"))
+	{
+		const std::string socket_path = args["server"].as<std::string>();
+		const size_t      workers     = args["workers"].as<size_t>();
+		if (socket_path.empty()) analysis::run(std::cin, std::cout, workers);
+		else if (!analysis::serve(socket_path, workers))
+		{
+			std::cerr << "Can't listen on " << socket_path << std::endl;
+			return 1;
+		}
+		return 0;
+	}
+
+	uci::run(std::cin, std::cout);
 	return 0;
 }
\ No newline at end of file
@@ -0,0 +1,73 @@
+#include "mapped_file.hpp"
+
+#include <fstream>
+#include <utility>
+
+#if defined(__unix__) || defined(__APPLE__)
+#define MAPPED_FILE_USE_MMAP
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+mapped_file::mapped_file(const std::string &path)
+{
+#ifdef MAPPED_FILE_USE_MMAP
+	int fd = open(path.c_str(), O_RDONLY);
+	if (fd == -1) return;
+
+	struct stat info;
+	if (fstat(fd, &info) == 0 && info.st_size > 0)
+	{
+		void *data = mmap(nullptr, info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+		if (data != MAP_FAILED)
+		{
+			this->_data = static_cast<const char *>(data);
+			this->_size = info.st_size;
+		}
+	}
+	::close(fd);
+#else
+	std::ifstream stream(path, std::ios::binary | std::ios::ate);
+	if (!stream) return;
+	const std::streamoff size = stream.tellg();
+	if (size <= 0) return;
+
+	this->copy = std::make_unique<char[]>(size);
+	stream.seekg(0);
+	if (stream.read(this->copy.get(), size))
+	{
+		this->_data = this->copy.get();
+		this->_size = size;
+	}
+	else this->copy.reset();
+#endif
+}
+
+mapped_file::~mapped_file() { this->close(); }
+
+mapped_file::mapped_file(mapped_file &&other) noexcept
+    : _data(std::exchange(other._data, nullptr)), _size(std::exchange(other._size, 0)), copy(std::move(other.copy))
+{
+}
+
+mapped_file &mapped_file::operator=(mapped_file &&other) noexcept
+{
+	if (this == &other) return *this;
+	this->close();
+	this->_data = std::exchange(other._data, nullptr);
+	this->_size = std::exchange(other._size, 0);
+	this->copy  = std::move(other.copy);
+	return *this;
+}
+
+void mapped_file::close()
+{
+#ifdef MAPPED_FILE_USE_MMAP
+	if (this->_data != nullptr) munmap(const_cast<char *>(this->_data), this->_size);
+#endif
+	this->_data = nullptr;
+	this->_size = 0;
+	this->copy.reset();
+}
\ No newline at end of file
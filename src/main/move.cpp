@@ -1,6 +1,8 @@
 #include "move.hpp"
 #include "board.hpp"
+#include "move_generation.hpp"
 #include "pieces.hpp"
+#include <bit>
 #include <sstream>
 #include <stdexcept>
 
@@ -32,6 +34,12 @@ char get_promotion_piece(uint16_t promotion_id, color_t c)
 
 std::string Move::to_string(const Board &state, bool short_version) const
 {
+	if (short_version)
+	{
+		char buffer[MAX_UCI_LENGTH];
+		return std::string(buffer, this->to_uci(buffer));
+	}
+
 	piece_set_t::const_iterator piece = state.piece_board.at(this->get_from());
 	// if (piece == nullptr) return "";
 	std::ostringstream output;
@@ -55,4 +63,105 @@ std::string Move::to_string(const Board &state, bool short_version) const
 	else if (this->is_promotion()) output << get_promotion_piece(this->get_special(), BLACK);
 
 	return output.str();
+}
+
+static char piece_letter(PieceType type)
+{
+	switch (type)
+	{
+	case PieceType::KNIGHT: return 'N';
+	case PieceType::BISHOP: return 'B';
+	case PieceType::ROOK:   return 'R';
+	case PieceType::QUEEN:  return 'Q';
+	case PieceType::KING:   return 'K';
+	default:                return '?';
+	}
+}
+
+static uint64_t pieces_of_type(const bitboard::piece_boards &pieces, PieceType type)
+{
+	switch (type)
+	{
+	case PieceType::KNIGHT: return pieces.knights.bits;
+	case PieceType::BISHOP: return pieces.bishops.bits;
+	case PieceType::ROOK:   return pieces.rooks.bits;
+	case PieceType::QUEEN:  return pieces.queens.bits;
+	case PieceType::KING:   return pieces.kings.bits;
+	default:                return pieces.pawns.bits;
+	}
+}
+
+static char *write_square(char *cursor, uint16_t square)
+{
+	*cursor++ = (char) ('a' + get_file_from_square(square));
+	*cursor++ = (char) ('1' + get_rank_from_square(square));
+	return cursor;
+}
+
+size_t Move::to_uci(char *buffer) const
+{
+	if (this->empty())
+	{
+		std::copy_n("0000", 4, buffer);
+		return 4;
+	}
+
+	char *cursor = write_square(write_square(buffer, this->get_from()), this->get_to());
+	if (this->is_promotion()) *cursor++ = get_promotion_piece(this->get_special(), BLACK);
+	return cursor - buffer;
+}
+
+size_t Move::to_san(char *buffer, Board &state) const
+{
+	char *cursor = buffer;
+
+	if (this->get_flags() == move_flags::KINGSIDE_CASTLE) cursor = std::copy_n("O-O", 3, cursor);
+	else if (this->get_flags() == move_flags::QUEENSIDE_CASTLE) cursor = std::copy_n("O-O-O", 5, cursor);
+	else
+	{
+		const Piece &piece = *state.piece_board[this->get_from()];
+		if (piece == PieceType::PAWN)
+		{
+			if (this->is_capture()) *cursor++ = (char) ('a' + get_file_from_square(this->get_from()));
+		}
+		else
+		{
+			*cursor++ = piece_letter(piece.get_type());
+
+			// Other pieces of the same kind that could move to the same square. Only as much of the origin
+			// square is written as it takes to tell them apart.
+			const uint16_t flags         = this->is_capture() ? move_flags::NORMAL_CAPTURE : move_flags::QUIET_MOVE;
+			bool           ambiguous     = false;
+			bool           file_is_taken = false;
+			bool           rank_is_taken = false;
+			uint64_t       others        = pieces_of_type(state.bitboards[piece.get_color()].pieces, piece.get_type());
+			for (others &= ~(1ULL << this->get_from()); others != 0; others &= others - 1)
+			{
+				const uint16_t other = std::countr_zero(others);
+				if (!is_legal(state, Move(other, this->get_to(), flags))) continue;
+				ambiguous      = true;
+				file_is_taken |= get_file_from_square(other) == get_file_from_square(this->get_from());
+				rank_is_taken |= get_rank_from_square(other) == get_rank_from_square(this->get_from());
+			}
+			if (ambiguous && (!file_is_taken || rank_is_taken))
+				*cursor++ = (char) ('a' + get_file_from_square(this->get_from()));
+			if (file_is_taken) *cursor++ = (char) ('1' + get_rank_from_square(this->get_from()));
+		}
+
+		if (this->is_capture()) *cursor++ = 'x';
+		cursor = write_square(cursor, this->get_to());
+		if (this->is_promotion())
+		{
+			*cursor++ = '=';
+			*cursor++ = get_promotion_piece(this->get_special(), WHITE);
+		}
+	}
+
+	if (state.gives_check(*this))
+	{
+		state.make_move(*this);
+		*cursor++ = has_legal_moves(state) ? '+' : '#';
+		state.unmake_move();
+	}
+	return cursor - buffer;
 }
\ No newline at end of file
@@ -9,11 +9,11 @@
 #include <cstdlib>
 #include <stdexcept>
 
-std::vector<bitboard::bitboard>::const_iterator get_pin_line(size_t piece_index, const bitboard::list &pins)
+const bitboard::bitboard *get_pin_line(size_t piece_index, const bitboard::list &pins)
 {
-	for (auto l = pins.boards.cbegin(); l != pins.boards.cend(); ++l)
+	for (auto l = pins.begin(); l != pins.end(); ++l)
 		if (l->test(piece_index)) return l;
-	return pins.boards.cend();
+	return pins.end();
 }
 
 // Generates a line from (start, end)
@@ -91,7 +91,7 @@ void generate_capture_moves_for_pawn(const Board              &state,
 
 	auto line = get_pin_line(pawn.position(), threats.pins);
 
-	if (line != threats.pins.boards.cend())
+	if (line != threats.pins.end())
 	{
 		if (state.is_in_check()) return;
 		captures &= *line;
@@ -156,7 +156,7 @@ void generate_moves_for_pawn(const Board              &state,
 	if (bb_move.none()) return;
 
 	auto line = get_pin_line(pawn.position(), threat_boards.pins);
-	if (line != threat_boards.pins.boards.cend())
+	if (line != threat_boards.pins.end())
 	{
 		if (state.is_in_check()) return;
 		bb_move        &= *line;
@@ -195,7 +195,7 @@ void generate_moves_for_knight(const Board                   &state,
 	bitboard::bitboard moves_bb = KNIGHT_MOVES[knight.position()] & ~friendly_pieces;
 
 	auto line = get_pin_line(knight.position(), threats.pins);
-	if (line != threats.pins.boards.cend())
+	if (line != threats.pins.end())
 	{
 		if (state.is_in_check()) return;
 		moves_bb &= *line;
@@ -232,7 +232,7 @@ void generate_moves_on_line(const Board                   &state,
 	auto               line = get_pin_line(piece.position(), threats.pins);
 	bitboard::bitboard allowed_squares(UINT64_MAX);
 
-	if (line != threats.pins.boards.cend())
+	if (line != threats.pins.end())
 	{
 		allowed_squares &= *line;
 		if (state.is_in_check() && (allowed_squares & threats.checks.combined).none()) return;
@@ -389,7 +389,7 @@ std::vector<Move> generate_moves(const Board &state)
 	const bitboard::single_set &current_boards = bitboards[current_color];
 	const bitboard::single_set &other_boards   = bitboards[other_color];
 
-	bool double_check = current_boards.threats.checks.boards.size() > 1;
+	bool double_check = current_boards.threats.checks.size() > 1;
 
 	generate_moves_for_king(state, moves, current_pieces.kings.front(), bitboards);
 	if (double_check) return moves;
@@ -421,4 +421,188 @@ std::vector<Move> generate_moves(const Board &state)
 	}
 
 	return moves;
+}
+
+#pragma region LEGALITY
+
+// Applies the same pin and check restrictions the generator uses for pawns and knights.
+bool is_allowed_by_threats(const Board &state, uint8_t from, uint8_t to, const bitboard::threat_boards &threats)
+{
+	auto line = get_pin_line(from, threats.pins);
+	if (line != threats.pins.end()) return !state.is_in_check() && line->test(to);
+	return threats.checks.combined.none() || threats.checks.combined.test(to);
+}
+
+bool is_legal_king_move(const Board &state, const Piece &king, Move m, const bitboard::full_set &bitboards)
+{
+	const uint8_t             from             = king.position();
+	const uint8_t             to               = m.get_to();
+	const uint16_t            flags            = m.get_flags();
+	const color_t             other_color      = invert_color(king.get_color());
+	const bitboard::bitboard  all_pieces       = bitboards[WHITE].pieces.all_pieces | bitboards[BLACK].pieces.all_pieces;
+	const bitboard::bitboard &enemy_visibility = bitboards[other_color].pieces.visible;
+
+	if (flags == move_flags::KINGSIDE_CASTLE || flags == move_flags::QUEENSIDE_CASTLE)
+	{
+		const bool            kingside = flags == move_flags::KINGSIDE_CASTLE;
+		Board::CastlingRights rights   = state.get_castling_rights(king.get_color());
+		if (state.is_in_check() || !(kingside ? rights.kingside : rights.queenside)) return false;
+
+		const int      offset = (int) (kingside ? DirectionOffset::RIGHT : DirectionOffset::LEFT);
+		const uint16_t first  = from + offset;
+		const uint16_t second = first + offset;
+		if (to != second || !inside_board(second)) return false;
+
+		bitboard::bitboard mask       = bitboard::bitboard().set(first).set(second);
+		bitboard::bitboard clear_mask = kingside ? mask : bitboard::bitboard(mask).set(second + offset);
+		return (enemy_visibility & mask).none() && (all_pieces & clear_mask).none();
+	}
+
+	const int file_diff = std::abs((int) get_file_from_square(from) - (int) get_file_from_square(to));
+	const int rank_diff = std::abs((int) get_rank_from_square(from) - (int) get_rank_from_square(to));
+	if (file_diff > 1 || rank_diff > 1 || enemy_visibility.test(to)) return false;
+
+	const bool is_capture = bitboards[other_color].pieces.all_pieces.test(to);
+	return flags == (is_capture ? move_flags::CAPTURE : move_flags::QUIET_MOVE);
+}
+
+bool is_legal_pawn_move(const Board &state, const Piece &pawn, Move m, const bitboard::full_set &bitboards)
+{
+	const uint8_t  from         = pawn.position();
+	const uint8_t  to           = m.get_to();
+	const uint16_t flags        = m.get_flags();
+	const color_t  pawn_color   = pawn.get_color();
+	const bool     to_last_rank = ((to + 8) % 64) < 16;
+	const int      forward      = (int) PAWN_MOVE_OFFSETS[pawn_color];
+	const auto    &threats      = bitboards[pawn_color].threats;
+	const auto    &enemy_pieces = bitboards[invert_color(pawn_color)].pieces.all_pieces;
+	const auto     all_pieces   = bitboards[WHITE].pieces.all_pieces | bitboards[BLACK].pieces.all_pieces;
+
+	if (m.is_capture())
+	{
+		if (!PAWN_CAPTURES[pawn_color][from].test(to)) return false;
+
+		if (flags == move_flags::EN_PASSANT)
+		{
+			if (to != state.get_en_passant_target() || is_en_passant_discovered_check(state, pawn, to)) return false;
+		}
+		else if (!enemy_pieces.test(to)) return false;
+		else if (to_last_rank != m.is_promotion() || (!m.is_promotion() && flags != move_flags::CAPTURE)) return false;
+
+		return is_allowed_by_threats(state, from, to, threats);
+	}
+
+	// Pushes. The generator skips every push once the square in front is blocked.
+	if (all_pieces.test(from + forward)) return false;
+
+	if (flags == move_flags::DOUBLE_PAWN_PUSH)
+	{
+		if (get_rank_from_square(from) != PAWN_DOUBLE_MOVE_RANKS[pawn_color] || to != from + 2 * forward) return false;
+		if (all_pieces.test(to)) return false;
+	}
+	else if (to != from + forward || to_last_rank != m.is_promotion() || (!m.is_promotion() && flags != 0))
+		return false;
+
+	return is_allowed_by_threats(state, from, to, threats);
+}
+
+bool is_legal(const Board &state, Move m)
+{
+	const uint16_t from  = m.get_from();
+	const uint16_t to    = m.get_to();
+	const uint16_t flags = m.get_flags();
+
+	// 0b0110 and 0b0111 don't encode anything.
+	if (from == to || flags == 0b0110 || flags == 0b0111) return false;
+
+	const bitboard::full_set     &bitboards     = state.get_bitboards();
+	const color_t                 current_color = state.turn_to_move();
+	const bitboard::single_set   &current       = bitboards[current_color];
+	const bitboard::piece_boards &enemy         = bitboards[invert_color(current_color)].pieces;
+
+	if (!current.pieces.all_pieces.test(from) || current.pieces.all_pieces.test(to)) return false;
+
+	const Piece &piece = *state.piece_board[from];
+
+	if (piece == PieceType::KING) return is_legal_king_move(state, piece, m, bitboards);
+	if (current.threats.checks.size() > 1) return false;
+	if (piece == PieceType::PAWN) return is_legal_pawn_move(state, piece, m, bitboards);
+
+	// Everything left can only make plain moves and captures.
+	if (flags != (enemy.all_pieces.test(to) ? move_flags::CAPTURE : move_flags::QUIET_MOVE)) return false;
+
+	if (piece == PieceType::KNIGHT)
+		return KNIGHT_MOVES[from].test(to) && is_allowed_by_threats(state, from, to, current.threats);
+
+	const bitboard::bitboard all_pieces = current.pieces.all_pieces | enemy.all_pieces;
+	bitboard::bitboard       reachable;
+	switch (piece.get_type())
+	{
+	case PieceType::BISHOP: reachable = bitboard::generate_bishop_visibility(piece, all_pieces); break;
+	case PieceType::ROOK:   reachable = bitboard::generate_rook_visibility(piece, all_pieces); break;
+	case PieceType::QUEEN:
+		reachable = bitboard::generate_bishop_visibility(piece, all_pieces)
+		            | bitboard::generate_rook_visibility(piece, all_pieces);
+		break;
+	default: return false;
+	}
+	if (!reachable.test(to)) return false;
+
+	// Sliders follow generate_moves_on_line: a pinned slider may only move along its pin line.
+	const bitboard::threat_boards &threats = current.threats;
+	auto                           line    = get_pin_line(from, threats.pins);
+	if (line != threats.pins.end())
+		return line->test(to) && !(state.is_in_check() && (*line & threats.checks.combined).none());
+	return threats.checks.combined.none() || threats.checks.combined.test(to);
+}
+
+#pragma endregion LEGALITY
+
+bool has_legal_moves(const Board &state)
+{
+	const bitboard::full_set     &bitboards = state.get_bitboards();
+	const color_t                 us        = state.turn_to_move();
+	const bitboard::single_set   &current   = bitboards[us];
+	const bitboard::piece_boards &enemy     = bitboards[invert_color(us)].pieces;
+
+	const bitboard::bitboard      own       = current.pieces.all_pieces;
+
+	auto flags_for = [&](uint8_t to)
+	{ return enemy.all_pieces.test(to) ? move_flags::CAPTURE : move_flags::QUIET_MOVE; };
+
+	const uint8_t king = std::countr_zero(current.pieces.kings.bits);
+	for (uint64_t targets = (KING_MOVES[king] & ~own).bits; targets != 0; targets &= targets - 1)
+	{
+		const uint8_t to = std::countr_zero(targets);
+		if (is_legal(state, Move(king, to, flags_for(to)))) return true;
+	}
+	if (current.threats.checks.size() > 1) return false;
+
+	// In check, every other move has to capture the checking piece or block the check. Castling never needs to be
+	// tried: if it's legal, so is the king's first step.
+	bitboard::bitboard destinations = state.is_in_check() ? current.threats.checks.combined : ~own;
+	if (state.can_en_passant()) destinations.set(state.get_en_passant_target());
+
+	const int forward = (int) PAWN_MOVE_OFFSETS[us];
+	for (uint64_t origins = (own & ~current.pieces.kings).bits; origins != 0; origins &= origins - 1)
+	{
+		const uint8_t from = std::countr_zero(origins);
+		const bool    pawn = current.pieces.pawns.test(from);
+		for (uint64_t targets = destinations.bits; targets != 0; targets &= targets - 1)
+		{
+			const uint8_t to    = std::countr_zero(targets);
+			uint16_t      flags = flags_for(to);
+			if (pawn)
+			{
+				// Every promotion piece is legal exactly when the queen is, so one of them is enough.
+				const bool promotion = ((to + 8) % 64) < 16;
+				if (to == state.get_en_passant_target() && get_file_from_square(to) != get_file_from_square(from))
+					flags = move_flags::EN_PASSANT;
+				else if (to == from + 2 * forward) flags = move_flags::DOUBLE_PAWN_PUSH;
+				if (promotion) flags |= move_flags::QUEEN_PROMOTION;
+			}
+			if (is_legal(state, Move(from, to, flags))) return true;
+		}
+	}
+	return false;
 }
\ No newline at end of file
@@ -0,0 +1,250 @@
+#include "nnue.hpp"
+
+#include "board.hpp"
+#include "mapped_file.hpp"
+
+#include <algorithm>
+#include <bit>
+#include <cstring>
+
+// The AVX2 paths are compiled for x86 whatever the build's target, and only taken if the CPU running the engine has
+// AVX2, so one binary runs everywhere.
+#if (defined(__x86_64__) || defined(__i386__)) && (defined(__GNUC__) || defined(__clang__))
+#define NNUE_AVX2
+#include <immintrin.h>
+#endif
+
+namespace evaluation::nnue
+{
+
+struct network
+{
+	const int16_t *feature_weights = nullptr;
+	const int16_t *feature_biases  = nullptr;
+	const int8_t  *output_weights  = nullptr;
+	int32_t        output_bias     = 0;
+};
+
+// The loaded network points straight into the loaded file.
+static network     net;
+static mapped_file loaded_file;
+
+#pragma region LOADING
+
+bool load(const std::string &path)
+{
+	static_assert(std::endian::native == std::endian::little, "Network files are read in place as little-endian.");
+
+	mapped_file file(path);
+	file_header header{};
+	if (file.size() == FILE_SIZE) std::memcpy(&header, file.data(), sizeof(header));
+
+	if (header.magic != FILE_MAGIC || header.version != FILE_VERSION || header.inputs != INPUTS
+	    || header.hidden != HIDDEN)
+		return false;
+
+	loaded_file = std::move(file);
+
+	const char *cursor  = loaded_file.data() + sizeof(file_header);
+	net.feature_weights = reinterpret_cast<const int16_t *>(cursor);
+	cursor             += INPUTS * HIDDEN * sizeof(int16_t);
+	net.feature_biases  = reinterpret_cast<const int16_t *>(cursor);
+	cursor             += HIDDEN * sizeof(int16_t);
+	net.output_weights  = reinterpret_cast<const int8_t *>(cursor);
+	cursor             += 2 * HIDDEN * sizeof(int8_t);
+	std::memcpy(&net.output_bias, cursor, sizeof(int32_t));
+
+	return true;
+}
+
+void unload()
+{
+	loaded_file.close();
+	net = network{};
+}
+
+bool is_loaded() { return loaded_file.is_open(); }
+
+#pragma endregion LOADING
+
+#pragma region ACCUMULATOR
+
+void delta::remove(const Piece &piece)
+{
+	if (piece == PieceType::KING) king_moved[piece.get_color()] = true;
+	else removed[removed_count++] = piece;
+}
+
+void delta::add(const Piece &piece)
+{
+	if (piece != PieceType::KING) added[added_count++] = piece;
+}
+
+inline size_t feature_index(color_t perspective, uint8_t king, const Piece &piece)
+{
+	const uint8_t flip        = perspective == WHITE ? 0 : 56;
+	const size_t  piece_index = ((size_t) piece.get_type() - 1) * 2 + (piece.get_color() != perspective);
+	return ((size_t) (king ^ flip) * PIECE_INDICES + piece_index) * 64 + (piece.position() ^ flip);
+}
+
+inline const int16_t *feature_column(color_t perspective, uint8_t king, const Piece &piece)
+{
+	return net.feature_weights + feature_index(perspective, king, piece) * HIDDEN;
+}
+
+inline uint8_t king_square(const Board &state, color_t color)
+{
+	return std::countr_zero(state.bitboards[color].pieces.kings.bits);
+}
+
+#ifdef NNUE_AVX2
+static const bool has_avx2 = []
+{
+	__builtin_cpu_init();
+	return __builtin_cpu_supports("avx2") != 0;
+}();
+
+__attribute__((target("avx2"))) static void apply_columns_avx2(int16_t              *values,
+                                                               const int16_t *const *added,
+                                                               size_t                added_count,
+                                                               const int16_t *const *removed,
+                                                               size_t                removed_count)
+{
+	constexpr size_t REGISTER_WIDTH = 16;
+	for (size_t i = 0; i < HIDDEN; i += REGISTER_WIDTH)
+	{
+		__m256i sum = _mm256_load_si256(reinterpret_cast<const __m256i *>(values + i));
+		for (size_t a = 0; a < added_count; a++)
+			sum = _mm256_add_epi16(sum, _mm256_loadu_si256(reinterpret_cast<const __m256i *>(added[a] + i)));
+		for (size_t r = 0; r < removed_count; r++)
+			sum = _mm256_sub_epi16(sum, _mm256_loadu_si256(reinterpret_cast<const __m256i *>(removed[r] + i)));
+		_mm256_store_si256(reinterpret_cast<__m256i *>(values + i), sum);
+	}
+}
+#endif
+
+// Adds every column in `added` to `values` and subtracts every column in `removed`, in one pass.
+static void apply_columns(int16_t              *values,
+                          const int16_t *const *added,
+                          size_t                added_count,
+                          const int16_t *const *removed,
+                          size_t                removed_count)
+{
+#ifdef NNUE_AVX2
+	if (has_avx2) return apply_columns_avx2(values, added, added_count, removed, removed_count);
+#endif
+	for (size_t a = 0; a < added_count; a++)
+		for (size_t i = 0; i < HIDDEN; i++) values[i] += added[a][i];
+	for (size_t r = 0; r < removed_count; r++)
+		for (size_t i = 0; i < HIDDEN; i++) values[i] -= removed[r][i];
+}
+
+void refresh(accumulator &acc, const Board &state, color_t perspective)
+{
+	const uint8_t king = king_square(state, perspective);
+	int16_t      *values = acc.values[perspective].data();
+	std::memcpy(values, net.feature_biases, HIDDEN * sizeof(int16_t));
+
+	// A legal position never has more than 30 pieces besides the kings, but the columns are applied
+	// whenever the buffer fills up, so no board can overrun it.
+	std::array<const int16_t *, 32> columns;
+	size_t                          column_count = 0;
+	for (auto &piece : state.piece_board)
+	{
+		if (piece == piece_set_t::null_iterator || *piece == PieceType::KING) continue;
+		columns[column_count++] = feature_column(perspective, king, *piece);
+		if (column_count == columns.size())
+		{
+			apply_columns(values, columns.data(), column_count, nullptr, 0);
+			column_count = 0;
+		}
+	}
+	apply_columns(values, columns.data(), column_count, nullptr, 0);
+}
+
+void refresh(accumulator &acc, const Board &state)
+{
+	refresh(acc, state, WHITE);
+	refresh(acc, state, BLACK);
+}
+
+void update(accumulator &acc, const delta &changes, const Board &state)
+{
+	for (color_t perspective : { WHITE, BLACK })
+	{
+		if (changes.king_moved[perspective])
+		{
+			refresh(acc, state, perspective);
+			continue;
+		}
+
+		const uint8_t                  king = king_square(state, perspective);
+		std::array<const int16_t *, 2> added;
+		std::array<const int16_t *, 3> removed;
+		for (size_t i = 0; i < changes.added_count; i++)
+			added[i] = feature_column(perspective, king, changes.added[i]);
+		for (size_t i = 0; i < changes.removed_count; i++)
+			removed[i] = feature_column(perspective, king, changes.removed[i]);
+
+		apply_columns(acc.values[perspective].data(),
+		              added.data(),
+		              changes.added_count,
+		              removed.data(),
+		              changes.removed_count);
+	}
+}
+
+#pragma endregion ACCUMULATOR
+
+#pragma region INFERENCE
+
+#ifdef NNUE_AVX2
+__attribute__((target("avx2"))) static int32_t output_layer_avx2(const int16_t *values, const int8_t *weights)
+{
+	const __m256i zero = _mm256_setzero_si256();
+	const __m256i max  = _mm256_set1_epi16(ACTIVATION_MAX);
+	__m256i       sum  = _mm256_setzero_si256();
+
+	for (size_t i = 0; i < HIDDEN; i += 16)
+	{
+		__m256i hidden = _mm256_load_si256(reinterpret_cast<const __m256i *>(values + i));
+		hidden         = _mm256_min_epi16(_mm256_max_epi16(hidden, zero), max);
+		__m256i weight = _mm256_cvtepi8_epi16(_mm_loadu_si128(reinterpret_cast<const __m128i *>(weights + i)));
+		sum            = _mm256_add_epi32(sum, _mm256_madd_epi16(hidden, weight));
+	}
+
+	__m128i half = _mm_add_epi32(_mm256_castsi256_si128(sum), _mm256_extracti128_si256(sum, 1));
+	half         = _mm_add_epi32(half, _mm_shuffle_epi32(half, 0b01001110));
+	half         = _mm_add_epi32(half, _mm_shuffle_epi32(half, 0b10110001));
+	return _mm_cvtsi128_si32(half);
+}
+#endif
+
+// Dot product of the clipped hidden layer with the output weights.
+static int32_t output_layer(const int16_t *values, const int8_t *weights)
+{
+#ifdef NNUE_AVX2
+	if (has_avx2) return output_layer_avx2(values, weights);
+#endif
+	int32_t sum = 0;
+	for (size_t i = 0; i < HIDDEN; i++)
+		sum += std::clamp<int32_t>(values[i], 0, ACTIVATION_MAX) * (int32_t) weights[i];
+	return sum;
+}
+
+eval_t evaluate(const Board &state)
+{
+	const accumulator &acc  = state.get_accumulator();
+	const color_t      us   = state.turn_to_move();
+	const color_t      them = invert_color(us);
+
+	int32_t output  = net.output_bias;
+	output         += output_layer(acc.values[us].data(), net.output_weights);
+	output         += output_layer(acc.values[them].data(), net.output_weights + HIDDEN);
+
+	return output * EVAL_SCALE / (ACTIVATION_MAX * WEIGHT_SCALE);
+}
+
+#pragma endregion INFERENCE
+
+} // namespace evaluation::nnue
\ No newline at end of file
@@ -0,0 +1,141 @@
+#include "pawn_structure.hpp"
+
+#include "board.hpp"
+
+#include <algorithm>
+#include <bit>
+
+namespace evaluation::hce::pawns
+{
+
+// Multiplies a packed score by the number of pawns in `bb`.
+inline packed_eval_t count_score(bitboard::bitboard bb, packed_eval_t value)
+{
+	return (packed_eval_t) bb.count() * value;
+}
+
+struct side_structure
+{
+	packed_eval_t      score;
+	bitboard::bitboard passed;
+	bitboard::bitboard attack_span;
+};
+
+// Evaluates one side's pawns. Both boards are seen from that side, so "our" pawns always move north.
+side_structure evaluate_side(bitboard::bitboard ours, bitboard::bitboard theirs)
+{
+	const bitboard::bitboard our_stops     = bitboard::north(ours);
+	const bitboard::bitboard our_attacks   = bitboard::east(our_stops) | bitboard::west(our_stops);
+	const bitboard::bitboard their_attacks = bitboard::east(bitboard::south(theirs))
+	                                         | bitboard::west(bitboard::south(theirs));
+	const bitboard::bitboard our_span      = bitboard::north_fill(our_attacks);
+	const bitboard::bitboard our_files     = bitboard::file_fill(ours);
+
+	// Squares the enemy pawns block, or can capture on, as they advance.
+	const bitboard::bitboard their_front = bitboard::south_fill(bitboard::south(theirs));
+	const bitboard::bitboard their_span  = bitboard::south_fill(their_attacks);
+
+	// Pawns with another one of ours behind them, and pawns with another one of ours in front of them.
+	const bitboard::bitboard doubled     = ours & bitboard::north(bitboard::north_fill(ours));
+	const bitboard::bitboard own_blocked = ours & bitboard::south(bitboard::south_fill(ours));
+
+	const bitboard::bitboard isolated  = ours & ~(bitboard::east(our_files) | bitboard::west(our_files));
+	const bitboard::bitboard connected = ours & (our_attacks | bitboard::east(ours) | bitboard::west(ours));
+	// Pawns whose stop square is covered by an enemy pawn, and which no pawn of ours can ever support.
+	const bitboard::bitboard backward  = ours & bitboard::south(our_stops & their_attacks & ~our_span);
+	const bitboard::bitboard passed    = ours & ~(their_front | their_span | own_blocked);
+
+	side_structure result{ 0, passed, our_span };
+	result.score += count_score(isolated, pawn_values::ISOLATED);
+	result.score += count_score(doubled, pawn_values::DOUBLED);
+	result.score += count_score(backward, pawn_values::BACKWARD);
+	result.score += count_score(connected, pawn_values::CONNECTED);
+	for (size_t rank = 1; rank < 7; rank++)
+		result.score += count_score(passed & (bitboard::rank_1 << (rank * 8)), pawn_values::PASSED[rank]);
+
+	return result;
+}
+
+entry evaluate_structure(bitboard::bitboard white_pawns, bitboard::bitboard black_pawns)
+{
+	// Black's pawns are evaluated on a flipped board, so they move north as well.
+	const side_structure white = evaluate_side(white_pawns, black_pawns);
+	const side_structure black = evaluate_side(bitboard::flip_vertical(black_pawns),
+	                                           bitboard::flip_vertical(white_pawns));
+
+	entry result;
+	result.score              = white.score - black.score;
+	result.passed[WHITE]      = white.passed;
+	result.passed[BLACK]      = bitboard::flip_vertical(black.passed);
+	result.attack_span[WHITE] = white.attack_span;
+	result.attack_span[BLACK] = bitboard::flip_vertical(black.attack_span);
+	return result;
+}
+
+std::array<packed_eval_t, 2> side_scores(bitboard::bitboard white_pawns, bitboard::bitboard black_pawns)
+{
+	const side_structure white = evaluate_side(white_pawns, black_pawns);
+	const side_structure black = evaluate_side(bitboard::flip_vertical(black_pawns),
+	                                           bitboard::flip_vertical(white_pawns));
+	return { white.score, black.score };
+}
+
+// Scores the pawns in front of the king. Both boards are seen from the king's side.
+packed_eval_t evaluate_shelter(bitboard::bitboard ours, bitboard::bitboard king)
+{
+	const bitboard::bitboard king_files = king | bitboard::east(king) | bitboard::west(king);
+	const bitboard::bitboard near       = bitboard::north(king_files);
+	const bitboard::bitboard far        = bitboard::north(near);
+	const bitboard::bitboard open_files = bitboard::file_fill(king_files) & ~bitboard::file_fill(ours);
+
+	packed_eval_t score  = 0;
+	score               += count_score(ours & near, pawn_values::SHIELD_NEAR);
+	score               += count_score(ours & far, pawn_values::SHIELD_FAR);
+	score               += count_score(open_files & bitboard::rank_1, pawn_values::OPEN_NEAR_KING);
+	return score;
+}
+
+packed_eval_t king_shelter(entry &pawn_entry, const Board &state, color_t color)
+{
+	const bitboard::piece_boards &pieces = state.bitboards[color].pieces;
+	const uint8_t                 king   = std::countr_zero(pieces.kings.bits);
+
+	if (pawn_entry.shelter_king[color] != king)
+	{
+		bitboard::bitboard ours = pieces.pawns, king_board = pieces.kings;
+		if (color == BLACK)
+		{
+			ours       = bitboard::flip_vertical(ours);
+			king_board = bitboard::flip_vertical(king_board);
+		}
+		pawn_entry.shelter[color]      = evaluate_shelter(ours, king_board);
+		pawn_entry.shelter_king[color] = king;
+	}
+
+	return pawn_entry.shelter[color];
+}
+
+// A fresh entry has a zero key and a zero score, which is exactly right for a board without pawns.
+table::table(size_t size_bits) : entries(1ULL << size_bits), mask((1ULL << size_bits) - 1) {}
+
+entry &table::probe(const Board &state, bool &hit)
+{
+	const zobrist::hash_t key        = state.get_pawn_hash();
+	entry                &pawn_entry = this->entries[key & this->mask];
+
+	hit = pawn_entry.key == key;
+	if (!hit)
+	{
+		const bitboard::bitboard white_pawns = state.bitboards[WHITE].pieces.pawns;
+		const bitboard::bitboard black_pawns = state.bitboards[BLACK].pieces.pawns;
+
+		pawn_entry     = evaluate_structure(white_pawns, black_pawns);
+		pawn_entry.key = key;
+	}
+
+	return pawn_entry;
+}
+
+void table::clear() { std::fill(this->entries.begin(), this->entries.end(), entry{}); }
+
+} // namespace evaluation::hce::pawns
\ No newline at end of file
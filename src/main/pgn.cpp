@@ -0,0 +1,439 @@
+#include "pgn.hpp"
+
+#include "fen.hpp"
+#include "mapped_file.hpp"
+#include "move_generation.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <cstdlib>
+#include <tbb/parallel_for.h>
+#include <tbb/task_arena.h>
+
+namespace pgn
+{
+
+#pragma region TOKENIZER
+
+static bool is_space(char c) { return c == ' ' || c == '\t' || c == '\n' || c == '\r' || c == '\f' || c == '\v'; }
+static bool is_digit(char c) { return c >= '0' && c <= '9'; }
+// Characters that end a symbol because they start a token of their own.
+static bool is_delimiter(char c)
+{
+	return is_space(c) || c == '[' || c == ']' || c == '{' || c == '}' || c == '(' || c == ')' || c == ';' || c == '$';
+}
+
+token tokenizer::next()
+{
+	const size_t size = this->text.size();
+	for (;;)
+	{
+		while (this->position < size && is_space(this->text[this->position])) this->position++;
+		if (this->position == size) return token{};
+
+		// A percent sign at the start of a line escapes the whole line.
+		if (this->text[this->position] != '%' || (this->position != 0 && this->text[this->position - 1] != '\n'))
+			break;
+		const size_t line_end = this->text.find('\n', this->position);
+		this->position        = line_end == std::string_view::npos ? size : line_end;
+	}
+
+	const size_t start = this->position;
+	auto         until = [&](size_t end, token_type type, size_t skip_start, size_t skip_end)
+	{
+		if (end == std::string_view::npos) end = size;
+		this->position = std::min(end + skip_end, size);
+		return token{ type, this->text.substr(start + skip_start, end - start - skip_start) };
+	};
+
+	switch (this->text[start])
+	{
+	case '[':
+	{
+		// The tag's value is quoted and may contain an escaped quote or a closing bracket.
+		size_t end    = start + 1;
+		bool   quoted = false;
+		for (; end < size && (quoted || this->text[end] != ']'); end++)
+		{
+			if (this->text[end] == '"') quoted = !quoted;
+			else if (this->text[end] == '\\' && quoted) end++;
+		}
+		return until(std::min(end, size), token_type::TAG, 1, 1);
+	}
+	case '{': return until(this->text.find('}', start), token_type::COMMENT, 1, 1);
+	case ';': return until(this->text.find('\n', start), token_type::COMMENT, 1, 0);
+	case '(': this->position++; return token{ token_type::VARIATION_START, this->text.substr(start, 1) };
+	case ')': this->position++; return token{ token_type::VARIATION_END, this->text.substr(start, 1) };
+	case '*': this->position++; return token{ token_type::RESULT, this->text.substr(start, 1) };
+	case '$':
+	{
+		size_t end = start + 1;
+		while (end < size && is_digit(this->text[end])) end++;
+		return until(end, token_type::NAG, 1, 0);
+	}
+	}
+
+	size_t end = start;
+	while (end < size && !is_delimiter(this->text[end])) end++;
+	const std::string_view symbol = this->text.substr(start, end - start);
+
+	if (symbol == "1-0" || symbol == "0-1" || symbol == "1/2-1/2") return until(end, token_type::RESULT, 0, 0);
+
+	// Move numbers may run straight into the move, like "1.e4".
+	size_t digits = start;
+	while (digits < end && is_digit(this->text[digits])) digits++;
+	if (digits != start && digits < end && this->text[digits] == '.')
+	{
+		while (digits < end && this->text[digits] == '.') digits++;
+		return until(digits, token_type::MOVE_NUMBER, 0, 0);
+	}
+
+	return until(end, token_type::SYMBOL, 0, 0);
+}
+
+#pragma endregion TOKENIZER
+
+#pragma region SAN
+
+static int file_index(char c) { return c >= 'a' && c <= 'h' ? c - 'a' : -1; }
+static int rank_index(char c) { return c >= '1' && c <= '8' ? c - '1' : -1; }
+
+static PieceType piece_from_letter(char c)
+{
+	switch (c)
+	{
+	case 'N': return PieceType::KNIGHT;
+	case 'B': return PieceType::BISHOP;
+	case 'R': return PieceType::ROOK;
+	case 'Q': return PieceType::QUEEN;
+	case 'K': return PieceType::KING;
+	default:  return PieceType::NONE;
+	}
+}
+
+// Squares holding one of `color`'s sliders of type `type` that see `to`, found by walking outwards from `to`.
+static bitboard::bitboard slider_origins(const Board &board, uint8_t to, PieceType type, color_t color)
+{
+	const bitboard::bitboard occupied = board.bitboards[WHITE].pieces.all_pieces
+	                                    | board.bitboards[BLACK].pieces.all_pieces;
+	bitboard::bitboard origins;
+
+	// The first four directions are straight, the other four diagonal.
+	for (size_t direction = 0; direction < DIRECTION_OFFSETS.size(); direction++)
+	{
+		const bool straight = direction < 4;
+		if ((straight && type == PieceType::BISHOP) || (!straight && type == PieceType::ROOK)) continue;
+
+		int square = to;
+		for (size_t step = 0; step < NUM_SQUARES_TO_EDGE[to][direction]; step++)
+		{
+			square += (int) DIRECTION_OFFSETS[direction];
+			if (!occupied.test(square)) continue;
+
+			const piece_set_t::iterator piece = board.piece_board[square];
+			if (piece->get_color() == color && *piece == type) origins.set(square);
+			break;
+		}
+	}
+	return origins;
+}
+
+static std::optional<Move> parse_castle(const Board &board, std::string_view san)
+{
+	const bool queenside = san == "O-O-O" || san == "0-0-0";
+	if (!queenside && san != "O-O" && san != "0-0") return std::nullopt;
+
+	const uint8_t king = std::countr_zero(board.bitboards[board.turn_to_move()].pieces.kings.bits);
+	if (king >= 64) return std::nullopt;
+
+	const Move move = queenside ? Move(king, king - 2, move_flags::QUEENSIDE_CASTLE)
+	                            : Move(king, king + 2, move_flags::KINGSIDE_CASTLE);
+	if (!is_legal(board, move)) return std::nullopt;
+	return move;
+}
+
+static std::optional<Move> parse_pawn_move(const Board &board, int to, int from_file, int from_rank, int promotion)
+{
+	const color_t us      = board.turn_to_move();
+	const int     forward = us == WHITE ? 8 : -8;
+	const bool    last    = get_rank_from_square(to) == (us == WHITE ? 7u : 0u);
+	if (last != (promotion >= 0)) return std::nullopt;
+
+	const bitboard::bitboard occupied = board.bitboards[WHITE].pieces.all_pieces
+	                                    | board.bitboards[BLACK].pieces.all_pieces;
+	int      from  = to - forward;
+	uint16_t flags = move_flags::QUIET_MOVE;
+
+	if (from_file >= 0 && from_file != (int) get_file_from_square(to))
+	{
+		if (std::abs(from_file - (int) get_file_from_square(to)) != 1) return std::nullopt;
+		from += from_file - (int) get_file_from_square(to);
+		flags = to == board.get_en_passant_target() ? move_flags::EN_PASSANT : move_flags::NORMAL_CAPTURE;
+	}
+	else if (inside_board(from) && !occupied.test(from)
+	         && get_rank_from_square(to) == (us == WHITE ? 3u : 4u))
+	{
+		from -= forward;
+		flags = move_flags::DOUBLE_PAWN_PUSH;
+	}
+
+	if (!inside_board(from) || (from_rank >= 0 && (int) get_rank_from_square(from) != from_rank))
+		return std::nullopt;
+	if (promotion >= 0) flags = (flags & move_flags::CAPTURE) | move_flags::PROMOTION | promotion;
+
+	const Move move(from, to, flags);
+	if (!is_legal(board, move)) return std::nullopt;
+	return move;
+}
+
+std::optional<Move> parse_san(const Board &board, std::string_view san)
+{
+	while (!san.empty() && (san.back() == '+' || san.back() == '#' || san.back() == '!' || san.back() == '?'))
+		san.remove_suffix(1);
+	if (san.size() < 2) return std::nullopt;
+	if (san[0] == 'O' || san[0] == '0') return parse_castle(board, san);
+
+	// Some writers put a lowercase letter after the equals sign.
+	char letter = san.back();
+	if (san[san.size() - 2] == '=' && letter >= 'a' && letter <= 'z') letter += 'A' - 'a';
+
+	int promotion = -1;
+	if (const PieceType promoted = piece_from_letter(letter); promoted != PieceType::NONE)
+	{
+		switch (promoted)
+		{
+		case PieceType::KNIGHT: promotion = move_flags::KNIGHT; break;
+		case PieceType::BISHOP: promotion = move_flags::BISHOP; break;
+		case PieceType::ROOK:   promotion = move_flags::ROOK; break;
+		case PieceType::QUEEN:  promotion = move_flags::QUEEN; break;
+		default:                return std::nullopt;
+		}
+		san.remove_suffix(1);
+		if (!san.empty() && san.back() == '=') san.remove_suffix(1);
+		if (san.size() < 2) return std::nullopt;
+	}
+
+	const int to_file = file_index(san[san.size() - 2]);
+	const int to_rank = rank_index(san[san.size() - 1]);
+	if (to_file < 0 || to_rank < 0) return std::nullopt;
+	const int to = to_rank * 8 + to_file;
+	san.remove_suffix(2);
+
+	PieceType type = PieceType::PAWN;
+	if (!san.empty() && piece_from_letter(san[0]) != PieceType::NONE)
+	{
+		type = piece_from_letter(san[0]);
+		san.remove_prefix(1);
+	}
+	// Whether a move captures follows from the board, so the capture sign (or a long form's dash) isn't needed.
+	if (!san.empty() && (san.back() == 'x' || san.back() == ':' || san.back() == '-')) san.remove_suffix(1);
+
+	int from_file = -1, from_rank = -1;
+	for (char c : san)
+	{
+		if (file_index(c) >= 0 && from_file < 0) from_file = file_index(c);
+		else if (rank_index(c) >= 0 && from_rank < 0) from_rank = rank_index(c);
+		else return std::nullopt;
+	}
+
+	if (type == PieceType::PAWN) return parse_pawn_move(board, to, from_file, from_rank, promotion);
+	if (promotion >= 0) return std::nullopt;
+
+	const color_t                 us   = board.turn_to_move();
+	const bitboard::piece_boards &ours = board.bitboards[us].pieces;
+	bitboard::bitboard            origins;
+	switch (type)
+	{
+	case PieceType::KNIGHT: origins = KNIGHT_MOVES[to] & ours.knights; break;
+	case PieceType::KING:   origins = KING_MOVES[to] & ours.kings; break;
+	default:                origins = slider_origins(board, to, type, us); break;
+	}
+	if (from_file >= 0) origins &= bitboard::file_a << from_file;
+	if (from_rank >= 0) origins &= bitboard::rank_1 << (8 * from_rank);
+
+	const uint16_t flags = board.bitboards[invert_color(us)].pieces.all_pieces.test(to) ? move_flags::NORMAL_CAPTURE
+	                                                                                    : move_flags::QUIET_MOVE;
+	std::optional<Move> found;
+	for (uint64_t remaining = origins.bits; remaining != 0; remaining &= remaining - 1)
+	{
+		const Move move(std::countr_zero(remaining), to, flags);
+		if (!is_legal(board, move)) continue;
+		// An ambiguous move can't be told apart from the other one, so it counts as invalid.
+		if (found.has_value()) return std::nullopt;
+		found = move;
+	}
+	return found;
+}
+
+#pragma endregion SAN
+
+#pragma region READER
+
+std::string_view game::tag_value(std::string_view name) const
+{
+	for (const tag &t : this->tags)
+		if (t.name == name) return t.value;
+	return {};
+}
+
+std::string_view game::start_fen() const
+{
+	const std::string_view fen = this->tag_value("FEN");
+	return fen.empty() ? std::string_view(START_FEN) : fen;
+}
+
+// Splits `Name "value"` into its name and value.
+static tag parse_tag(std::string_view text)
+{
+	size_t name_end = 0;
+	while (name_end < text.size() && !is_space(text[name_end])) name_end++;
+
+	const size_t value_start = text.find('"', name_end);
+	const size_t value_end   = text.rfind('"');
+	if (value_start == std::string_view::npos || value_end <= value_start) return tag{ text.substr(0, name_end), {} };
+	return tag{ text.substr(0, name_end), text.substr(value_start + 1, value_end - value_start - 1) };
+}
+
+bool reader::next(game &result)
+{
+	result.tags.clear();
+	result.moves.clear();
+	result.result = {};
+	result.valid  = true;
+
+	bool   started     = false;
+	bool   in_movetext = false;
+	size_t depth       = 0;
+
+	// The start position is only known once every tag has been read.
+	auto start_movetext = [&]
+	{
+		if (in_movetext) return;
+		in_movetext = true;
+		result.valid = this->board.set_fen(result.start_fen());
+		if (result.valid) this->board.update_bitboards();
+	};
+
+	for (;;)
+	{
+		const size_t offset = this->tokens.offset();
+		const token  t      = this->tokens.next();
+		switch (t.type)
+		{
+		case token_type::END:
+			if (started) start_movetext();
+			return started;
+
+		case token_type::TAG:
+			// Without a result, the next game's tags are what ends this one.
+			if (in_movetext)
+			{
+				this->tokens.rewind(offset);
+				return true;
+			}
+			result.tags.push_back(parse_tag(t.text));
+			started = true;
+			break;
+
+		case token_type::COMMENT:
+		case token_type::NAG:         break;
+		case token_type::MOVE_NUMBER: start_movetext(); break;
+
+		case token_type::VARIATION_START:
+			start_movetext();
+			depth++;
+			break;
+		case token_type::VARIATION_END:
+			if (depth > 0) depth--;
+			break;
+
+		case token_type::RESULT:
+			if (depth > 0) break;
+			start_movetext();
+			result.result = t.text;
+			return true;
+
+		case token_type::SYMBOL:
+		{
+			started = true;
+			start_movetext();
+			if (depth > 0 || !result.valid || t.text == "e.p.") break;
+
+			const std::optional<Move> move = parse_san(this->board, t.text);
+			if (!move.has_value())
+			{
+				result.valid = false;
+				break;
+			}
+			result.moves.push_back(move.value());
+			this->board.make_move(move.value());
+			break;
+		}
+		}
+	}
+}
+
+// The start of the first game beginning at or after `from`: a tag at the start of a line that doesn't follow
+// another tag line.
+static size_t find_game_start(std::string_view text, size_t from)
+{
+	for (size_t bracket = text.find("\n[", from); bracket != std::string_view::npos;
+	     bracket        = text.find("\n[", bracket + 1))
+	{
+		const size_t     line_start = bracket == 0 ? 0 : text.rfind('\n', bracket - 1) + 1;
+		std::string_view previous   = text.substr(line_start, bracket - line_start);
+		while (!previous.empty() && is_space(previous.back())) previous.remove_suffix(1);
+		if (previous.empty() || previous[0] != '[') return bracket + 1;
+	}
+	return text.size();
+}
+
+std::vector<std::string_view> split_games(std::string_view text, size_t count)
+{
+	std::vector<std::string_view> pieces;
+	size_t                        start = 0;
+	for (size_t i = 1; i <= count && start < text.size(); i++)
+	{
+		const size_t end = i == count ? text.size() : find_game_start(text, std::max(start, text.size() * i / count));
+		if (end > start) pieces.push_back(text.substr(start, end - start));
+		start = end;
+	}
+	return pieces;
+}
+
+size_t read_file(const std::string &path, size_t threads, const std::function<void(const game &)> &visit)
+{
+	const mapped_file file(path);
+	if (!file.is_open()) return 0;
+
+	// More pieces than threads, so a thread that finishes early can take another one.
+	threads                                    = std::max<size_t>(threads, 1);
+	const std::vector<std::string_view> pieces = split_games(std::string_view(file.data(), file.size()), threads * 8);
+	std::atomic<size_t>                 total  = 0;
+
+	tbb::task_arena arena((int) threads);
+	arena.execute(
+	    [&]
+	    {
+		    tbb::parallel_for((size_t) 0,
+		                      pieces.size(),
+		                      [&](size_t i)
+		                      {
+			                      reader pieces_reader(pieces[i]);
+			                      game   current;
+			                      size_t count = 0;
+			                      while (pieces_reader.next(current))
+			                      {
+				                      visit(current);
+				                      count++;
+			                      }
+			                      total += count;
+		                      });
+	    });
+	return total;
+}
+
+#pragma endregion READER
+
+} // namespace pgn
\ No newline at end of file
@@ -0,0 +1,133 @@
+#include "polyglot.hpp"
+
+#include "board.hpp"
+#include "move_generation.hpp"
+
+#include <algorithm>
+#include <bit>
+#include <string_view>
+
+namespace polyglot
+{
+
+uint64_t key(const Board &board)
+{
+	uint64_t hash = 0;
+	for (auto &piece : board.piece_board)
+		if (piece != piece_set_t::null_iterator)
+			hash ^= RANDOM64[64 * piece_kind(piece->get_type(), piece->get_color()) + piece->position()];
+
+	const std::array<Board::CastlingRights, 2> rights = { board.get_white_castling_rights(),
+		                                                  board.get_black_castling_rights() };
+	if (rights[WHITE].kingside) hash ^= RANDOM64[CASTLING_KEYS + 0];
+	if (rights[WHITE].queenside) hash ^= RANDOM64[CASTLING_KEYS + 1];
+	if (rights[BLACK].kingside) hash ^= RANDOM64[CASTLING_KEYS + 2];
+	if (rights[BLACK].queenside) hash ^= RANDOM64[CASTLING_KEYS + 3];
+
+	if (board.can_en_passant())
+	{
+		// The capturing pawns stand beside the pawn that just moved, one rank behind the target square.
+		const color_t  us      = board.turn_to_move();
+		const int16_t  target  = board.get_en_passant_target();
+		const int16_t  behind  = us == WHITE ? target - 8 : target + 8;
+		const uint64_t pawns   = board.bitboards[us].pieces.pawns.bits;
+		const int      file    = target % 8;
+		bool           capture = false;
+		if (file > 0) capture |= (pawns >> (behind - 1)) & 1;
+		if (file < 7) capture |= (pawns >> (behind + 1)) & 1;
+		if (capture) hash ^= RANDOM64[EN_PASSANT_KEYS + file];
+	}
+
+	if (board.turn_to_move() == WHITE) hash ^= RANDOM64[TURN_KEY];
+	return hash;
+}
+
+entry to_native(const entry &stored)
+{
+	if constexpr (std::endian::native == std::endian::big) return stored;
+	return entry{ std::byteswap(stored.key),
+		          std::byteswap(stored.move),
+		          std::byteswap(stored.weight),
+		          std::byteswap(stored.learn) };
+}
+
+// Swapping the byte order is its own inverse.
+entry to_stored(const entry &native) { return to_native(native); }
+
+// The move in the UCI notation `Move::to_uci` writes, like "e7e8q".
+static std::string move_text(uint16_t move, const Board &board)
+{
+	const uint8_t to        = move & 0x3f;
+	const uint8_t from      = (move >> 6) & 0x3f;
+	const uint8_t promotion = (move >> 12) & 0x7;
+
+	uint8_t destination = to;
+	// Castling is stored as the king taking its own rook, the board expects the king's destination.
+	const piece_set_t::iterator piece = board.piece_board[from];
+	if (piece != piece_set_t::null_iterator && *piece == PieceType::KING && (from == 4 || from == 60)
+	    && (to == from + 3 || to == from - 4))
+		destination = to > from ? from + 2 : from - 2;
+
+	std::string text = { (char) ('a' + from % 8), (char) ('1' + from / 8), (char) ('a' + destination % 8),
+		                 (char) ('1' + destination / 8) };
+	if (promotion != 0) text += " nbrq"[promotion];
+	return text;
+}
+
+bool book::open(const std::string &path)
+{
+	mapped_file mapped(path);
+	if (!mapped.is_open() || mapped.size() % sizeof(entry) != 0) return false;
+	this->file = std::move(mapped);
+	return true;
+}
+
+std::vector<book_move> book::moves(const Board &board) const
+{
+	std::vector<book_move> found;
+	if (!this->is_open()) return found;
+
+	// The entries are sorted by key, so a position's moves are one run of entries, found by binary search.
+	const uint64_t position = key(board);
+	const entry   *first    = std::partition_point(this->entries(),
+                                                 this->entries() + this->size(),
+                                                 [&](const entry &e) { return to_native(e).key < position; });
+
+	std::vector<Move> legal_moves;
+	char              buffer[MAX_UCI_LENGTH];
+	for (const entry *stored = first; stored != this->entries() + this->size(); stored++)
+	{
+		const entry book_entry = to_native(*stored);
+		if (book_entry.key != position) break;
+		if (legal_moves.empty()) legal_moves = generate_moves(board);
+
+		// A key collision (or a broken book) could suggest an illegal move, so only legal ones are returned.
+		const std::string text = move_text(book_entry.move, board);
+		for (const Move &move : legal_moves)
+		{
+			if (std::string_view(buffer, move.to_uci(buffer)) != text) continue;
+			found.push_back(book_move{ move, book_entry.weight });
+			break;
+		}
+	}
+	return found;
+}
+
+std::optional<Move> book::pick(const Board &board, std::mt19937_64 &rng) const
+{
+	const std::vector<book_move> candidates = this->moves(board);
+
+	uint32_t total = 0;
+	for (const book_move &candidate : candidates) total += candidate.weight;
+	if (total == 0) return std::nullopt;
+
+	uint32_t roll = std::uniform_int_distribution<uint32_t>(0, total - 1)(rng);
+	for (const book_move &candidate : candidates)
+	{
+		if (roll < candidate.weight) return candidate.move;
+		roll -= candidate.weight;
+	}
+	return std::nullopt;
+}
+
+} // namespace polyglot
\ No newline at end of file
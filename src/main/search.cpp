@@ -1,53 +1,286 @@
 #include "search.hpp"
 
 #include "board.hpp"
+#include "endgame.hpp"
+#include "evaluation.hpp"
 #include "move_generation.hpp"
+#include "transposition.hpp"
 
+#include <algorithm>
 #include <chrono>
-#include <limits>
+#include <mutex>
+#include <tbb/parallel_for.h>
+#include <tbb/task_arena.h>
 
 using evaluation::eval_t;
 using Clock = std::chrono::steady_clock;
 using namespace std::chrono_literals;
 
-eval_t negamax(Board &&board, uint32_t depth)
+// Score for positions that are drawn by repetition or the fifty-move rule.
+constexpr eval_t   DRAW_SCORE       = 0;
+// The clock and the node limit are only checked every this many nodes, since reading the clock isn't free.
+constexpr uint64_t CHECK_INTERVAL   = 1024;
+
+// Evaluation counters of the whole search. The counters themselves are per thread,
+// so every search context adds what its thread counted while it ran.
+struct eval_counters
+{
+	std::mutex                  mutex;
+	evaluation::cache_stats     cache;
+	evaluation::hce::eval_stats hce;
+};
+
+// One search thread's view of the search.
+struct search_context
 {
-	if (depth == 0) return evaluation::hce::evaluate(board);
-	eval_t max = std::numeric_limits<eval_t>::min();
+	search_control        &control;
+	std::atomic<uint64_t> &total_nodes;
+	uint64_t               node_limit;
+	// Nodes not added to `total_nodes` yet.
+	uint64_t               nodes   = 0;
+	bool                   aborted = false;
+
+	eval_counters                    &counters;
+	const evaluation::cache_stats     cache_start = evaluation::get_cache_stats();
+	const evaluation::hce::eval_stats hce_start   = evaluation::hce::get_stats();
+
+	search_context(search_control        &control,
+	               std::atomic<uint64_t> &total_nodes,
+	               uint64_t               node_limit,
+	               eval_counters         &counters)
+	    : control(control), total_nodes(total_nodes), node_limit(node_limit), counters(counters)
+	{
+	}
+	~search_context()
+	{
+		this->flush();
+		std::lock_guard<std::mutex> lock(this->counters.mutex);
+		this->counters.cache += evaluation::get_cache_stats() - this->cache_start;
+		this->counters.hce   += evaluation::hce::get_stats() - this->hce_start;
+	}
+
+	void flush()
+	{
+		this->total_nodes.fetch_add(this->nodes, std::memory_order_relaxed);
+		this->nodes = 0;
+	}
+
+	// Counts a node, and returns true if the search has to stop.
+	bool should_stop()
+	{
+		if (this->aborted) return true;
+		// Checked on every node, so a stop command is seen within microseconds.
+		if (this->control.stop.load(std::memory_order_relaxed)) return this->aborted = true;
+		if (++this->nodes < CHECK_INTERVAL) return false;
+
+		this->flush();
+		const int64_t deadline = this->control.deadline.load(std::memory_order_relaxed);
+		if (deadline != 0 && to_deadline(Clock::now()) >= deadline) this->aborted = true;
+		if (this->node_limit != 0 && this->total_nodes.load(std::memory_order_relaxed) >= this->node_limit)
+			this->aborted = true;
+		return this->aborted;
+	}
+};
+
+int64_t to_deadline(Clock::time_point time)
+{
+	return std::chrono::duration_cast<std::chrono::nanoseconds>(time.time_since_epoch()).count();
+}
+
+// https://www.chessprogramming.org/Alpha-Beta#Negamax_Framework
+eval_t negamax(Board &&board, uint32_t depth, uint32_t ply, eval_t alpha, eval_t beta, search_context &context)
+{
+	if (context.should_stop()) return 0;
+	if (board.is_fifty_move_draw() || board.is_repetition()) return DRAW_SCORE;
+	// Nothing below a known result can change it, so there's no point searching further.
+	const evaluation::endgame::entry *ending = evaluation::endgame::probe(board);
+	if (ending != nullptr && ending->exact) return evaluation::endgame::evaluate(*ending, board);
+	if (depth == 0) return evaluation::evaluate(board, alpha, beta);
+
+	// A result from at least as deep a search settles the position if it's exact or outside the window.
+	// Either way its move is the best guess for which move to search first.
+	transposition::entry stored;
+	const bool           hit = transposition::probe(board.get_hash(), ply, stored);
+	if (hit && stored.depth >= depth)
+	{
+		if (stored.type == transposition::bound::EXACT) return std::clamp(stored.score, alpha, beta);
+		if (stored.type == transposition::bound::LOWER && stored.score >= beta) return beta;
+		if (stored.type == transposition::bound::UPPER && stored.score <= alpha) return alpha;
+	}
 
 	std::vector<Move> legal_moves = generate_moves(board);
+	if (legal_moves.empty()) return board.is_in_check() ? -MATE_SCORE + (eval_t) ply : DRAW_SCORE;
 
+	if (hit && !stored.move.empty())
+	{
+		const auto first = std::find(legal_moves.begin(), legal_moves.end(), stored.move);
+		if (first != legal_moves.end()) std::rotate(legal_moves.begin(), first, first + 1);
+	}
+
+	const eval_t original_alpha = alpha;
+	Move         best_move;
 	for (auto &move : legal_moves)
 	{
 		board.make_move(move);
-		eval_t score = -negamax(std::forward<Board>(board), depth - 1);
+		eval_t score = -negamax(std::forward<Board>(board), depth - 1, ply + 1, -beta, -alpha, context);
 		board.unmake_move();
-		if (score > max) max = score;
+		if (context.aborted) return 0;
+		if (score >= beta)
+		{
+			transposition::store(board.get_hash(), ply, { beta, move, (uint8_t) depth, transposition::bound::LOWER });
+			return beta;
+		}
+		if (score > alpha)
+		{
+			alpha     = score;
+			best_move = move;
+		}
 	}
 
-	return max;
+	const transposition::bound type = alpha > original_alpha ? transposition::bound::EXACT
+	                                                         : transposition::bound::UPPER;
+	transposition::store(board.get_hash(), ply, { alpha, best_move, (uint8_t) depth, type });
+	return alpha;
 }
 
-search_result get_best_move(const Board &board, uint32_t depth, std::chrono::milliseconds max_time)
+struct root_result
 {
-	search_result result{ 0ms, std::numeric_limits<eval_t>::min(), Move{} };
-	std::vector<Move> legal_moves = generate_moves(board);
-	Board board_copy = board;
-	std::chrono::steady_clock::time_point start = Clock::now(), end;
+	eval_t score = -INFINITE_SCORE;
+	Move   move;
+	size_t index = 0;
+};
 
-	for (auto &move : legal_moves)
+// Searches every root move to `depth`, sharing them out between the control's threads.
+// `best` is filled with the best `limits.multipv` moves, best first.
+// Returns false if the search was stopped before every move was done.
+static bool search_root(const Board              &board,
+                        const std::vector<Move>  &moves,
+                        uint32_t                  depth,
+                        const search_limits      &limits,
+                        search_control           &control,
+                        std::atomic<uint64_t>    &total_nodes,
+                        eval_counters            &counters,
+                        std::vector<root_result> &best)
+{
+	std::mutex          best_mutex;
+	// Moves have to beat the worst of the best moves found so far, so the window only closes once there are enough.
+	std::atomic<eval_t> alpha{ -INFINITE_SCORE };
+	std::atomic<bool>   aborted{ false };
+
+	// Ties go to the earlier move, so the result doesn't depend on which thread finished first.
+	const auto is_better = [](const root_result &a, const root_result &b)
+	{ return a.score > b.score || (a.score == b.score && a.index < b.index); };
+
+	const auto search_move = [&](size_t index)
 	{
-		eval_t score = -negamax(board.simulate_move(move), depth - 1);
-		if (score > result.score)
+		if (aborted.load(std::memory_order_relaxed)) return;
+		search_context context(control, total_nodes, limits.nodes, counters);
+
+		const Move   move   = moves[index];
+		const eval_t window = alpha.load();
+		eval_t       score  = -negamax(board.simulate_move(move), depth - 1, 1, -INFINITE_SCORE, -window, context);
+
+		// The search is fail-hard, so a score at the window's edge only says the move is no better than that.
+		// That bound must not take a place from a real score, which it could tie with. If the move would win the
+		// tie, it's searched again with an open window, otherwise it can't make it into the best moves anyway.
+		if (!context.aborted && window != -INFINITE_SCORE && score <= window)
 		{
-			result.score = score;
-			result.move = move;
+			{
+				std::lock_guard<std::mutex> lock(best_mutex);
+				if (best.back().score > score || best.back().index < index) return;
+			}
+			score = -negamax(board.simulate_move(move), depth - 1, 1, -INFINITE_SCORE, INFINITE_SCORE, context);
 		}
+		if (context.aborted)
+		{
+			aborted = true;
+			return;
+		}
+
+		std::lock_guard<std::mutex> lock(best_mutex);
+		const root_result result{ score, move, index };
+		if (best.size() == limits.multipv && !is_better(result, best.back())) return;
+
+		best.insert(std::upper_bound(best.begin(), best.end(), result, is_better), result);
+		if (best.size() > limits.multipv) best.pop_back();
+		if (best.size() == limits.multipv) alpha = std::max(alpha.load(), best.back().score);
+	};
 
-		end = Clock::now();
-		if (max_time != 0ms && end - start > max_time) break;
+	if (control.threads <= 1)
+		for (size_t i = 0; i < moves.size(); i++) search_move(i);
+	else
+	{
+		tbb::task_arena arena((int) control.threads);
+		arena.execute([&] { tbb::parallel_for((size_t) 0, moves.size(), search_move); });
 	}
 
-	result.search_time = std::chrono::duration_cast<std::chrono::milliseconds>(end - start + 500us);
+	return !aborted;
+}
+
+search_result search(const Board &board, const search_limits &limits, search_control &control)
+{
+	const Clock::time_point start = Clock::now();
+	if (limits.time != 0ms)
+	{
+		const int64_t limit_deadline = to_deadline(start + limits.time);
+		const int64_t deadline       = control.deadline.load();
+		if (deadline == 0 || limit_deadline < deadline) control.deadline = limit_deadline;
+	}
+
+	std::vector<Move>     moves = generate_moves(board);
+	std::atomic<uint64_t> total_nodes{ 0 };
+	eval_counters         counters;
+	search_result         result;
+	result.search_time = 0ms;
+	result.score       = -INFINITE_SCORE;
+	result.move        = moves.empty() ? Move{} : moves.front();
+
+	search_limits root_limits = limits;
+	root_limits.multipv       = std::clamp<size_t>(limits.multipv, 1, std::max<size_t>(moves.size(), 1));
+
+	const uint32_t max_depth = limits.depth == 0 ? MAX_DEPTH : std::min(limits.depth, MAX_DEPTH);
+	for (uint32_t depth = 1; depth <= max_depth && !moves.empty(); depth++)
+	{
+		std::vector<root_result> best;
+		if (!search_root(board, moves, depth, root_limits, control, total_nodes, counters, best)) break;
+
+		result.score       = best.front().score;
+		result.move        = best.front().move;
+		result.depth       = depth;
+		result.nodes       = total_nodes.load();
+		result.search_time = std::chrono::duration_cast<std::chrono::milliseconds>(Clock::now() - start);
+		result.lines.clear();
+		for (const root_result &line : best) result.lines.push_back(pv_line{ line.move, line.score });
+		if (control.on_iteration) control.on_iteration(result);
+
+		// The best moves so far get searched first next time, in order, which gives the other moves a tighter window.
+		std::vector<Move> ordered;
+		ordered.reserve(moves.size());
+		for (const root_result &line : best) ordered.push_back(line.move);
+		for (size_t i = 0; i < moves.size(); i++)
+			if (std::none_of(best.begin(), best.end(), [&](const root_result &line) { return line.index == i; }))
+				ordered.push_back(moves[i]);
+		moves = std::move(ordered);
+
+		if (is_mate_score(result.score)) break;
+		// With only one legal move there's nothing to decide, so don't spend the clock on it.
+		const int64_t deadline = control.deadline.load();
+		if (deadline != 0 && moves.size() == 1) break;
+		// Each iteration takes longer than all the ones before it together,
+		// so there's no point starting another one past half the time.
+		const int64_t started  = to_deadline(start);
+		if (deadline != 0 && to_deadline(Clock::now()) - started > (deadline - started) / 2) break;
+	}
+
+	result.nodes       = total_nodes.load();
+	result.search_time = std::chrono::duration_cast<std::chrono::milliseconds>(Clock::now() - start + 500us);
+	result.eval_cache  = counters.cache;
+	result.eval_stats  = counters.hce;
 	return result;
+}
+
+search_result get_best_move(const Board &board, uint32_t depth, std::chrono::milliseconds max_time)
+{
+	search_control control;
+	return search(board, search_limits{ depth, 0, max_time }, control);
 }
\ No newline at end of file
@@ -0,0 +1,304 @@
+#include "transposition.hpp"
+
+#include "search.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <cerrno>
+#include <filesystem>
+#include <fstream>
+#include <memory>
+
+#if defined(__unix__) || defined(__APPLE__)
+#define TRANSPOSITION_USE_MMAP
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace transposition
+{
+
+// Lockless hashing, just like the evaluation cache: https://www.chessprogramming.org/Shared_Hash_Table#Lockless
+// Each entry stores the key xor-ed with the data, so an entry torn by two threads writing
+// at once no longer matches its key and just reads as a miss.
+struct table_entry
+{
+	std::atomic<uint64_t> check{ 0 };
+	std::atomic<uint64_t> data{ 0 };
+};
+
+static_assert(sizeof(table_entry) == 16 && std::atomic<uint64_t>::is_always_lock_free,
+              "Table files are used in place, so entries have to be two plain 64-bit words.");
+static_assert(sizeof(file_header) == 64);
+
+struct table
+{
+	// Owns the entries, whether they were allocated or mapped from a file.
+	std::shared_ptr<void> storage;
+	table_entry          *entries     = nullptr;
+	size_t                mask        = 0;
+	bool                  file_backed = false;
+	// The file the table was opened or loaded from, if any.
+	std::string           path;
+};
+
+// Rounds down to a power of two entries, so indexing is just a mask.
+static size_t entry_count(size_t megabytes)
+{
+	return std::bit_floor(std::max<size_t>(megabytes * 1024 * 1024 / sizeof(table_entry), 1));
+}
+
+static table make_table(size_t megabytes)
+{
+	const size_t                   entries = entry_count(megabytes);
+	std::shared_ptr<table_entry[]> memory(new table_entry[entries]);
+	return table{ memory, memory.get(), entries - 1, false, {} };
+}
+
+static table current = make_table(DEFAULT_SIZE_MB);
+
+#pragma region ENTRIES
+
+// The data word holds the score in bits 0-31, the move in bits 32-47, the depth in bits 48-55
+// and the bound in bits 56-57. Empty entries have no bound, so they never match.
+static uint64_t pack(const entry &data)
+{
+	return (uint64_t) (uint32_t) data.score | (uint64_t) data.move.get_from() << 32
+	       | (uint64_t) data.move.get_to() << 38 | (uint64_t) data.move.get_flags() << 44
+	       | (uint64_t) data.depth << 48 | (uint64_t) data.type << 56;
+}
+
+static entry unpack(uint64_t data)
+{
+	return entry{ (eval_t) (uint32_t) data,
+	              Move((data >> 32) & 0x3f, (data >> 38) & 0x3f, (data >> 44) & 0xf),
+	              (uint8_t) (data >> 48),
+	              (bound) ((data >> 56) & 0b11) };
+}
+
+// Mate scores count plies from the root, but a position can be reached at any ply,
+// so they are stored counting from the position itself.
+static eval_t to_stored(eval_t score, uint32_t ply)
+{
+	if (!is_mate_score(score)) return score;
+	return score > 0 ? score + (eval_t) ply : score - (eval_t) ply;
+}
+
+static eval_t from_stored(eval_t score, uint32_t ply)
+{
+	if (!is_mate_score(score)) return score;
+	return score > 0 ? score - (eval_t) ply : score + (eval_t) ply;
+}
+
+bool probe(zobrist::hash_t key, uint32_t ply, entry &found)
+{
+	const table_entry &slot  = current.entries[key & current.mask];
+	const uint64_t     data  = slot.data.load(std::memory_order_relaxed);
+	const uint64_t     check = slot.check.load(std::memory_order_relaxed);
+
+	if ((check ^ data) != key || (data >> 56) == (uint64_t) bound::NONE) return false;
+	found       = unpack(data);
+	found.score = from_stored(found.score, ply);
+	return true;
+}
+
+void store(zobrist::hash_t key, uint32_t ply, const entry &data)
+{
+	table_entry   &slot     = current.entries[key & current.mask];
+	const uint64_t old_data = slot.data.load(std::memory_order_relaxed);
+	const bool     same     = (slot.check.load(std::memory_order_relaxed) ^ old_data) == key;
+
+	entry stored = data;
+	stored.score = to_stored(data.score, ply);
+	if (same)
+	{
+		const entry old = unpack(old_data);
+		// A deeper result for the same position is worth more, unless the new one is exact.
+		if (old.depth > data.depth && data.type != bound::EXACT) return;
+		// A result without a best move still shouldn't forget the one found earlier.
+		if (stored.move.empty()) stored.move = old.move;
+	}
+
+	const uint64_t packed = pack(stored);
+	slot.check.store(key ^ packed, std::memory_order_relaxed);
+	slot.data.store(packed, std::memory_order_relaxed);
+}
+
+size_t get_size() { return (current.mask + 1) * sizeof(table_entry) / (1024 * 1024); }
+
+bool is_file_backed() { return current.file_backed; }
+
+bool is_from_file() { return !current.path.empty(); }
+
+void clear()
+{
+	for (size_t i = 0; i <= current.mask; i++)
+	{
+		current.entries[i].check.store(0, std::memory_order_relaxed);
+		current.entries[i].data.store(0, std::memory_order_relaxed);
+	}
+}
+
+#pragma endregion ENTRIES
+
+#pragma region FILES
+
+static bool is_valid(const file_header &header, uint64_t file_size)
+{
+	return header.magic == FILE_MAGIC && header.version == FILE_VERSION && header.hash_version == zobrist::HASH_VERSION
+	       && header.entry_size == sizeof(table_entry) && std::has_single_bit(header.entries)
+	       && file_size == sizeof(file_header) + header.entries * sizeof(table_entry);
+}
+
+static file_header make_header(uint64_t entries)
+{
+	return file_header{ FILE_MAGIC, FILE_VERSION, zobrist::HASH_VERSION, sizeof(table_entry), entries, {} };
+}
+
+bool save(const std::string &path)
+{
+#ifdef TRANSPOSITION_USE_MMAP
+	// The table already lives in that file, so it only has to reach the disk. Writing a copy and renaming it over
+	// the file would leave the table in the old, unlinked file, and nothing stored afterwards would be kept.
+	std::error_code same_file_error;
+	if (current.file_backed && std::filesystem::equivalent(path, current.path, same_file_error))
+	{
+		const size_t mapped_size = sizeof(file_header) + (current.mask + 1) * sizeof(table_entry);
+		return msync(current.storage.get(), mapped_size, MS_SYNC) == 0;
+	}
+#endif
+
+	// Written next to the target and renamed over it at the end, so a table that was loaded from `path`
+	// (and is still reading pages from it) never sees the file change under it.
+	const std::string temporary = path + ".tmp";
+	{
+		std::ofstream     stream(temporary, std::ios::binary | std::ios::trunc);
+		const file_header header = make_header(current.mask + 1);
+		stream.write(reinterpret_cast<const char *>(&header), sizeof(header));
+		stream.write(reinterpret_cast<const char *>(current.entries), (current.mask + 1) * sizeof(table_entry));
+		if (!stream) return false;
+	}
+
+	std::error_code error;
+	std::filesystem::rename(temporary, path, error);
+	return !error;
+}
+
+#ifdef TRANSPOSITION_USE_MMAP
+
+// Maps `size` bytes of `fd`, and makes a table of the entries after the header.
+static bool map_table(int fd, size_t size, bool shared, table &mapped)
+{
+	void *data = mmap(nullptr, size, PROT_READ | PROT_WRITE, shared ? MAP_SHARED : MAP_PRIVATE, fd, 0);
+	if (data == MAP_FAILED) return false;
+
+	mapped.storage     = std::shared_ptr<void>(data, [size](void *mapping) { munmap(mapping, size); });
+	mapped.entries     = reinterpret_cast<table_entry *>(static_cast<char *>(data) + sizeof(file_header));
+	mapped.mask        = (size - sizeof(file_header)) / sizeof(table_entry) - 1;
+	mapped.file_backed = shared;
+	return true;
+}
+
+// Reads the header of an open file, and returns the file's size if it's a valid table, or 0 otherwise.
+static size_t valid_size(int fd)
+{
+	struct stat info;
+	file_header header{};
+	if (fstat(fd, &info) != 0 || pread(fd, &header, sizeof(header), 0) != (ssize_t) sizeof(header)) return 0;
+	return is_valid(header, info.st_size) ? info.st_size : 0;
+}
+
+// Creates a table file of `entries` empty entries at `path`, which mustn't exist yet. Returns the open file, or -1.
+static int create_table_file(const std::string &path, size_t entries)
+{
+	const int fd = open(path.c_str(), O_RDWR | O_CREAT | O_EXCL, 0644);
+	if (fd == -1) return -1;
+
+	const file_header header = make_header(entries);
+	// The entries are left as a hole in the file, which reads as zeros (empty entries) without using the disk.
+	if (ftruncate(fd, sizeof(file_header) + entries * sizeof(table_entry)) != 0
+	    || pwrite(fd, &header, sizeof(header), 0) != (ssize_t) sizeof(header))
+	{
+		// Only ever the half-written file from just now.
+		::close(fd);
+		(void) unlink(path.c_str());
+		return -1;
+	}
+	return fd;
+}
+
+bool open_file(const std::string &path, size_t megabytes)
+{
+	int fd = open(path.c_str(), O_RDWR);
+	if (fd == -1 && errno == ENOENT)
+		fd = create_table_file(path, megabytes == 0 ? current.mask + 1 : entry_count(megabytes));
+	if (fd == -1) return false;
+
+	// An existing file that isn't a valid table is left alone: it may be something else entirely.
+	table        mapped;
+	const size_t size    = valid_size(fd);
+	const bool   success = size != 0 && map_table(fd, size, true, mapped);
+	::close(fd);
+	if (!success) return false;
+
+	mapped.path = path;
+	current     = std::move(mapped);
+	return true;
+}
+
+bool load(const std::string &path)
+{
+	const int fd = open(path.c_str(), O_RDONLY);
+	if (fd == -1) return false;
+
+	// A private mapping is copy-on-write, so the search can store into it without touching the file.
+	table        mapped;
+	const size_t size    = valid_size(fd);
+	const bool   success = size != 0 && map_table(fd, size, false, mapped);
+	::close(fd);
+	if (!success) return false;
+
+	mapped.path = path;
+	current     = std::move(mapped);
+	return true;
+}
+
+#else
+
+// Without mmap a file can't back the table, and snapshots have to be read in full.
+bool open_file(const std::string &, size_t) { return false; }
+
+bool load(const std::string &path)
+{
+	std::ifstream stream(path, std::ios::binary | std::ios::ate);
+	const size_t  size = stream ? (size_t) stream.tellg() : 0;
+	file_header   header{};
+	stream.seekg(0);
+	if (!stream.read(reinterpret_cast<char *>(&header), sizeof(header)) || !is_valid(header, size)) return false;
+
+	std::shared_ptr<table_entry[]> memory(new table_entry[header.entries]);
+	if (!stream.read(reinterpret_cast<char *>(memory.get()), header.entries * sizeof(table_entry))) return false;
+	current = table{ memory, memory.get(), header.entries - 1, false, path };
+	return true;
+}
+
+#endif
+
+void close_file()
+{
+	if (current.file_backed) current = make_table(get_size());
+}
+
+bool set_size(size_t megabytes)
+{
+	if (current.file_backed) return entry_count(megabytes) == current.mask + 1;
+	if (entry_count(megabytes) != current.mask + 1) current = make_table(megabytes);
+	return true;
+}
+
+#pragma endregion FILES
+
+} // namespace transposition
\ No newline at end of file
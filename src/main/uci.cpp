@@ -0,0 +1,372 @@
+#include "uci.hpp"
+
+#include "board.hpp"
+#include "evaluation.hpp"
+#include "fen.hpp"
+#include "move_generation.hpp"
+#include "nnue.hpp"
+#include "polyglot.hpp"
+#include "search.hpp"
+#include "transposition.hpp"
+
+#include <algorithm>
+#include <condition_variable>
+#include <cstdlib>
+#include <mutex>
+#include <optional>
+#include <random>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+namespace uci
+{
+
+using Clock = std::chrono::steady_clock;
+using evaluation::eval_t;
+
+#pragma region HELPERS
+
+// Finds the legal move written as `text` in long algebraic notation, like "e2e4" or "e7e8q".
+static std::optional<Move> parse_move(const Board &board, const std::string &text)
+{
+	char buffer[MAX_UCI_LENGTH];
+	for (const Move &move : generate_moves(board))
+		if (std::string_view(buffer, move.to_uci(buffer)) == text) return move;
+	return std::nullopt;
+}
+
+static std::string format_score(eval_t score)
+{
+	if (!is_mate_score(score)) return "cp " + std::to_string(score);
+
+	// Mate scores count plies, UCI counts moves. Negative means the side to move is getting mated.
+	const eval_t moves = (MATE_SCORE - std::abs(score) + 1) / 2;
+	return "mate " + std::to_string(score > 0 ? moves : -moves);
+}
+
+static std::string format_info(const search_result &result)
+{
+	const int64_t time = result.search_time.count();
+	const int64_t nps  = (int64_t) result.nodes * 1000 / std::max<int64_t>(time, 1);
+
+	std::ostringstream line;
+	line << "info depth " << result.depth << " score " << format_score(result.score) << " nodes " << result.nodes
+	     << " nps " << nps << " time " << time;
+	return line.str();
+}
+
+// The rest of the line after the current token, without the leading space.
+static std::string rest_of_line(std::istringstream &tokens)
+{
+	std::string rest;
+	std::getline(tokens >> std::ws, rest);
+	return rest;
+}
+
+#pragma endregion HELPERS
+
+class engine
+{
+	std::ostream &output;
+	std::mutex    output_mutex;
+
+	// The position is kept as the base position plus the moves played from it, so a `position` command
+	// that only adds moves to the last one can just play those instead of setting everything up again.
+	std::string              base_fen;
+	std::vector<std::string> played_moves;
+	Board                    board;
+
+	search_control          control;
+	std::thread             worker;
+	// While pondering or searching infinitely, the best move is held back until `stop` or `ponderhit`.
+	std::mutex              hold_mutex;
+	std::condition_variable hold_condition;
+	bool                    infinite  = false;
+	bool                    pondering = false;
+	// Time to search for once a ponder search turns into a real one.
+	std::chrono::milliseconds ponder_budget{ 0 };
+
+	polyglot::book  opening_book;
+	bool            own_book = true;
+	std::mt19937_64 book_rng{ std::random_device{}() };
+
+public:
+	explicit engine(std::ostream &output) : output(output)
+	{
+		this->set_position(START_FEN, {});
+		(void) this->opening_book.open(polyglot::DEFAULT_BOOK_FILE);
+	}
+	~engine() { this->stop(); }
+
+	// Returns false once the engine should quit.
+	bool handle(const std::string &line);
+
+private:
+	void send(const std::string &line)
+	{
+		std::lock_guard<std::mutex> lock(this->output_mutex);
+		this->output << line << std::endl;
+	}
+
+	void identify();
+	void set_option(std::istringstream &tokens);
+	void position(std::istringstream &tokens);
+	void set_position(const std::string &fen, const std::vector<std::string> &moves);
+	void go(std::istringstream &tokens);
+	void stop();
+	void ponder_hit();
+	void run_search(Board position, search_limits limits);
+};
+
+bool engine::handle(const std::string &line)
+{
+	std::istringstream tokens(line);
+	std::string        command;
+	tokens >> command;
+
+	if (command == "uci") this->identify();
+	else if (command == "isready") this->send("readyok");
+	else if (command == "setoption") this->set_option(tokens);
+	else if (command == "ucinewgame")
+	{
+		this->stop();
+		evaluation::clear_cache();
+		// A table from a file was opened or loaded to be reused, not to be thrown away by the next game.
+		if (!transposition::is_from_file()) transposition::clear();
+		this->set_position(START_FEN, {});
+	}
+	else if (command == "position") this->position(tokens);
+	else if (command == "go") this->go(tokens);
+	else if (command == "stop") this->stop();
+	else if (command == "ponderhit") this->ponder_hit();
+	else if (command == "d") this->send(this->board.to_string());
+	// Not part of UCI: savehash <path> and loadhash <path> write and read snapshots of the transposition table.
+	else if (command == "savehash" || command == "loadhash")
+	{
+		this->stop();
+		const std::string path    = rest_of_line(tokens);
+		const bool        success = command == "savehash" ? transposition::save(path) : transposition::load(path);
+		if (!success) this->send("info string Could not " + command.substr(0, 4) + " hash " + path);
+	}
+	else if (command == "quit") return false;
+	// Anything else is ignored, as the protocol asks.
+	return true;
+}
+
+void engine::identify()
+{
+	this->send(std::string("id name ") + ENGINE_NAME);
+	this->send(std::string("id author ") + ENGINE_AUTHOR);
+	this->send("option name Hash type spin default " + std::to_string(transposition::DEFAULT_SIZE_MB) + " min 1 max "
+	           + std::to_string(MAX_HASH_MB));
+	this->send("option name HashFile type string default <empty>");
+	this->send("option name Threads type spin default 1 min 1 max " + std::to_string(MAX_THREADS));
+	this->send("option name Ponder type check default false");
+	this->send(std::string("option name EvalFile type string default ") + evaluation::nnue::DEFAULT_NETWORK_FILE);
+	this->send("option name OwnBook type check default true");
+	this->send(std::string("option name BookFile type string default ") + polyglot::DEFAULT_BOOK_FILE);
+	this->send("uciok");
+}
+
+// setoption name <id> [value <x>]. Both the name and the value may contain spaces.
+void engine::set_option(std::istringstream &tokens)
+{
+	std::string token, name, value;
+	tokens >> token;
+	while (tokens >> token && token != "value") name += (name.empty() ? "" : " ") + token;
+	value = rest_of_line(tokens);
+
+	// The options below can't change under a running search.
+	this->stop();
+	if (name == "Hash")
+	{
+		const size_t megabytes = std::clamp<size_t>(std::strtoull(value.c_str(), nullptr, 10), 1, MAX_HASH_MB);
+		if (!transposition::set_size(megabytes))
+			this->send("info string The hash file keeps its size of " + std::to_string(transposition::get_size())
+			           + "MB");
+	}
+	else if (name == "HashFile")
+	{
+		if (value.empty() || value == "<empty>") transposition::close_file();
+		else if (!transposition::open_file(value)) this->send("info string Could not open hash file " + value);
+	}
+	else if (name == "Threads")
+		this->control.threads = std::clamp<size_t>(std::strtoull(value.c_str(), nullptr, 10), 1, MAX_THREADS);
+	else if (name == "EvalFile")
+	{
+		if (value.empty() || value == "<empty>") evaluation::nnue::unload();
+		else if (!evaluation::nnue::load(value)) this->send("info string Could not load network " + value);
+		// The accumulators only exist while a network is loaded, so the position has to be set up again.
+		const std::string              fen   = this->base_fen;
+		const std::vector<std::string> moves = this->played_moves;
+		this->base_fen.clear();
+		this->set_position(fen, moves);
+	}
+	else if (name == "OwnBook") this->own_book = value == "true";
+	else if (name == "BookFile")
+	{
+		this->opening_book.close();
+		if (!value.empty() && value != "<empty>" && !this->opening_book.open(value))
+			this->send("info string Could not load book " + value);
+	}
+}
+
+// position [fen <fen> | startpos] [moves <move>...]
+void engine::position(std::istringstream &tokens)
+{
+	std::string token, fen;
+	tokens >> token;
+	if (token == "startpos")
+	{
+		fen = START_FEN;
+		tokens >> token;
+	}
+	else if (token == "fen")
+	{
+		// Some GUIs leave out the move counters, which the FEN parser allows.
+		while (tokens >> token && token != "moves") fen += (fen.empty() ? "" : " ") + token;
+	}
+	else return;
+
+	std::vector<std::string> moves;
+	if (token == "moves")
+		while (tokens >> token) moves.push_back(token);
+	this->set_position(fen, moves);
+}
+
+void engine::set_position(const std::string &fen, const std::vector<std::string> &moves)
+{
+	const bool continues = fen == this->base_fen && moves.size() >= this->played_moves.size()
+	                       && std::equal(this->played_moves.begin(), this->played_moves.end(), moves.begin());
+	if (!continues)
+	{
+		std::optional<Board> parsed = Board::from_fen(fen);
+		if (!parsed.has_value())
+		{
+			this->send("info string Invalid FEN " + fen);
+			return;
+		}
+		this->board    = parsed.value();
+		this->board.update_bitboards();
+		this->base_fen = fen;
+		this->played_moves.clear();
+	}
+
+	for (size_t i = this->played_moves.size(); i < moves.size(); i++)
+	{
+		const std::optional<Move> move = parse_move(this->board, moves[i]);
+		if (!move.has_value())
+		{
+			this->send("info string Illegal move " + moves[i]);
+			return;
+		}
+		this->board.make_move(move.value());
+		this->played_moves.push_back(moves[i]);
+	}
+}
+
+void engine::go(std::istringstream &tokens)
+{
+	this->stop();
+
+	search_limits limits;
+	int64_t       time_left[2] = { 0, 0 }, increment[2] = { 0, 0 }, moves_to_go = 0, move_time = 0;
+	bool          infinite = false, ponder = false;
+
+	std::string token;
+	while (tokens >> token)
+	{
+		if (token == "depth") tokens >> limits.depth;
+		else if (token == "nodes") tokens >> limits.nodes;
+		else if (token == "movetime") tokens >> move_time;
+		else if (token == "wtime") tokens >> time_left[WHITE];
+		else if (token == "btime") tokens >> time_left[BLACK];
+		else if (token == "winc") tokens >> increment[WHITE];
+		else if (token == "binc") tokens >> increment[BLACK];
+		else if (token == "movestogo") tokens >> moves_to_go;
+		else if (token == "infinite") infinite = true;
+		else if (token == "ponder") ponder = true;
+	}
+
+	// A share of the remaining time, plus most of the increment, but never more than is actually left.
+	const color_t us = this->board.turn_to_move();
+	int64_t       budget = move_time;
+	if (budget == 0 && time_left[us] != 0)
+	{
+		budget = time_left[us] / (moves_to_go > 0 ? moves_to_go : DEFAULT_MOVES_TO_GO) + increment[us] * 3 / 4;
+		budget = std::min(budget, time_left[us]);
+	}
+	if (budget != 0) budget = std::max<int64_t>(budget - MOVE_OVERHEAD.count(), 1);
+
+	// Book moves are played straight away, unless the GUI wants the engine to keep thinking.
+	if (this->own_book && !infinite && !ponder)
+	{
+		const std::optional<Move> book_move = this->opening_book.pick(this->board, this->book_rng);
+		if (book_move.has_value())
+		{
+			this->send("bestmove " + book_move->to_string(this->board, true));
+			return;
+		}
+	}
+
+	this->control.stop     = false;
+	this->control.deadline = 0;
+	this->infinite         = infinite;
+	this->pondering        = ponder;
+	this->ponder_budget    = std::chrono::milliseconds(budget);
+	// While pondering the clock doesn't run yet, `ponderhit` starts it.
+	if (budget != 0 && !infinite && !ponder)
+		this->control.deadline = to_deadline(Clock::now() + std::chrono::milliseconds(budget));
+
+	this->worker = std::thread(&engine::run_search, this, this->board, limits);
+}
+
+void engine::stop()
+{
+	{
+		std::lock_guard<std::mutex> lock(this->hold_mutex);
+		this->control.stop = true;
+	}
+	this->hold_condition.notify_all();
+	if (this->worker.joinable()) this->worker.join();
+}
+
+void engine::ponder_hit()
+{
+	{
+		std::lock_guard<std::mutex> lock(this->hold_mutex);
+		this->pondering = false;
+		if (this->ponder_budget.count() != 0)
+			this->control.deadline = to_deadline(Clock::now() + this->ponder_budget);
+	}
+	this->hold_condition.notify_all();
+}
+
+void engine::run_search(Board position, search_limits limits)
+{
+	this->control.on_iteration = [this, &position](const search_result &result)
+	{ this->send(format_info(result) + " pv " + result.move.to_string(position, true)); };
+	const search_result result = search(position, limits, this->control);
+
+	{
+		std::unique_lock<std::mutex> lock(this->hold_mutex);
+		this->hold_condition.wait(lock,
+		                          [this] { return this->control.stop || (!this->infinite && !this->pondering); });
+	}
+
+	if (result.depth == 0 && generate_moves(position).empty()) this->send("bestmove 0000");
+	else this->send("bestmove " + result.move.to_string(position, true));
+}
+
+void run(std::istream &input, std::ostream &output)
+{
+	engine      uci_engine(output);
+	std::string line;
+	while (std::getline(input, line))
+		if (!uci_engine.handle(line)) break;
+}
+
+} // namespace uci
\ No newline at end of file
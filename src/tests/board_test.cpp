@@ -0,0 +1,1115 @@
+#include "board_test.hpp"
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <exception>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <iterator>
+#include <optional>
+#include <random>
+#include <string>
+#include <thread>
+#include <tuple>
+#include <unordered_map>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+#include "binary_position.hpp"
+#include "board.hpp"
+#include "endgame.hpp"
+#include "fen.hpp"
+#include "kpk.hpp"
+#include "logger.hpp"
+#include "mapped_file.hpp"
+#include "move.hpp"
+#include "move_generation.hpp"
+#include "nnue.hpp"
+#include "pawn_structure.hpp"
+#include "pgn.hpp"
+#include "polyglot.hpp"
+
+constexpr int board_test_depth = 3;
+Logger       *board_logger     = new Logger(LOG_LEVEL::DEBUG, "Board Test", Logger::HeaderType::SHORT);
+
+void print_board_test_result(const std::string &name, bool passed, const std::string &reason = "")
+{
+	board_logger->print(passed ? LOG_LEVEL::INFO : LOG_LEVEL::ERROR, name + ": ", TEXT_COLOR::NORMAL, true);
+	if (passed)
+	{
+		board_logger->println(LOG_LEVEL::INFO, "Passed", TEXT_COLOR::LIGHT_GREEN, true);
+		return;
+	}
+	board_logger->print(LOG_LEVEL::ERROR, "failed", TEXT_COLOR::RED, true);
+	board_logger->println(LOG_LEVEL::ERROR, reason.empty() ? "" : ": " + reason);
+}
+
+// Calls `check` on every position of the perft tree below `board`, stopping at the first failure.
+bool walk_tree(Board &board, int depth, const std::function<bool(Board &)> &check)
+{
+	if (!check(board)) return false;
+	if (depth == 0) return true;
+
+	for (auto &move : generate_moves(board))
+	{
+		board.make_move(move);
+		bool passed = walk_tree(board, depth - 1, check);
+		board.unmake_move();
+		if (!passed) return false;
+	}
+	return true;
+}
+
+void run_for_test_positions(const std::string                 &name,
+                            const std::function<bool(Board &)> &check,
+                            int                                 depth = board_test_depth)
+{
+	for (size_t i = 0; i < test_positions.size(); i++)
+	{
+		auto result = Board::from_fen(test_positions[i]);
+		if (!result.has_value())
+		{
+			print_board_test_result(name, false, "Failed to generate board.");
+			return;
+		}
+		Board start = result.value();
+		start.update_bitboards();
+
+		if (!walk_tree(start, depth, check))
+		{
+			print_board_test_result(name, false, "Mismatch in position " + std::to_string(i + 1));
+			return;
+		}
+	}
+	print_board_test_result(name, true);
+}
+
+void test_incremental_hash()
+{
+	run_for_test_positions("Incremental hash", [](Board &board) { return board.get_hash() == board.generate_hash(); });
+}
+
+void test_incremental_material()
+{
+	run_for_test_positions("Incremental material",
+	                       [](Board &board) { return board.get_packed_material() == board.generate_packed_material(); });
+}
+
+void test_pawn_hash()
+{
+	run_for_test_positions("Pawn hash",
+	                       [](Board &board) { return board.get_pawn_hash() == board.generate_pawn_hash(); });
+}
+
+// The pawn cache keeps passed pawns and attack spans for the king safety terms, so they have to be right.
+void test_passed_pawns()
+{
+	using namespace evaluation::hce;
+	// a2 and h7 are passed. e2 and d5 are each on a file next to the other, so neither is.
+	Board board = Board::from_fen("4k3/7p/8/3p4/8/8/P3P3/4K3 w - - 0 1").value();
+	board.update_bitboards();
+
+	const pawns::entry entry = pawns::evaluate_structure(board.bitboards[WHITE].pieces.pawns,
+	                                                     board.bitboards[BLACK].pieces.pawns);
+	// a2 can attack b3 up to b8 as it advances, but never a square on its own file.
+	const uint64_t span   = entry.attack_span[WHITE].bits;
+	const bool     passed = entry.passed[WHITE].bits == 1ull << 8 && entry.passed[BLACK].bits == 1ull << 55
+	                        && (span >> 17 & 1) && (span >> 57 & 1) && !(span >> 16 & 1);
+	print_board_test_result("Passed pawns", passed);
+}
+
+// Writes a network with random weights, which is all the accumulator test needs.
+bool write_random_network(const std::filesystem::path &path)
+{
+	using namespace evaluation::nnue;
+
+	std::mt19937                           rng(12345);
+	std::uniform_int_distribution<int16_t> feature_weight(-64, 64);
+
+	std::vector<int16_t> feature_weights(INPUTS * HIDDEN + HIDDEN);
+	std::vector<int8_t>  output_weights(2 * HIDDEN);
+	for (auto &weight : feature_weights) weight = feature_weight(rng);
+	for (auto &weight : output_weights) weight = (int8_t) feature_weight(rng);
+	const int32_t     output_bias = 0;
+	const file_header header{ FILE_MAGIC, FILE_VERSION, INPUTS, HIDDEN };
+
+	std::ofstream file(path, std::ios::binary);
+	file.write(reinterpret_cast<const char *>(&header), sizeof(header));
+	file.write(reinterpret_cast<const char *>(feature_weights.data()), feature_weights.size() * sizeof(int16_t));
+	file.write(reinterpret_cast<const char *>(output_weights.data()), output_weights.size());
+	file.write(reinterpret_cast<const char *>(&output_bias), sizeof(output_bias));
+	return file.good();
+}
+
+void test_nnue_accumulator()
+{
+	const std::filesystem::path path = std::filesystem::temp_directory_path() / "chess_bot_test_network.nnue";
+	if (!write_random_network(path) || !evaluation::nnue::load(path.string()))
+	{
+		print_board_test_result("NNUE accumulator", false, "Failed to load the test network.");
+		std::filesystem::remove(path);
+		return;
+	}
+
+	run_for_test_positions("NNUE accumulator",
+	                       [](Board &board)
+	                       {
+		                       evaluation::nnue::accumulator expected;
+		                       evaluation::nnue::refresh(expected, board);
+		                       return board.get_accumulator().values == expected.values;
+	                       });
+
+	evaluation::nnue::unload();
+	std::filesystem::remove(path);
+}
+
+void test_attack_sets()
+{
+	run_for_test_positions("Attack sets",
+	                       [](Board &board)
+	                       {
+		                       const bitboard::full_set expected = bitboard::generate_full_set(board);
+		                       for (color_t color : { WHITE, BLACK })
+		                       {
+			                       const bitboard::attack_boards &ours   = board.bitboards[color].attacks;
+			                       const bitboard::attack_boards &theirs = expected[color].attacks;
+			                       if (ours.by_type != theirs.by_type || ours.count != theirs.count
+			                           || ours.pieces != theirs.pieces || ours.types != theirs.types)
+				                       return false;
+		                       }
+		                       return true;
+	                       });
+}
+
+void test_eval_trace()
+{
+	run_for_test_positions("Eval trace",
+	                       [](Board &board)
+	                       {
+		                       using namespace evaluation;
+		                       const hce::eval_trace trace  = hce::trace(board);
+		                       const eval_t          lerped = hce::two_phase_lerp(board,
+		                                                                          mg_value(trace.total()),
+		                                                                          eg_value(trace.total()));
+		                       const eval_t          score  = hce::evaluate(board);
+		                       return trace.score == lerped
+		                              && trace.score == (board.turn_to_move() == WHITE ? score : -score);
+	                       });
+}
+
+void test_endgames()
+{
+	using namespace evaluation::endgame;
+
+	struct endgame_case
+	{
+		const char        *fen;
+		// Expected score sign from the side to move's point of view, or 0 for an exact draw.
+		int                sign;
+		bool               exact;
+		evaluation::eval_t scale;
+	};
+
+	const std::array<endgame_case, 9> cases = { {
+		{ "8/8/4k3/8/8/3NK3/8/8 w - - 0 1", 0, true, SCALE_NORMAL },
+		{ "8/8/4k3/8/8/3bK3/8/8 w - - 0 1", 0, true, SCALE_NORMAL },
+		{ "8/8/4k3/8/8/3QK3/8/8 b - - 0 1", -1, false, SCALE_NORMAL },
+		{ "8/8/4K3/8/8/3qk3/8/8 b - - 0 1", 1, false, SCALE_NORMAL },
+		{ "8/8/8/4k3/8/8/2BNK3/8 w - - 0 1", 1, false, SCALE_NORMAL },
+		// Rook pawn with the wrong bishop, and the defending king in the corner.
+		{ "k7/8/P7/8/8/8/8/2B1K3 w - - 0 1", 0, false, SCALE_DRAW },
+		{ "4k3/8/4K3/4P3/8/8/8/8 b - - 0 1", -1, false, SCALE_NORMAL },
+		{ "8/8/8/8/4p3/4k3/8/4K3 b - - 0 1", 1, false, SCALE_NORMAL },
+		{ "k7/8/K7/P7/8/8/8/8 w - - 0 1", 0, false, SCALE_NORMAL },
+	} };
+
+	for (size_t i = 0; i < cases.size(); i++)
+	{
+		auto result = Board::from_fen(cases[i].fen);
+		if (!result.has_value())
+		{
+			print_board_test_result("Endgames", false, "Failed to generate board.");
+			return;
+		}
+		Board board = result.value();
+		board.update_bitboards();
+
+		const entry *ending = probe(board);
+		bool         passed = ending != nullptr && ending->exact == cases[i].exact;
+		if (passed && ending->evaluate != nullptr)
+		{
+			const evaluation::eval_t score  = evaluate(*ending, board);
+			passed                         &= cases[i].sign == 0 ? score == 0 : score * cases[i].sign > KNOWN_WIN;
+		}
+		if (passed && ending->scale != nullptr) passed = ending->scale(board, ending->strong) == cases[i].scale;
+
+		if (!passed)
+		{
+			print_board_test_result("Endgames", false, "Mismatch in position " + std::to_string(i + 1));
+			return;
+		}
+	}
+
+	// Anything with more material than the known endings shouldn't match.
+	auto  result = Board::from_fen(test_positions[0]);
+	Board board  = result.value();
+	board.update_bitboards();
+	print_board_test_result("Endgames", probe(board) == nullptr, "Matched the starting position.");
+}
+
+std::string kpk_fen(uint8_t white_king, uint8_t pawn, uint8_t black_king, color_t to_move)
+{
+	std::string fen;
+	for (int rank = 7; rank >= 0; rank--)
+	{
+		int empty = 0;
+		for (int file = 0; file < 8; file++)
+		{
+			const uint8_t square = rank * 8 + file;
+			const char    piece  = square == white_king ? 'K' : square == pawn ? 'P' : square == black_king ? 'k' : 0;
+			if (piece == 0)
+			{
+				empty++;
+				continue;
+			}
+			if (empty != 0) fen += (char) ('0' + empty);
+			fen   += piece;
+			empty  = 0;
+		}
+		if (empty != 0) fen += (char) ('0' + empty);
+		if (rank != 0) fen += '/';
+	}
+	return fen + (to_move == WHITE ? " w - - 0 1" : " b - - 0 1");
+}
+
+// Whether white can promote within `plies` without the new piece being taken or black being stalemated,
+// found with the real move generator. It can prove a win, but not running out of plies doesn't prove a draw.
+bool forced_promotion(Board &board, uint32_t plies, std::unordered_map<uint64_t, bool> &known)
+{
+	const uint64_t key = board.get_hash() ^ (plies * 0x9e3779b97f4a7c15);
+	if (auto found = known.find(key); found != known.end()) return found->second;
+
+	const bitboard::piece_boards &white = board.bitboards[WHITE].pieces;
+	std::vector<Move>             moves = generate_moves(board);
+	bool                          wins  = false;
+
+	if (white.pawns.none())
+	{
+		// The pawn was promoted (or taken). Black is to move, and the only thing it can capture is the new piece.
+		const bool captures = std::any_of(moves.begin(),
+		                                  moves.end(),
+		                                  [](const Move &move) { return move.is_capture(); });
+		wins                = (white.queens | white.rooks).any() && (moves.empty() ? board.is_in_check() : !captures);
+	}
+	else if (moves.empty()) wins = board.turn_to_move() == BLACK && board.is_in_check();
+	else if (plies > 0)
+	{
+		const bool white_to_move = board.turn_to_move() == WHITE;
+		wins                     = !white_to_move;
+		for (auto &move : moves)
+		{
+			board.make_move(move);
+			const bool result = forced_promotion(board, plies - 1, known);
+			board.unmake_move();
+			if (result == white_to_move)
+			{
+				wins = white_to_move;
+				break;
+			}
+		}
+	}
+
+	known[key] = wins;
+	return wins;
+}
+
+void test_kpk()
+{
+	using namespace evaluation::endgame;
+	using Clock = std::chrono::steady_clock;
+
+	const Clock::time_point start = Clock::now();
+	kpk::init();
+	const auto build_time = std::chrono::duration_cast<std::chrono::microseconds>(Clock::now() - start);
+	board_logger->println(LOG_LEVEL::DEBUG, "KPK bitbase built in " + std::to_string(build_time.count()) + "us");
+
+	// Searching further than this takes too long, so samples start with the pawn on the fourth rank or higher.
+	constexpr uint32_t max_plies = 13;
+	constexpr size_t   samples   = 200;
+
+	std::mt19937                          rng(40);
+	std::uniform_int_distribution<int>    square(0, 63);
+	std::uniform_int_distribution<int>    pawn_square(24, 55);
+	size_t                                confirmed_wins = 0, unconfirmed_wins = 0, draws = 0;
+	std::unordered_map<uint64_t, bool>    known;
+
+	while (confirmed_wins + unconfirmed_wins + draws < samples)
+	{
+		const uint8_t white_king = square(rng), black_king = square(rng), pawn = pawn_square(rng);
+		const color_t to_move    = rng() % 2 ? WHITE : BLACK;
+		if (white_king == black_king || white_king == pawn || black_king == pawn) continue;
+
+		auto result = Board::from_fen(kpk_fen(white_king, pawn, black_king, to_move));
+		if (!result.has_value()) continue;
+		Board board = result.value();
+		board.update_bitboards();
+		// Skip illegal positions: kings touching, or the side not to move in check.
+		const int king_distance = std::max(std::abs(white_king % 8 - black_king % 8),
+		                                   std::abs(white_king / 8 - black_king / 8));
+		const bool black_in_check = black_king / 8 == pawn / 8 + 1 && std::abs(black_king % 8 - pawn % 8) == 1;
+		if (king_distance <= 1 || (to_move == WHITE && black_in_check)) continue;
+
+		const bool bitbase_win = kpk::probe(white_king, pawn, black_king, to_move);
+		const bool search_win  = forced_promotion(board, max_plies, known);
+
+		if (search_win && !bitbase_win)
+		{
+			print_board_test_result("KPK bitbase",
+			                        false,
+			                        "The search found a win in a drawn position: "
+			                            + kpk_fen(white_king, pawn, black_king, to_move));
+			return;
+		}
+		if (bitbase_win) (search_win ? confirmed_wins : unconfirmed_wins)++;
+		else draws++;
+	}
+
+	board_logger->println(LOG_LEVEL::DEBUG,
+	                      "KPK samples: " + std::to_string(confirmed_wins) + " wins confirmed by search, "
+	                          + std::to_string(unconfirmed_wins) + " beyond its horizon, " + std::to_string(draws)
+	                          + " draws");
+	print_board_test_result("KPK bitbase", true);
+
+	// With the pawn on the sixth or seventh rank every win is short enough to search, so there the bitbase has
+	// to agree with the search both ways, in every legal position. Files e-h are mirrored, so a-d are enough.
+	constexpr uint32_t near_plies = 15;
+	size_t             near_wins  = 0;
+	for (uint8_t pawn = 40; pawn < 56; pawn++)
+	{
+		if (pawn % 8 >= 4) continue;
+		for (uint8_t white_king = 0; white_king < 64; white_king++)
+			for (uint8_t black_king = 0; black_king < 64; black_king++)
+				for (color_t to_move : { WHITE, BLACK })
+				{
+					if (white_king == black_king || white_king == pawn || black_king == pawn) continue;
+					const int  king_distance  = std::max(std::abs(white_king % 8 - black_king % 8),
+					                                     std::abs(white_king / 8 - black_king / 8));
+					const bool black_in_check = black_king / 8 == pawn / 8 + 1
+					                            && std::abs(black_king % 8 - pawn % 8) == 1;
+					if (king_distance <= 1 || (to_move == WHITE && black_in_check)) continue;
+
+					Board board = Board::from_fen(kpk_fen(white_king, pawn, black_king, to_move)).value();
+					board.update_bitboards();
+					const bool bitbase_win = kpk::probe(white_king, pawn, black_king, to_move);
+					if (bitbase_win != forced_promotion(board, near_plies, known))
+					{
+						const std::string reason = bitbase_win ? "The search found no win in a won position: "
+						                                       : "The search found a win in a drawn position: ";
+						print_board_test_result("KPK bitbase near promotion",
+						                        false,
+						                        reason + kpk_fen(white_king, pawn, black_king, to_move));
+						return;
+					}
+					near_wins += bitbase_win;
+				}
+	}
+	board_logger->println(LOG_LEVEL::DEBUG, "KPK near promotion: " + std::to_string(near_wins) + " wins confirmed");
+	print_board_test_result("KPK bitbase near promotion", true);
+}
+
+std::string to_fen_string(const Board &board)
+{
+	char fen[MAX_FEN_LENGTH];
+	return std::string(fen, board.to_fen(fen, sizeof(fen)));
+}
+
+void test_fen()
+{
+	using Clock = std::chrono::steady_clock;
+
+	// Every position written out and read back in (into a reused board) has to give the same FEN and hash.
+	Board reused;
+	run_for_test_positions("FEN round trip",
+	                       [&](Board &board)
+	                       {
+		                       const std::string fen = to_fen_string(board);
+		                       return reused.set_fen(fen) && to_fen_string(reused) == fen
+		                              && reused.get_hash() == board.get_hash();
+	                       });
+
+	for (const std::string &fen : test_positions)
+	{
+		if (to_fen_string(Board::from_fen(fen).value()) != fen)
+		{
+			print_board_test_result("FEN writer", false, "Wrote a different FEN for " + fen);
+			return;
+		}
+	}
+	print_board_test_result("FEN writer", true);
+
+	// Besides malformed FENs, positions with more pieces or pawns than a game can have, or pawns on the back ranks.
+	const std::array<std::string, 11> invalid = { "",
+		                                          "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP w KQkq - 0 1",
+		                                          "rnbqkbnr/pppppppp/9/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1",
+		                                          "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR x KQkq - 0 1",
+		                                          "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkx - 0 1",
+		                                          "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 0",
+		                                          "rnbqkbnr/pppppppp/8/8/8/N7/PPPPPPPP/RNBQKBNR w KQkq - 0 1",
+		                                          "rnbqkbnr/pppppppp/8/8/8/P7/PPPPPPPP/RNBQKBN1 w Qkq - 0 1",
+		                                          "QQQQkQQQ/QQQQQQQQ/8/8/8/8/8/3QK3 w - - 0 1",
+		                                          "4k2P/8/8/8/8/8/8/4K3 w - - 0 1",
+		                                          "4k3/8/8/8/8/8/8/p3K3 w - - 0 1" };
+	for (const std::string &fen : invalid)
+	{
+		if (reused.set_fen(fen))
+		{
+			print_board_test_result("Invalid FENs", false, "Accepted \"" + fen + "\"");
+			return;
+		}
+	}
+	print_board_test_result("Invalid FENs", true);
+
+	// EPD lines, with or without counters, followed by operations that have to be ignored.
+	const std::array<std::pair<std::string, std::string>, 4> epd = {
+		{ { "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - bm Nf3; id \"start\";",
+		    "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1" },
+		  { "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1 c9 \"1-0\";",
+		    "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1" },
+		  { "8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 b - - 7 bm Rh8;", "8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 b - - 7 1" },
+		  { "8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 b - - 12 40 ce 0;", "8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 b - - 12 40" } }
+	};
+	for (const auto &[line, fen] : epd)
+	{
+		if (!reused.set_fen(line))
+		{
+			print_board_test_result("EPD operations", false, "Rejected \"" + line + "\"");
+			return;
+		}
+		reused.update_bitboards();
+		if (to_fen_string(reused) != fen)
+		{
+			print_board_test_result("EPD operations", false, "Read \"" + line + "\" as " + to_fen_string(reused));
+			return;
+		}
+	}
+	print_board_test_result("EPD operations", true);
+
+	// Parsing throughput, setting up a reused board versus building a new one for every FEN.
+	constexpr size_t rounds = 20'000;
+	Clock::time_point start = Clock::now();
+	for (size_t i = 0; i < rounds; i++)
+		for (const std::string &fen : test_positions) (void) reused.set_fen(fen);
+	const double in_place = std::chrono::duration<double>(Clock::now() - start).count();
+
+	start = Clock::now();
+	for (size_t i = 0; i < rounds; i++)
+		for (const std::string &fen : test_positions) (void) Board::from_fen(fen);
+	const double allocating = std::chrono::duration<double>(Clock::now() - start).count();
+
+	const double positions = rounds * test_positions.size();
+	board_logger->println(LOG_LEVEL::DEBUG,
+	                      "FEN parsing: " + std::to_string((int) (positions / in_place)) + " positions/s in place, "
+	                          + std::to_string((int) (positions / allocating)) + " positions/s with from_fen");
+}
+
+// Whether every piece in `board.piece_board` is a node of the board's own piece lists, and every node is on it.
+bool owns_its_pieces(const Board &board)
+{
+	std::unordered_set<const Piece *> nodes;
+	for (const piece_set_t &set : board.pieces)
+		for (const auto *list : { &set.kings, &set.queens, &set.rooks, &set.bishops, &set.knights, &set.pawns })
+			for (const Piece &piece : *list) nodes.insert(&piece);
+
+	size_t on_board = 0;
+	for (const auto &piece : board.piece_board)
+	{
+		if (piece == piece_set_t::iterator{}) continue;
+		if (!nodes.contains(&*piece)) return false;
+		on_board++;
+	}
+	return on_board == nodes.size();
+}
+
+// A board moved out of another one has to take its pieces along, since piece_board points into the piece lists.
+void test_board_move()
+{
+	constexpr size_t played_moves = 2;
+	const auto       consistent   = [](Board &position)
+	{ return owns_its_pieces(position) && position.get_hash() == position.generate_hash(); };
+
+	for (const std::string &fen : test_positions)
+	{
+		Board start = Board::from_fen(fen).value();
+		start.update_bitboards();
+		const std::string start_fen = to_fen_string(start);
+
+		// A few moves in, so the history has to come along as well.
+		std::optional<Board> source = start;
+		for (size_t i = 0; i < played_moves; i++) source->make_move(generate_moves(*source).front());
+		std::optional<Board> assign_source = *source;
+		const std::string    played_fen    = to_fen_string(*source);
+
+		// The sources are destroyed before the moved boards are used, so nothing can still point into them.
+		Board constructed(std::move(*source));
+		Board assigned;
+		assigned = std::move(*assign_source);
+		source.reset();
+		assign_source.reset();
+
+		for (Board *board : { &constructed, &assigned })
+		{
+			bool passed = owns_its_pieces(*board) && to_fen_string(*board) == played_fen
+			              && walk_tree(*board, 2, consistent);
+			for (size_t i = 0; i < played_moves; i++) board->unmake_move();
+			passed = passed && to_fen_string(*board) == start_fen;
+			if (!passed)
+			{
+				const std::string how = board == &constructed ? "Constructed from " : "Assigned from ";
+				print_board_test_result("Board move", false, how + fen);
+				return;
+			}
+		}
+	}
+	print_board_test_result("Board move", true);
+}
+
+// Taking a rook on its home square removes that rook's castling right, whatever piece takes it,
+// and even when the capturing rook gives up a castling right of its own at the same time.
+void test_rook_captures()
+{
+	struct capture_case
+	{
+		std::string fen;
+		std::string move;
+		std::string expected;
+	};
+
+	const std::array<capture_case, 4> cases = {
+		{ { "r3k2r/8/8/8/8/8/8/R3K2R w KQkq - 0 1", "a1a8", "R3k2r/8/8/8/8/8/8/4K2R b Kk - 0 1" },
+		  { "r3k2r/8/8/8/8/8/8/R3K2R w KQkq - 0 1", "h1h8", "r3k2R/8/8/8/8/8/8/R3K3 b Qq - 0 1" },
+		  { "r3k2r/8/8/8/8/8/7R/4K3 w kq - 0 1", "h2h8", "r3k2R/8/8/8/8/8/8/4K3 b q - 0 1" },
+		  { "4k2r/6K1/8/8/8/8/8/8 w k - 0 1", "g7h8", "4k2K/8/8/8/8/8/8/8 b - - 0 1" } }
+	};
+
+	for (const capture_case &test_case : cases)
+	{
+		Board board = Board::from_fen(test_case.fen).value();
+		board.update_bitboards();
+
+		const std::vector<Move> moves   = generate_moves(board);
+		const auto              capture = std::find_if(moves.begin(),
+		                                               moves.end(),
+		                                               [&](const Move &move)
+		                                               {
+			                                               char buffer[MAX_UCI_LENGTH];
+			                                               return std::string(buffer, move.to_uci(buffer))
+			                                                      == test_case.move;
+		                                               });
+		if (capture == moves.end())
+		{
+			print_board_test_result("Rook captures", false, test_case.move + " not generated in " + test_case.fen);
+			return;
+		}
+
+		board.make_move(*capture);
+		const bool cleared = to_fen_string(board) == test_case.expected && board.get_hash() == board.generate_hash();
+		board.unmake_move();
+		if (!cleared || to_fen_string(board) != test_case.fen)
+		{
+			print_board_test_result("Rook captures", false, test_case.move + " in " + test_case.fen);
+			return;
+		}
+	}
+	print_board_test_result("Rook captures", true);
+}
+
+void test_binary_positions()
+{
+	Board reused;
+	run_for_test_positions("Binary round trip",
+	                       [&](Board &board)
+	                       {
+		                       return reused.set_packed(board.to_packed())
+		                              && to_fen_string(reused) == to_fen_string(board)
+		                              && reused.get_hash() == board.get_hash();
+	                       });
+
+	// The same checks as for FENs. Here the rook on a1 is turned into a pawn on the first rank.
+	binary::position back_rank_pawn = Board::from_fen(START_FEN).value().to_packed();
+	back_rank_pawn.pieces[0]         = (back_rank_pawn.pieces[0] & 0xf0) | (uint8_t) PieceType::PAWN;
+	print_board_test_result("Invalid binary position", !reused.set_packed(back_rank_pawn));
+
+	// Enough positions to fill several chunks, written out and read back both ways.
+	const std::filesystem::path path = std::filesystem::temp_directory_path() / "chess_bot_test_positions.bin";
+	std::vector<std::string>    fens;
+	{
+		binary::writer writer(path.string());
+		for (const std::string &fen : test_positions)
+		{
+			Board start = Board::from_fen(fen).value();
+			start.update_bitboards();
+			walk_tree(start,
+			          2,
+			          [&](Board &board)
+			          {
+				          binary::position packed = board.to_packed();
+				          packed.score            = (int16_t) fens.size();
+				          writer.write(packed);
+				          fens.push_back(to_fen_string(board));
+				          return true;
+			          });
+		}
+	}
+
+	binary::reader   reader(path.string());
+	binary::position packed;
+	size_t           read   = 0;
+	bool             passed = reader.is_open();
+	while (passed && reader.read(packed))
+	{
+		passed = read < fens.size() && packed.score == (int16_t) read && reused.set_packed(packed)
+		         && to_fen_string(reused) == fens[read];
+		read++;
+	}
+	print_board_test_result("Binary reader", passed && read == fens.size(), std::to_string(read) + " positions read");
+
+	const mapped_file                      file(path.string());
+	const std::span<const binary::position> mapped = binary::positions(file);
+	passed = mapped.size() == fens.size();
+	for (size_t i = 0; passed && i < mapped.size(); i++)
+		passed = reused.set_packed(mapped[i]) && to_fen_string(reused) == fens[i];
+	print_board_test_result("Binary mapped file", passed);
+
+	std::filesystem::remove(path);
+}
+
+void test_polyglot_book()
+{
+	using Clock = std::chrono::steady_clock;
+
+	auto board_at = [](const std::string &fen)
+	{
+		Board board = Board::from_fen(fen).value();
+		board.update_bitboards();
+		return board;
+	};
+
+	// Keys from the format description, which books built elsewhere depend on.
+	const std::vector<std::pair<std::string, uint64_t>> reference_keys = {
+		{ START_FEN, 0x463b96181691fc9c },
+		{ "rnbqkbnr/pppppppp/8/8/4P3/8/PPPP1PPP/RNBQKBNR b KQkq e3 0 1", 0x823c9b50fd114196 },
+		{ "rnbqkbnr/ppp1pppp/8/3p4/4P3/8/PPPP1PPP/RNBQKBNR w KQkq d6 0 2", 0x0756b94461c50fb0 },
+		{ "rnbqkbnr/ppp1p1pp/8/3pPp2/8/8/PPPP1PPP/RNBQKBNR w KQkq f6 0 3", 0x22a48b5a8e47ff78 },
+		{ "rnbq1bnr/ppp1pkpp/8/3pPp2/8/8/PPPPKPPP/RNBQ1BNR w - - 0 4", 0x00fdd303c946bdd9 },
+		{ "rnbqkbnr/p1pppppp/8/8/P6P/R1p5/1P1PPPP1/1NBQKBNR b Kkq - 0 4", 0x5c3f9b829b279560 },
+	};
+	bool keys_passed = true;
+	for (const auto &[fen, expected] : reference_keys) keys_passed &= polyglot::key(board_at(fen)) == expected;
+	print_board_test_result("Polyglot keys", keys_passed);
+
+	// The en passant square only counts if the side to move has a pawn that could capture on it.
+	const bool en_passant_passed
+	    = polyglot::key(board_at("rnbqkbnr/pppppppp/8/8/4P3/8/PPPP1PPP/RNBQKBNR b KQkq e3 0 1"))
+	          == polyglot::key(board_at("rnbqkbnr/pppppppp/8/8/4P3/8/PPPP1PPP/RNBQKBNR b KQkq - 0 1"))
+	      && polyglot::key(board_at("rnbqkbnr/ppp1pppp/8/8/3pP3/8/PPPP1PPP/RNBQKBNR b KQkq e3 0 1"))
+	             != polyglot::key(board_at("rnbqkbnr/ppp1pppp/8/8/3pP3/8/PPPP1PPP/RNBQKBNR b KQkq - 0 1"));
+	print_board_test_result("Polyglot en passant key", en_passant_passed);
+
+	const Board start    = board_at(START_FEN);
+	const Board castling = board_at("r3k2r/8/8/8/8/8/8/R3K2R w KQkq - 0 1");
+
+	auto encode = [](const char *from, const char *to)
+	{ return (uint16_t) ((from[0] - 'a') + (from[1] - '1') * 8) << 6 | ((to[0] - 'a') + (to[1] - '1') * 8); };
+
+	// A book with a few real entries among unrelated filler keys, sorted like the format requires.
+	std::vector<polyglot::entry> entries = {
+		{ polyglot::key(start), encode("e2", "e4"), 3, 0 },
+		{ polyglot::key(start), encode("d2", "d4"), 1, 0 },
+		// Castling is stored as the king taking its rook.
+		{ polyglot::key(castling), encode("e1", "h1"), 1, 0 },
+	};
+	std::mt19937_64 rng(45);
+	for (size_t i = 0; i < 10000; i++) entries.push_back({ rng(), encode("a2", "a3"), 1, 0 });
+	std::stable_sort(entries.begin(),
+	                 entries.end(),
+	                 [](const polyglot::entry &a, const polyglot::entry &b) { return a.key < b.key; });
+
+	const std::filesystem::path path = std::filesystem::temp_directory_path() / "chess_bot_test_book.bin";
+	{
+		std::ofstream out(path, std::ios::binary);
+		for (const polyglot::entry &e : entries)
+		{
+			const polyglot::entry stored = polyglot::to_stored(e);
+			out.write(reinterpret_cast<const char *>(&stored), sizeof(stored));
+		}
+	}
+
+	polyglot::book book;
+	bool           passed = book.open(path.string());
+
+	const std::vector<polyglot::book_move> start_moves = book.moves(start);
+	passed = passed && start_moves.size() == 2 && start_moves[0].move.to_string(start, true) == "e2e4"
+	         && start_moves[0].weight == 3 && start_moves[1].move.to_string(start, true) == "d2d4";
+	const std::vector<polyglot::book_move> castling_moves = book.moves(castling);
+	passed = passed && castling_moves.size() == 1 && castling_moves[0].move.to_string(castling, true) == "e1g1";
+	passed = passed && book.moves(board_at(test_positions[1])).empty();
+	print_board_test_result("Polyglot book moves", passed);
+
+	// e2e4 has three times the weight of d2d4, so it should be picked about three quarters of the time.
+	constexpr size_t picks = 4000;
+	size_t           e4    = 0;
+	for (size_t i = 0; i < picks; i++) e4 += book.pick(start, rng)->to_string(start, true) == "e2e4";
+	print_board_test_result("Polyglot weighted pick",
+	                        e4 > picks * 7 / 10 && e4 < picks * 8 / 10,
+	                        std::to_string(e4) + " of " + std::to_string(picks) + " picks were e2e4");
+
+	const auto   probe_start = Clock::now();
+	size_t       found       = 0;
+	const size_t probes      = 10000;
+	for (size_t i = 0; i < probes; i++) found += book.moves(start).size();
+	const double probe_time = std::chrono::duration<double, std::micro>(Clock::now() - probe_start).count() / probes;
+	board_logger->println(LOG_LEVEL::DEBUG,
+	                      "Book probe: " + std::to_string(probe_time) + "us (" + std::to_string(found) + " moves)");
+
+	book.close();
+	std::filesystem::remove(path);
+}
+
+void test_pgn()
+{
+	using Clock = std::chrono::steady_clock;
+
+	// Every legal move has to be written as it always was in UCI, and decode back to itself from SAN.
+	run_for_test_positions("SAN round trip",
+	                       [](Board &board)
+	                       {
+		                       char buffer[MAX_SAN_LENGTH];
+		                       for (auto &move : generate_moves(board))
+		                       {
+			                       if (std::string(buffer, move.to_uci(buffer)) != move.to_string(board, true))
+				                       return false;
+			                       const std::string         san     = std::string(buffer, move.to_san(buffer, board));
+			                       const std::optional<Move> decoded = pgn::parse_san(board, san);
+			                       if (!decoded.has_value() || decoded.value() != move) return false;
+		                       }
+		                       return true;
+	                       });
+
+	const std::vector<std::tuple<std::string, Move, std::string>> san_cases = {
+		{ "rnbqkb1r/ppp1pppp/5n2/3p4/3P4/5N2/PPP1PPPP/RNBQKB1R b KQkq - 0 1", { "b8", "d7" }, "Nbd7" },
+		{ "rnbqkb1r/ppp1pppp/5n2/3p4/3P4/5N2/PPP1PPPP/RNBQKB1R b KQkq - 0 1", { "f6", "d7" }, "Nfd7" },
+		{ "4k3/8/8/R7/8/8/8/R3K3 w - - 0 1", { "a1", "a3" }, "R1a3" },
+		{ "4k3/8/8/3pP3/8/8/8/4K3 w - d6 0 1", { "e5", "d6", move_flags::EN_PASSANT }, "exd6" },
+		{ "4k3/1P6/8/8/8/8/8/R3K3 w Q - 0 1", { "e1", "c1", move_flags::QUEENSIDE_CASTLE }, "O-O-O" },
+		{ "4k3/1P6/8/8/8/8/8/R3K3 w Q - 0 1", { "b7", "b8", move_flags::QUEEN_PROMOTION }, "b8=Q+" },
+		{ "r1bqkb1r/pppp1ppp/2n2n2/4p2Q/2B1P3/8/PPPP1PPP/RNB1K1NR w KQkq - 4 4",
+		  { "h5", "f7", move_flags::CAPTURE },
+		  "Qxf7#" },
+	};
+	bool san_passed = true;
+	for (const auto &[fen, move, expected] : san_cases)
+	{
+		Board board = Board::from_fen(fen).value();
+		board.update_bitboards();
+		char buffer[MAX_SAN_LENGTH];
+		san_passed = san_passed && std::string(buffer, move.to_san(buffer, board)) == expected
+		             && to_fen_string(board) == fen;
+	}
+	print_board_test_result("SAN formatting", san_passed);
+
+	const std::string text = R"([Event "En passant"]
+[White "A"]
+[Black "B"]
+
+1. e4 {King's pawn} d5 2. e5 f5 $1 (2... c5 3. c3 (3. Nf3)) 3. exf6 e.p. Nxf6
+4. Nf3 Bg4 5. Be2 e6 6. O-O Bd6 7. d4 O-O 1-0
+
+% An escaped line, which is skipped.
+[Event "Promotion"]
+[SetUp "1"]
+[FEN "4k3/1P6/8/8/8/8/8/R3K3 w Q - 0 1"]
+
+1. O-O-O Kf8 2. b8=Q+ Kg7 3. Rd7+! Kh6 ; A rest of line comment.
+1-0
+
+[Event "Disambiguation"]
+[FEN "rnbqkb1r/ppp1pppp/5n2/3p4/3P4/5N2/PPP1PPPP/RNBQKB1R b KQkq - 0 1"]
+
+1... Nbd7 2. Nbd2 Nb6 3. Nb3 Nfd7 {No result, the next game's tags end this one.}
+
+[Event "Scholar's mate"]
+
+1.e4 e5 2.Qh5 Nc6 3.Bc4 Nf6?? 4.Qxf7# 1-0
+)";
+
+	pgn::reader              reader(text);
+	pgn::game                game;
+	std::vector<size_t>      move_counts;
+	std::vector<std::string> final_fens;
+	bool                     passed = true;
+	while (reader.next(game))
+	{
+		passed = passed && game.valid;
+		move_counts.push_back(game.moves.size());
+		final_fens.push_back(to_fen_string(reader.final_position()));
+		if (move_counts.size() == 1)
+			passed = passed && game.tag_value("White") == "A" && game.result == "1-0" && game.tags.size() == 3;
+	}
+	passed = passed && move_counts == std::vector<size_t>{ 14, 6, 5, 7 };
+	passed = passed && final_fens[1].starts_with("1Q6/3R4/7k/8/8/8/8/2K5 w")
+	         && final_fens[2].starts_with("r1bqkb1r/pppnpppp/1n6/3p4/3P4/1N3N2/PPP1PPPP/R1BQKB1R w");
+	print_board_test_result("PGN reader", passed);
+
+	Board ambiguous = Board::from_fen("rnbqkb1r/ppp1pppp/5n2/3p4/3P4/5N2/PPP1PPPP/RNBQKB1R b KQkq - 0 1").value();
+	ambiguous.update_bitboards();
+	print_board_test_result("SAN ambiguity",
+	                        !pgn::parse_san(ambiguous, "Nd7").has_value()
+	                            && !pgn::parse_san(ambiguous, "Nd5").has_value()
+	                            && pgn::parse_san(ambiguous, "N8d7").has_value());
+
+	// Random games written to a file, then read back in parallel.
+	const std::filesystem::path path  = std::filesystem::temp_directory_path() / "chess_bot_test_games.pgn";
+	constexpr size_t            games = 4000;
+	size_t                      plies = 0;
+	{
+		std::ofstream   out(path);
+		std::mt19937_64 rng(46);
+		for (size_t i = 0; i < games; i++)
+		{
+			Board board = Board::from_fen(START_FEN).value();
+			board.update_bitboards();
+			out << "[Event \"Random game " << i << "\"]\n[Result \"*\"]\n\n";
+			for (size_t ply = 0; ply < 120; ply++)
+			{
+				const std::vector<Move> moves = generate_moves(board);
+				if (moves.empty()) break;
+				const Move move = moves[rng() % moves.size()];
+				if (ply % 2 == 0) out << ply / 2 + 1 << ". ";
+				move.format_san(std::ostream_iterator<char>(out), board);
+				out << (ply % 10 == 9 ? "\n" : " ");
+				board.make_move(move);
+				plies++;
+			}
+			out << "*\n\n";
+		}
+	}
+
+	std::atomic<size_t> read_plies = 0, invalid = 0;
+	auto                count      = [&](const pgn::game &g)
+	{
+		read_plies += g.moves.size();
+		invalid    += !g.valid;
+	};
+	const auto   start      = Clock::now();
+	const size_t read_games = pgn::read_file(path.string(), std::max(1u, std::thread::hardware_concurrency()), count);
+	const double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+	print_board_test_result("PGN parallel reading",
+	                        read_games == games && read_plies == plies && invalid == 0,
+	                        std::to_string(read_games) + " games, " + std::to_string(read_plies) + " plies");
+	board_logger->println(LOG_LEVEL::DEBUG,
+	                      "PGN reading: " + std::to_string((size_t) (read_games / seconds * 60)) + " games/minute");
+	std::filesystem::remove(path);
+}
+
+void test_async_logger()
+{
+	using Clock = std::chrono::steady_clock;
+
+	const std::filesystem::path path = std::filesystem::temp_directory_path() / "chess_bot_test_log.txt";
+	if (!Logger::start_async(path.string()))
+	{
+		print_board_test_result("Async logger", false, "Couldn't open the log file.");
+		return;
+	}
+
+	// Loggers aren't shared between threads, each thread gets its own. Only the first messages are timed:
+	// after that the buffers are full, and the threads wait for the file instead.
+	// After those, every tenth message takes several records, which mustn't interleave with other threads' records.
+	constexpr size_t         threads = 4, messages = 20'000, timed_messages = 500;
+	auto                     is_long = [](size_t i) { return i >= timed_messages && i % 10 == 0; };
+	auto                     padding = [](size_t t) { return std::string(4000, (char) ('a' + t)); };
+	std::atomic<int64_t>     logging_time = 0;
+	std::vector<std::thread> workers;
+	for (size_t t = 0; t < threads; t++)
+		workers.emplace_back(
+		    [&, t]
+		    {
+			    Logger logger(LOG_LEVEL::DEBUG, "Thread", Logger::HeaderType::SHORT);
+			    // The first message sets up the thread's buffer.
+			    logger.println(LOG_LEVEL::INFO, "Starting");
+			    const auto start = Clock::now();
+			    for (size_t i = 0; i < messages; i++)
+			    {
+				    if (i == timed_messages)
+					    logging_time += std::chrono::nanoseconds(Clock::now() - start).count();
+				    std::string message = "#" + std::to_string(t) + ":" + std::to_string(i);
+				    if (is_long(i)) message += " " + padding(t);
+				    logger.println(LOG_LEVEL::INFO, message);
+			    }
+		    });
+	for (auto &worker : workers) worker.join();
+
+	// Long messages are split over several records and have to come out in one piece.
+	const std::string long_message(1000, 'x');
+	Logger            full(LOG_LEVEL::DEBUG, "Full", Logger::HeaderType::FULL);
+	full.println(LOG_LEVEL::INFO, long_message);
+	LOG_PRINTLN(full, LOG_LEVEL::DEBUG, "Through the macro");
+	Logger::flush();
+	Logger::stop_async();
+
+	std::ifstream       file(path);
+	std::string         line;
+	std::vector<size_t> next(threads, 0);
+	bool                in_order = true, long_passed = false, macro_passed = false;
+	while (std::getline(file, line))
+	{
+		const size_t mark = line.find('#');
+		if (line.starts_with("[ ") && line.find("][ Full ]") != std::string::npos)
+		{
+			long_passed  |= line.find(long_message) != std::string::npos;
+			macro_passed |= line.find("Through the macro") != std::string::npos;
+		}
+		else if (mark != std::string::npos)
+		{
+			const size_t t = std::stoul(line.substr(mark + 1));
+			const size_t i = std::stoul(line.substr(line.find(':', mark) + 1));
+			in_order       = in_order && t < threads && i == next[t]++;
+			if (in_order && is_long(i)) in_order = line.find(padding(t)) != std::string::npos;
+		}
+	}
+	std::filesystem::remove(path);
+
+	in_order = in_order && std::all_of(next.begin(), next.end(), [](size_t n) { return n == messages; });
+	print_board_test_result("Async logger order", in_order);
+	print_board_test_result("Async logger records", long_passed && macro_passed);
+	board_logger->println(LOG_LEVEL::DEBUG,
+	                      "Async logging: " + std::to_string(logging_time / (int64_t) (threads * timed_messages))
+	                          + "ns per message");
+}
+
+void test_repetition()
+{
+	auto  result = Board::from_fen(START_FEN);
+	Board board  = result.value();
+	board.update_bitboards();
+
+	const std::vector<Move> knight_dance = {
+		{ "g1", "f3" }, { "g8", "f6" }, { "f3", "g1" }, { "f6", "g8" }
+	};
+
+	for (auto &move : knight_dance)
+	{
+		if (board.is_repetition())
+		{
+			print_board_test_result("Repetition", false, "Repetition reported too early.");
+			return;
+		}
+		board.make_move(move);
+	}
+
+	print_board_test_result("Repetition", board.is_repetition(), "Repeated start position not detected.");
+}
+
+void test_gives_check()
+{
+	run_for_test_positions("Gives check",
+	                       [](Board &board)
+	                       {
+		                       for (auto &move : generate_moves(board))
+		                       {
+			                       bool predicted = board.gives_check(move);
+			                       board.make_move(move);
+			                       bool actual = board.is_in_check();
+			                       board.unmake_move();
+			                       if (predicted != actual) return false;
+		                       }
+		                       return true;
+	                       });
+}
+
+void test_null_move()
+{
+	run_for_test_positions("Null move",
+	                       [](Board &board)
+	                       {
+		                       if (board.is_in_check()) return true;
+
+		                       const zobrist::hash_t hash      = board.get_hash();
+		                       bitboard::full_set    bitboards = board.get_bitboards();
+
+		                       board.make_null_move();
+		                       bool passed = board.get_hash() == board.generate_hash() && !board.is_in_check();
+		                       // The other side must see exactly the moves it would have after a fresh setup.
+		                       Board fresh(board);
+		                       fresh.update_bitboards();
+		                       passed = passed && generate_moves(board).size() == generate_moves(fresh).size();
+		                       board.unmake_null_move();
+
+		                       bitboard::full_set restored = board.get_bitboards();
+		                       return passed && board.get_hash() == hash && restored[WHITE] == bitboards[WHITE]
+		                              && restored[BLACK] == bitboards[BLACK];
+	                       });
+}
+
+void test_is_legal()
+{
+	// Every raw encoding is checked at every node, so this walks a shallower tree than the other tests.
+	run_for_test_positions(
+	    "Is legal",
+	    [](Board &board)
+	    {
+		    static std::vector<bool> generated(1 << 16);
+		    std::fill(generated.begin(), generated.end(), false);
+
+		    auto encode = [](Move m) { return m.get_from() | m.get_to() << 6 | m.get_flags() << 12; };
+		    for (auto &move : generate_moves(board)) generated[encode(move)] = true;
+
+		    for (uint16_t flags = 0; flags < 16; flags++)
+			    for (uint16_t from = 0; from < 64; from++)
+				    for (uint16_t to = 0; to < 64; to++)
+				    {
+					    Move move(from, to, flags);
+					    if (is_legal(board, move) != generated[encode(move)]) return false;
+				    }
+		    return true;
+	    },
+	    2);
+}
+
+void test_board()
+{
+	try
+	{
+		test_incremental_hash();
+		test_incremental_material();
+		test_pawn_hash();
+		test_passed_pawns();
+		test_nnue_accumulator();
+		test_attack_sets();
+		test_eval_trace();
+		test_kpk();
+		test_endgames();
+		test_repetition();
+		test_null_move();
+		test_gives_check();
+		test_is_legal();
+		test_fen();
+		test_board_move();
+		test_rook_captures();
+		test_binary_positions();
+		test_polyglot_book();
+		test_pgn();
+		test_async_logger();
+	}
+	catch (const std::exception &e)
+	{
+		board_logger->print(LOG_LEVEL::ERROR, "Test ", TEXT_COLOR::NORMAL, true);
+		board_logger->print(LOG_LEVEL::ERROR, "failed", TEXT_COLOR::RED, true);
+		board_logger->print(LOG_LEVEL::ERROR, ": Exception thrown.\n");
+		board_logger->println(LOG_LEVEL::ERROR, e.what());
+	}
+}
\ No newline at end of file
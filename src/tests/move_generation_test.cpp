@@ -70,6 +70,67 @@ std::array<size_t, ply> performance_test(Board &start)
 	return results;
 }
 
+// Times make_move + unmake_move pairs over every root move of the position, without any move generation in between.
+void measure_make_unmake(Board &start)
+{
+	using Clock = std::chrono::steady_clock;
+
+	constexpr int     repetitions = 20'000;
+	std::vector<Move> moves       = generate_moves(start);
+	if (moves.empty()) return;
+
+	std::chrono::time_point begin{ Clock::now() };
+	for (int i = 0; i < repetitions; i++)
+	{
+		for (auto &move : moves)
+		{
+			start.make_move(move);
+			start.unmake_move();
+		}
+	}
+	auto   elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - begin);
+	double per_node = (double) elapsed.count() / (repetitions * moves.size());
+
+	mg_logger->print(LOG_LEVEL::INFO, "Make+unmake: ");
+	mg_logger->print(LOG_LEVEL::INFO, std::to_string((int) per_node) + "ns/node", TEXT_COLOR::LIGHT_GREEN);
+	mg_logger->println(LOG_LEVEL::INFO, "");
+}
+
+// Times the allocation-free formatters against `Move::to_string` over every root move of the position.
+void measure_move_formatting(Board &start)
+{
+	using Clock = std::chrono::steady_clock;
+
+	constexpr int     repetitions = 2'000;
+	std::vector<Move> moves       = generate_moves(start);
+	if (moves.empty()) return;
+
+	auto time_per_move = [&](auto &&format)
+	{
+		size_t                  characters = 0;
+		std::chrono::time_point begin{ Clock::now() };
+		for (int i = 0; i < repetitions; i++)
+			for (auto &move : moves) characters += format(move);
+		auto elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - begin);
+		// Using the length keeps the formatting from being optimized away.
+		return characters == 0 ? 0 : (int) (elapsed.count() / (repetitions * moves.size()));
+	};
+
+	char      buffer[MAX_SAN_LENGTH];
+	const int to_string_time = time_per_move([&](const Move &move) { return move.to_string(start).size(); });
+	const int to_string_uci  = time_per_move([&](const Move &move) { return move.to_string(start, true).size(); });
+	const int to_san_time    = time_per_move([&](const Move &move) { return move.to_san(buffer, start); });
+	const int to_uci_time    = time_per_move([&](const Move &move) { return move.to_uci(buffer); });
+
+	mg_logger->print(LOG_LEVEL::INFO, "Formatting: ");
+	mg_logger->print(LOG_LEVEL::INFO,
+	                 "to_string " + std::to_string(to_string_time) + "ns, SAN " + std::to_string(to_san_time)
+	                     + "ns, to_string (UCI) " + std::to_string(to_string_uci) + "ns, UCI "
+	                     + std::to_string(to_uci_time) + "ns",
+	                 TEXT_COLOR::LIGHT_GREEN);
+	mg_logger->println(LOG_LEVEL::INFO, "");
+}
+
 bool          debug_setup = false;
 std::ofstream out_file;
 std::mutex    file_mutex;
@@ -86,11 +147,11 @@ void add_to_debug_dump(const Board &start, const std::vector<Move> &moves)
 	std::lock_guard<std::mutex> file_lock(file_mutex);
 	if (!out_file) return;
 	if (!out_file.good()) return;
+	char buffer[MAX_UCI_LENGTH];
 	if (start.moves.size())
 	{
-		out_file << start.moves.begin()->to_string(start, true);
-		for (auto begin = std::next(start.moves.cbegin()); begin != start.moves.cend(); begin++)
-			out_file << ',' << begin->to_string(start, true);
+		out_file.write(buffer, start.moves[0].to_uci(buffer));
+		for (size_t i = 1; i < start.moves.size(); i++) out_file.put(',').write(buffer, start.moves[i].to_uci(buffer));
 	}
 	else { out_file << "startpos"; }
 	out_file << '\n';
@@ -100,9 +161,9 @@ void add_to_debug_dump(const Board &start, const std::vector<Move> &moves)
 	// if (!moves.at(0).empty())
 	if (moves.size())
 	{
-		out_file << moves.at(0).to_string(start, true);
+		out_file.write(buffer, moves.at(0).to_uci(buffer));
 		for (auto move = moves.begin() + 1; move != moves.end(); move++)
-			out_file << ',' << move->to_string(start, true);
+			out_file.put(',').write(buffer, move->to_uci(buffer));
 	}
 	else { out_file << "no moves"; }
 	out_file << "\n\n";
@@ -136,6 +197,8 @@ void run_test(size_t test_index)
 		// start.make_move({ "a2", "a3" });
 		// start.make_move({ "b4", "a3", move_flags::CAPTURE });
 		test_results = performance_test(start);
+		measure_make_unmake(start);
+		measure_move_formatting(start);
 	}
 	catch (const std::exception &e)
 	{
@@ -1,7 +1,9 @@
 #include "run_tests.hpp"
 
+#include "board_test.hpp"
 #include "move_generation_test.hpp"
 #include "search_test.hpp"
+#include "tuner_test.hpp"
 
 #include <cxxopts.hpp>
 #include <iostream>
@@ -16,7 +18,9 @@ int main(int argc, char *argv[])
 
 	program_options.add_options()("a,all", "Run all tests (Default)")(
 	    "m,move-gen",
-	    "Run tests for movement generation")("s,search", "Run tests for node searching")("h,help", "Print usage");
+	    "Run tests for movement generation")("b,board", "Run tests for board state and queries")(
+	    "s,search",
+	    "Run tests for node searching")("t,tuner", "Run tests for the evaluation tuner")("h,help", "Print usage");
 
 	cxxopts::ParseResult result = program_options.parse(argc, argv);
 
@@ -29,10 +33,14 @@ int main(int argc, char *argv[])
 	if (argc == 1 || result.count("all"))
 	{
 		test_move_generation();
+		test_board();
 		test_search();
+		test_tuner();
 		return 0;
 	}
 
 	if (result.count("move-gen")) test_move_generation();
+	if (result.count("board")) test_board();
 	if (result.count("search")) test_search();
+	if (result.count("tuner")) test_tuner();
 }
\ No newline at end of file
@@ -1,13 +1,30 @@
 #include "search_test.hpp"
 
+#include "analysis_server.hpp"
 #include "board.hpp"
 #include "fen.hpp"
+#include "move_generation.hpp"
 #include "search.hpp"
+#include "transposition.hpp"
+#include "uci.hpp"
 
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
 #include <exception>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
 #include <iostream>
+#include <mutex>
 #include <optional>
 #include <sstream>
+#include <streambuf>
+#include <string_view>
+#include <tbb/global_control.h>
+#include <thread>
+#include <utility>
+#include <vector>
 
 #include "logger.hpp"
 
@@ -23,6 +40,39 @@ void print_test_result(const search_result &result, const Board &state)
 	search_logger->println(LOG_LEVEL::INFO, std::to_string(result.score), TEXT_COLOR::PURPLE);
 	search_logger->print(LOG_LEVEL::INFO, "    Time: ");
 	search_logger->println(LOG_LEVEL::INFO, std::to_string(result.search_time.count()) + "ms", TEXT_COLOR::LIGHT_GREEN);
+
+	std::ostringstream cache_string;
+	cache_string << (int) (result.eval_cache.hit_rate() * 100) << "% hits, ";
+	cache_string << std::fixed << std::setprecision(1) << result.eval_cache.average_lookup_ns() << "ns/lookup";
+	search_logger->print(LOG_LEVEL::INFO, "    Eval cache: ");
+	search_logger->println(LOG_LEVEL::INFO, cache_string.str(), TEXT_COLOR::CYAN);
+
+	const evaluation::hce::eval_stats &stats = result.eval_stats;
+	search_logger->print(LOG_LEVEL::INFO, "    Pawn hash hits: ");
+	search_logger->println(LOG_LEVEL::INFO,
+	                       std::to_string((int) (stats.pawn_hit_rate() * 100)) + "%",
+	                       TEXT_COLOR::CYAN);
+	search_logger->print(LOG_LEVEL::INFO, "    Lazy eval exits: ");
+	search_logger->println(LOG_LEVEL::INFO,
+	                       std::to_string((int) (stats.lazy_exit_rate() * 100)) + "%",
+	                       TEXT_COLOR::CYAN);
+}
+
+// Lazy evaluation should only skip work, so the same search without it should find the same move and score.
+void print_lazy_comparison(const search_result &lazy_result, const search_result &full_result, const Board &state)
+{
+	const bool consistent = lazy_result.move == full_result.move && lazy_result.score == full_result.score;
+
+	search_logger->print(LOG_LEVEL::INFO, "    Without lazy eval: ");
+	search_logger->print(LOG_LEVEL::INFO,
+	                     consistent ? "same result" : "different result",
+	                     consistent ? TEXT_COLOR::LIGHT_GREEN : TEXT_COLOR::YELLOW);
+	if (!consistent)
+	{
+		search_logger->print(LOG_LEVEL::INFO, " (" + full_result.move.to_string(state, true) + ", ");
+		search_logger->print(LOG_LEVEL::INFO, std::to_string(full_result.score) + ")");
+	}
+	search_logger->println(LOG_LEVEL::INFO, ", " + std::to_string(full_result.search_time.count()) + "ms");
 }
 
 search_result run_test_for_position(std::string fen_string)
@@ -37,14 +87,526 @@ search_result run_test_for_position(std::string fen_string)
 	Board new_board = result.value();
 	new_board.update_bitboards();
 
+	evaluation::clear_cache();
+	transposition::clear();
 	search_result test_result = get_best_move(new_board, depth);
 
 	print_test_result(test_result, new_board);
+
+	evaluation::clear_cache();
+	transposition::clear();
+	evaluation::set_lazy_eval(false);
+	search_result full_result = get_best_move(new_board, depth);
+	evaluation::set_lazy_eval(true);
+
+	print_lazy_comparison(test_result, full_result, new_board);
 	return test_result;
 }
 
+void print_check(const std::string &name, bool passed)
+{
+	search_logger->print(LOG_LEVEL::INFO, name + ": ");
+	search_logger->println(LOG_LEVEL::INFO,
+	                       passed ? "passed" : "failed",
+	                       passed ? TEXT_COLOR::LIGHT_GREEN : TEXT_COLOR::RED);
+}
+
+// An infinite search has to come back quickly once it's told to stop, and a node limit has to be respected.
+void test_search_limits()
+{
+	using namespace std::chrono_literals;
+	Board board = Board::from_fen(START_FEN).value();
+	board.update_bitboards();
+
+	search_control control;
+	search_result  stopped_result;
+	std::thread    searcher([&] { stopped_result = search(board, search_limits{}, control); });
+	std::this_thread::sleep_for(200ms);
+
+	const auto stop_time = std::chrono::steady_clock::now();
+	control.stop         = true;
+	searcher.join();
+	const auto latency   = std::chrono::steady_clock::now() - stop_time;
+
+	std::ostringstream stop_string;
+	stop_string << "Stopped at depth " << stopped_result.depth << " after "
+	            << std::chrono::duration_cast<std::chrono::microseconds>(latency).count() << "us";
+	search_logger->println(LOG_LEVEL::INFO, stop_string.str(), TEXT_COLOR::WHITE, true);
+	print_check("Search stops within 1ms", latency < 1ms);
+
+	constexpr uint64_t node_limit = 20'000;
+	search_control     limited_control;
+	search_result      limited_result = search(board, search_limits{ 0, node_limit }, limited_control);
+
+	// Nodes are only counted towards the limit every so often, so the search can go a little over it.
+	const bool within_limit = limited_result.depth > 0 && limited_result.nodes < node_limit * 2;
+	search_logger->print(LOG_LEVEL::INFO, "Node limit of " + std::to_string(node_limit) + ": ");
+	search_logger->println(LOG_LEVEL::INFO,
+	                       std::to_string(limited_result.nodes) + " nodes, depth "
+	                           + std::to_string(limited_result.depth),
+	                       within_limit ? TEXT_COLOR::LIGHT_GREEN : TEXT_COLOR::RED);
+}
+
+// Every line of a multi-PV search has to have the same score as searching its move on its own,
+// and the best line has to be what a normal search finds.
+void test_multipv()
+{
+	constexpr uint32_t multipv_depth = 3;
+	Board board = Board::from_fen("r1bqkbnr/pppp1ppp/2n5/4p3/4P3/5N2/PPPP1PPP/RNBQKB1R w KQkq - 2 3").value();
+	board.update_bitboards();
+
+	transposition::clear();
+	search_control single_control;
+	search_control multi_control;
+	const search_result single = search(board, search_limits{ multipv_depth }, single_control);
+	const search_result multi  = search(board, search_limits{ multipv_depth, 0, {}, 4 }, multi_control);
+
+	bool passed = multi.lines.size() == 4 && single.lines.size() == 1 && multi.move == single.move
+	              && multi.score == single.score && multi.lines.front().move == multi.move;
+	for (size_t i = 0; passed && i < multi.lines.size(); i++)
+	{
+		if (i > 0 && multi.lines[i].score > multi.lines[i - 1].score) passed = false;
+
+		search_control      line_control;
+		const search_result line = search(board.simulate_move(multi.lines[i].move),
+	                                     search_limits{ multipv_depth - 1 },
+	                                     line_control);
+		if (-line.score != multi.lines[i].score) passed = false;
+	}
+	print_check("Multi-PV scores match single searches", passed);
+	search_logger->println(LOG_LEVEL::DEBUG,
+	                       "Nodes for 1 line: " + std::to_string(single.nodes) + ", for 4 lines: "
+	                           + std::to_string(multi.nodes));
+}
+
+// Sharing the root moves out between threads must not change the result, including which of two equal moves wins.
+void test_threads()
+{
+	constexpr uint32_t threads_depth = 5;
+	// TBB only starts as many workers as there are cores, so on a small machine the threads wouldn't run at once.
+	tbb::global_control workers(tbb::global_control::max_allowed_parallelism, 4);
+
+	bool passed          = true;
+	bool workers_counted = false;
+	for (const std::string &fen : test_positions)
+	{
+		Board board = Board::from_fen(fen).value();
+		board.update_bitboards();
+
+		search_control single_control;
+		search_control threaded_control;
+		threaded_control.threads = 4;
+		transposition::clear();
+		const search_result single = search(board, search_limits{ threads_depth }, single_control);
+		transposition::clear();
+		const uint64_t      own_probes = evaluation::get_cache_stats().probes;
+		const search_result threaded   = search(board, search_limits{ threads_depth }, threaded_control);
+		if (threaded.move != single.move || threaded.score != single.score)
+		{
+			passed = false;
+			search_logger->println(LOG_LEVEL::ERROR, "Threads change the result for " + fen);
+		}
+		// Evaluations on the worker threads have to show up in the result too, not just this thread's.
+		if (threaded.eval_cache.probes > evaluation::get_cache_stats().probes - own_probes) workers_counted = true;
+	}
+	print_check("4 threads find the same move and score as 1", passed);
+	print_check("Evaluation counters include every thread", workers_counted);
+}
+
+// Feeds the analysis server a batch with good and bad requests, and checks every one gets the right answer.
+void test_analysis_server()
+{
+	std::istringstream requests(
+	    "{\"id\": 1, \"depth\": 5}\n"
+	    "{\"id\": \"low\", \"depth\": 1, \"priority\": -1}\n"
+	    "{\"id\": \"high\", \"depth\": 1, \"priority\": 5}\n"
+	    "{\"id\": [2], \"fen\": \"6k1/5ppp/8/8/8/8/8/R5K1 w - - 0 1\", \"depth\": 2, \"multipv\": 2}\n"
+	    "{\"id\": 3, \"moves\": [\"e2e4\", \"e7e5\"], \"nodes\": 5000}\n"
+	    "{\"id\": 4, \"moves\": [\"e2e5\"]}\n"
+	    "{\"id\": 5, \"fen\": \"not a fen\"}\n"
+	    "{\"id\": 6, \"depth\": \"deep\"}\n"
+	    "{\"id\": 7,\n"
+	    "\n"
+	    "{\"command\": \"stats\"}\n");
+	std::ostringstream results;
+	analysis::run(requests, results, 1);
+
+	std::vector<std::string> lines;
+	std::istringstream       result_stream(results.str());
+	for (std::string line; std::getline(result_stream, line);) lines.push_back(line);
+
+	const auto find_line = [&](const std::string &prefix)
+	{
+		const auto found = std::find_if(lines.begin(),
+	                                   lines.end(),
+	                                   [&](const std::string &line) { return line.starts_with(prefix); });
+		return found == lines.end() ? -1 : (int) (found - lines.begin());
+	};
+	const auto has_line = [&](const std::string &prefix, const std::string &part)
+	{
+		const int index = find_line(prefix);
+		return index >= 0 && lines[index].find(part) != std::string::npos;
+	};
+
+	print_check("Analysis server answers every request", lines.size() == 10);
+	print_check("Analysis server finds mates",
+	            has_line("{\"id\": [2], \"bestmove\": \"a1a8\"", "\"score\": {\"mate\": 1}")
+	                && has_line("{\"id\": [2]", "}, {\"move\""));
+	print_check("Analysis server plays moves before searching",
+	            has_line("{\"id\": 3, \"bestmove\"", "\"lines\": [{"));
+	print_check("Analysis server reports bad requests",
+	            has_line("{\"id\": 4, \"error\"", "illegal move e2e5")
+	                && has_line("{\"id\": 5, \"error\"", "invalid FEN")
+	                && has_line("{\"id\": 6, \"error\"", "invalid value for \\\"depth\\\"")
+	                && has_line("{\"id\": 7, \"error\"", "invalid JSON"));
+	// The first request keeps the only worker busy while the rest are queued.
+	print_check("Analysis server runs higher priorities first",
+	            find_line("{\"id\": \"high\", \"bestmove\"") >= 0
+	                && find_line("{\"id\": \"high\"") < find_line("{\"id\": \"low\""));
+	print_check("Analysis server reports stats", has_line("{\"stats\"", "\"average_queue_time\""));
+
+	// Throughput of many small requests, which is mostly the cost of the server itself.
+	constexpr size_t   batch_size = 2000;
+	std::ostringstream batch;
+	for (size_t i = 0; i < batch_size; i++) batch << "{\"id\": " << i << ", \"depth\": 1, \"moves\": [\"d2d4\"]}\n";
+	std::istringstream batch_requests(batch.str());
+	std::ostringstream batch_results;
+
+	const auto start = std::chrono::steady_clock::now();
+	analysis::run(batch_requests, batch_results);
+	const auto time  = std::chrono::steady_clock::now() - start;
+	search_logger->println(LOG_LEVEL::DEBUG,
+	                       std::to_string(batch_size) + " requests at depth 1 in "
+	                           + std::to_string(std::chrono::duration_cast<std::chrono::milliseconds>(time).count())
+	                           + "ms");
+}
+
+// A snapshot has to bring back what the search stored, and a table file has to open without reading it all in.
+void test_transposition_table()
+{
+	using namespace std::chrono;
+	const std::filesystem::path snapshot_path = std::filesystem::temp_directory_path() / "chess_bot_test_hash.tt";
+	const std::filesystem::path live_path     = std::filesystem::temp_directory_path() / "chess_bot_test_live.tt";
+
+	Board board = Board::from_fen("r1bqkbnr/pppp1ppp/2n5/4p3/4P3/5N2/PPPP1PPP/RNBQKB1R w KQkq - 2 3").value();
+	board.update_bitboards();
+	const auto search_nodes = [&]
+	{
+		search_control control;
+		return search(board, search_limits{ 5 }, control).nodes;
+	};
+
+	transposition::clear();
+	const uint64_t first_nodes = search_nodes();
+	const bool     saved       = transposition::save(snapshot_path.string());
+	transposition::clear();
+	const uint64_t cold_nodes = search_nodes();
+	const bool     loaded     = transposition::load(snapshot_path.string());
+	const uint64_t warm_nodes = search_nodes();
+	print_check("Transposition table snapshots", saved && loaded && warm_nodes * 10 < cold_nodes);
+	search_logger->println(LOG_LEVEL::DEBUG,
+	                       "Nodes at depth 5: " + std::to_string(first_nodes) + " first, " + std::to_string(cold_nodes)
+	                           + " cleared, " + std::to_string(warm_nodes) + " after loading the snapshot");
+
+	// Tables from other hash keys would match the wrong positions, so they have to be refused.
+	{
+		std::fstream file(snapshot_path, std::ios::binary | std::ios::in | std::ios::out);
+		const uint32_t other_version = zobrist::HASH_VERSION + 1;
+		file.seekp(offsetof(transposition::file_header, hash_version));
+		file.write(reinterpret_cast<const char *>(&other_version), sizeof(other_version));
+	}
+	print_check("Transposition table refuses other hash versions", !transposition::load(snapshot_path.string()));
+	(void) transposition::save(snapshot_path.string());
+
+	// A table of a few gigabytes kept in a file, as a long analysis session would use.
+	constexpr size_t           live_mb = 2048;
+	constexpr zobrist::hash_t  keys[]  = { 0x1234567890abcdef, 0x0fedcba987654321, 0x5555aaaa5555aaaa };
+	const transposition::entry stored{ -MATE_SCORE + 7,
+	                                  Move(12, 28, move_flags::DOUBLE_PAWN_PUSH),
+	                                  9,
+	                                  transposition::bound::EXACT };
+	std::filesystem::remove(live_path);
+
+	auto       start       = steady_clock::now();
+	const bool created     = transposition::open_file(live_path.string(), live_mb);
+	const auto create_time = steady_clock::now() - start;
+	for (zobrist::hash_t key : keys) transposition::store(key, 3, stored);
+
+	// Loading the (small) snapshot lets go of the file, like a restart would.
+	(void) transposition::load(snapshot_path.string());
+	start                  = steady_clock::now();
+	const bool reopened    = transposition::open_file(live_path.string());
+	const auto reopen_time = steady_clock::now() - start;
+	bool       all_found   = reopened && transposition::is_file_backed() && transposition::get_size() == live_mb;
+	for (zobrist::hash_t key : keys)
+	{
+		transposition::entry found;
+		all_found = all_found && transposition::probe(key, 5, found) && found.score == stored.score + 2
+		            && found.move == stored.move && found.depth == stored.depth && found.type == stored.type;
+	}
+	print_check("Transposition table file survives a restart", created && all_found);
+	search_logger->println(LOG_LEVEL::DEBUG,
+	                       std::to_string(live_mb) + "MB table file created in "
+	                           + std::to_string(duration_cast<microseconds>(create_time).count()) + "us, reopened in "
+	                           + std::to_string(duration_cast<microseconds>(reopen_time).count()) + "us");
+
+	// Saving onto the file the table lives in must not cut the table off from it.
+	constexpr zobrist::hash_t later_key      = 0x2468ace013579bdf;
+	const bool                saved_in_place = transposition::save(live_path.string());
+	transposition::store(later_key, 3, stored);
+	(void) transposition::load(snapshot_path.string());
+	transposition::entry later_found;
+	const bool kept = transposition::open_file(live_path.string()) && transposition::probe(later_key, 3, later_found)
+	                  && transposition::probe(keys[0], 3, later_found);
+	print_check("Transposition table saves onto its own file", saved_in_place && kept);
+
+	(void) transposition::load(snapshot_path.string());
+	transposition::clear();
+	std::filesystem::remove(live_path);
+	std::filesystem::remove(snapshot_path);
+}
+
+// Talks to `uci::run` on another thread, the way a GUI does over a pipe: lines arrive one at a time,
+// and the engine's answers can be waited for while it keeps running.
+class uci_session
+{
+	// Blocks the engine's reads until the next line is sent, or the session ends.
+	class input_buffer : public std::streambuf
+	{
+		std::mutex              mutex;
+		std::condition_variable sent;
+		std::string             pending, current;
+		bool                    closed = false;
+
+	public:
+		void send(const std::string &line)
+		{
+			{
+				std::lock_guard<std::mutex> lock(this->mutex);
+				this->pending += line + '\n';
+			}
+			this->sent.notify_one();
+		}
+
+		void close()
+		{
+			{
+				std::lock_guard<std::mutex> lock(this->mutex);
+				this->closed = true;
+			}
+			this->sent.notify_one();
+		}
+
+	protected:
+		int_type underflow() override
+		{
+			std::unique_lock<std::mutex> lock(this->mutex);
+			this->sent.wait(lock, [this] { return !this->pending.empty() || this->closed; });
+			if (this->pending.empty()) return traits_type::eof();
+
+			this->current.swap(this->pending);
+			this->pending.clear();
+			this->setg(this->current.data(), this->current.data(), this->current.data() + this->current.size());
+			return traits_type::to_int_type(this->current.front());
+		}
+	};
+
+	// Collects everything the engine writes, so the test can wait for a particular answer.
+	class output_buffer : public std::streambuf
+	{
+		std::mutex              mutex;
+		std::condition_variable written;
+		std::string             text;
+
+	public:
+		// Waits until `part` has been written, then returns (and forgets) everything written up to then.
+		// Returns nothing if it doesn't show up within `timeout`.
+		std::optional<std::string> take_until(const std::string &part, std::chrono::milliseconds timeout)
+		{
+			std::unique_lock<std::mutex> lock(this->mutex);
+			if (!this->written.wait_for(lock,
+			                            timeout,
+			                            [&] { return this->text.find(part) != std::string::npos; }))
+				return std::nullopt;
+			return std::exchange(this->text, std::string());
+		}
+
+	protected:
+		std::streamsize xsputn(const char *data, std::streamsize count) override
+		{
+			{
+				std::lock_guard<std::mutex> lock(this->mutex);
+				this->text.append(data, count);
+			}
+			this->written.notify_all();
+			return count;
+		}
+
+		int_type overflow(int_type c) override
+		{
+			if (traits_type::eq_int_type(c, traits_type::eof())) return traits_type::not_eof(c);
+			const char character = traits_type::to_char_type(c);
+			(void) this->xsputn(&character, 1);
+			return c;
+		}
+	};
+
+	input_buffer  input_stream_buffer;
+	output_buffer output_stream_buffer;
+	std::istream  input{ &this->input_stream_buffer };
+	std::ostream  output{ &this->output_stream_buffer };
+	std::thread   engine{ [this] { uci::run(this->input, this->output); } };
+
+public:
+	~uci_session()
+	{
+		this->input_stream_buffer.send("quit");
+		this->input_stream_buffer.close();
+		this->engine.join();
+	}
+
+	void send(const std::string &line) { this->input_stream_buffer.send(line); }
+
+	std::optional<std::string> take_until(const std::string &part,
+	                                      std::chrono::milliseconds timeout = std::chrono::seconds(30))
+	{
+		return this->output_stream_buffer.take_until(part, timeout);
+	}
+
+	// Sends `isready` and returns everything written before the engine answered it.
+	std::string sync()
+	{
+		this->send("isready");
+		return this->take_until("readyok").value_or("");
+	}
+};
+
+// The board after playing `moves` (in UCI notation) from the starting position, as the `d` command prints it.
+std::string board_after(const std::vector<std::string> &moves)
+{
+	Board board = Board::from_fen(START_FEN).value();
+	board.update_bitboards();
+	for (const std::string &text : moves)
+	{
+		char buffer[MAX_UCI_LENGTH];
+		for (const Move &move : generate_moves(board))
+			if (std::string_view(buffer, move.to_uci(buffer)) == text)
+			{
+				board.make_move(move);
+				break;
+			}
+	}
+	return board.to_string();
+}
+
+void test_uci()
+{
+	using namespace std::chrono_literals;
+	uci_session session;
+	session.send("setoption name OwnBook value false");
+
+	// Each `position` either continues the last one or diverges from it, which has to set the board up again.
+	session.send("position startpos moves e2e4 e7e5");
+	session.send("position startpos moves e2e4 e7e5 g1f3");
+	session.send("d");
+	const bool continued = session.sync().find(board_after({ "e2e4", "e7e5", "g1f3" })) != std::string::npos;
+	session.send("position startpos moves d2d4 d7d5");
+	session.send("d");
+	const bool diverged = session.sync().find(board_after({ "d2d4", "d7d5" })) != std::string::npos;
+	session.send("position startpos moves d2d4 d7d5 c2c4");
+	session.send("position startpos");
+	session.send("d");
+	const bool reset = session.sync().find(board_after({})) != std::string::npos;
+	print_check("UCI position continues or resets the game", continued && diverged && reset);
+
+	session.send("position startpos moves e2e4");
+	session.send("go depth 4");
+	const std::optional<std::string> depth_output = session.take_until("bestmove");
+	print_check("UCI go depth answers with a move",
+	            depth_output.has_value() && depth_output->find("info depth 4 ") != std::string::npos
+	                && depth_output->find("info depth 5 ") == std::string::npos);
+
+	// An infinite search holds its move back until `stop`, even once it has found a mate in one.
+	session.send("position fen 6k1/5ppp/8/8/8/8/8/R5K1 w - - 0 1");
+	session.send("go infinite");
+	std::this_thread::sleep_for(100ms);
+	const std::string before_stop = session.sync();
+	session.send("stop");
+	const std::optional<std::string> mate_output = session.take_until("bestmove");
+	print_check("UCI go infinite waits for stop",
+	            before_stop.find("score mate 1") != std::string::npos
+	                && before_stop.find("bestmove") == std::string::npos && mate_output.has_value()
+	                && mate_output->find("bestmove a1a8") != std::string::npos);
+
+	session.send("position startpos");
+	session.send("go infinite");
+	std::this_thread::sleep_for(200ms);
+	const bool still_searching = session.sync().find("bestmove") == std::string::npos;
+	const auto stop_time       = std::chrono::steady_clock::now();
+	session.send("stop");
+	const bool stopped         = session.take_until("bestmove").has_value();
+	const auto latency         = std::chrono::steady_clock::now() - stop_time;
+	print_check("UCI stop ends an infinite search", still_searching && stopped && latency < 100ms);
+}
+
+// A hash file is meant to outlive the session, so neither a new game nor a GUI setting the hash size may wipe it.
+void test_hash_file()
+{
+	const std::filesystem::path path = std::filesystem::temp_directory_path() / "chess_bot_test_session.tt";
+	constexpr zobrist::hash_t  key  = 0x0123456789abcdef;
+	const transposition::entry stored{ 42, Move(12, 28, move_flags::DOUBLE_PAWN_PUSH), 9, transposition::bound::EXACT };
+	const auto                 found_stored = [&]
+	{
+		transposition::entry found;
+		return transposition::probe(key, 0, found) && found.score == stored.score && found.move == stored.move;
+	};
+	std::filesystem::remove(path);
+
+	bool        kept = false, same_size = false;
+	std::string resize_output;
+	{
+		uci_session session;
+		session.send("setoption name HashFile value " + path.string());
+		(void) session.sync();
+		const uintmax_t created_size = std::filesystem::file_size(path);
+		transposition::store(key, 0, stored);
+
+		session.send("ucinewgame");
+		session.send("setoption name Hash value " + std::to_string(2 * transposition::get_size()));
+		resize_output = session.sync();
+		kept          = transposition::is_file_backed() && found_stored();
+		same_size     = std::filesystem::file_size(path) == created_size;
+	}
+	transposition::close_file();
+	const bool reopened = transposition::open_file(path.string()) && found_stored();
+	print_check("Hash file survives ucinewgame and Hash",
+	            kept && same_size && reopened && resize_output.find("info string") != std::string::npos);
+
+	// Anything that isn't a table is refused, and left exactly as it was.
+	transposition::close_file();
+	const std::string other = "not a transposition table";
+	{
+		std::ofstream file(path, std::ios::trunc);
+		file << other;
+	}
+	const bool refused = !transposition::open_file(path.string()) && !transposition::is_file_backed()
+	                     && std::filesystem::file_size(path) == other.size();
+	print_check("Hash file leaves other files alone", refused);
+
+	transposition::clear();
+	std::filesystem::remove(path);
+}
+
 void test_search()
 {
+	test_search_limits();
+	test_multipv();
+	test_threads();
+	test_transposition_table();
+	test_analysis_server();
+	test_uci();
+	test_hash_file();
+
 	for (auto &position : test_positions)
 	{
 		std::ostringstream search_start_string;
@@ -0,0 +1,154 @@
+#include "tuner_test.hpp"
+
+#include "board.hpp"
+#include "dataset.hpp"
+#include "hc_evaluation.hpp"
+#include "optimizer.hpp"
+#include "parameters.hpp"
+
+#include <cmath>
+#include <filesystem>
+#include <fstream>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "logger.hpp"
+
+Logger *tuner_logger = new Logger(LOG_LEVEL::DEBUG, "Tuner Test", Logger::HeaderType::SHORT);
+
+void print_tuner_test_result(const std::string &name, bool passed, const std::string &reason = "")
+{
+	tuner_logger->print(passed ? LOG_LEVEL::INFO : LOG_LEVEL::ERROR, name + ": ", TEXT_COLOR::NORMAL, true);
+	if (passed)
+	{
+		tuner_logger->println(LOG_LEVEL::INFO, "Passed", TEXT_COLOR::LIGHT_GREEN, true);
+		return;
+	}
+	tuner_logger->print(LOG_LEVEL::ERROR, "failed", TEXT_COLOR::RED, true);
+	tuner_logger->println(LOG_LEVEL::ERROR, reason.empty() ? "" : ": " + reason);
+}
+
+// Every result syntax `parse_result` understands, and lines it has to turn down.
+void test_parse_result()
+{
+	struct result_case
+	{
+		std::string_view     line;
+		std::optional<float> result;
+		std::string_view     fen;
+	};
+
+	constexpr std::string_view FEN = "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1";
+	constexpr std::string_view EPD = "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq -";
+
+	const std::vector<result_case> cases = {
+		{ "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1 [1.0]", 1.0f, FEN },
+		{ "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1 [0.5]", 0.5f, FEN },
+		{ "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1 [0.25]", 0.25f, FEN },
+		{ "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1 [1-0]", 1.0f, FEN },
+		{ "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1 [0-1]", 0.0f, FEN },
+		{ "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1 [1/2-1/2]", 0.5f, FEN },
+		{ "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - c9 \"1/2-1/2\";", 0.5f, EPD },
+		{ "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - c9 \"1-0\";\r", 1.0f, EPD },
+		{ "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1 0-1", 0.0f, FEN },
+		{ "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1 1/2-1/2 ", 0.5f, FEN },
+		// A bare number is the move counter, not a result.
+		{ "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1", std::nullopt, "" },
+		{ "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1 [1.5]", std::nullopt, "" },
+		{ "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1 [0.5", std::nullopt, "" },
+		{ "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - c9 \"1-0;", std::nullopt, "" },
+	};
+
+	for (const result_case &test_case : cases)
+	{
+		size_t                     fen_length = 0;
+		const std::optional<float> result     = tuner::parse_result(test_case.line, fen_length);
+
+		bool passed = result.has_value() == test_case.result.has_value();
+		if (passed && result.has_value())
+			passed = *result == *test_case.result && test_case.line.substr(0, fen_length) == test_case.fen;
+		if (!passed)
+		{
+			print_tuner_test_result("Result parsing", false, std::string(test_case.line));
+			return;
+		}
+	}
+	print_tuner_test_result("Result parsing", true);
+}
+
+// The tuner's linear evaluation of the current parameters has to agree with the real evaluation,
+// or tuning would fit the parameters to something the engine doesn't compute.
+void test_dataset_evaluation()
+{
+	// Every usable line has its own result, so the positions can be told apart after the parallel load.
+	struct dataset_line
+	{
+		std::string_view line;
+		float            result;
+	};
+
+	const std::vector<dataset_line> lines = {
+		{ "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1 [1.0]", 1.0f },
+		{ "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1 [0.75]", 0.75f },
+		{ "r1bqkb1r/pppp1ppp/2n2n2/4p3/2B1P3/5N2/PPPP1PPP/RNBQK2R w KQkq - c9 \"0.25\";", 0.25f },
+		{ "8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - - 0 1 0-1", 0.0f },
+		{ "4k3/8/8/8/8/8/8/RR2K1BB b - - 0 1 [0.5]", 0.5f },
+	};
+	// A position in check and a line that isn't a position at all, which both have to be skipped.
+	const std::vector<std::string_view> skipped_lines = { "4k3/8/8/8/8/8/8/4R1K1 b - - 0 1 [0.5]",
+		                                                  "not a position [1-0]" };
+
+	const std::filesystem::path path = std::filesystem::temp_directory_path() / "chess_bot_tuner_test.epd";
+	{
+		std::ofstream file(path);
+		for (const dataset_line &line : lines) file << line.line << '\n';
+		for (std::string_view line : skipped_lines) file << line << '\n';
+	}
+
+	const std::optional<tuner::dataset> data = tuner::load_dataset(path.string());
+	std::filesystem::remove(path);
+	if (!data.has_value() || data->positions.size() != lines.size() || data->skipped != skipped_lines.size())
+	{
+		print_tuner_test_result("Dataset loading", false, "wrong number of positions or skipped lines");
+		return;
+	}
+	print_tuner_test_result("Dataset loading", true);
+
+	const tuner::parameters params = tuner::current_parameters();
+	for (const tuner::position &entry : data->positions)
+	{
+		const dataset_line *source = nullptr;
+		for (const dataset_line &line : lines)
+			if (line.result == entry.result) source = &line;
+		if (source == nullptr)
+		{
+			print_tuner_test_result("Tuner evaluation", false, "position with an unexpected result");
+			return;
+		}
+
+		size_t fen_length = 0;
+		(void) tuner::parse_result(source->line, fen_length);
+		Board board = Board::from_fen(source->line.substr(0, fen_length)).value();
+		board.update_bitboards();
+
+		const double             tuned    = tuner::evaluate(*data, entry, params);
+		const evaluation::eval_t expected = evaluation::hce::trace(board).score;
+		if (std::abs(tuned - expected) > 1)
+		{
+			print_tuner_test_result("Tuner evaluation",
+			                        false,
+			                        std::string(source->line) + " evaluates to " + std::to_string(tuned)
+			                            + " instead of " + std::to_string(expected));
+			return;
+		}
+	}
+	print_tuner_test_result("Tuner evaluation", true);
+}
+
+void test_tuner()
+{
+	test_parse_result();
+	test_dataset_evaluation();
+}
\ No newline at end of file
@@ -0,0 +1,160 @@
+#include "dataset.hpp"
+
+#include "board.hpp"
+#include "hc_evaluation.hpp"
+#include "mapped_file.hpp"
+#include "parameters.hpp"
+
+#include <algorithm>
+#include <array>
+#include <charconv>
+#include <cstring>
+#include <tbb/enumerable_thread_specific.h>
+#include <tbb/parallel_for.h>
+
+namespace tuner
+{
+
+static std::optional<float> result_value(std::string_view text)
+{
+	if (text == "1-0") return 1.0f;
+	if (text == "0-1") return 0.0f;
+	if (text == "1/2-1/2") return 0.5f;
+
+	float value = 0;
+	auto [end, error] = std::from_chars(text.data(), text.data() + text.size(), value);
+	if (error != std::errc{} || end != text.data() + text.size() || value < 0 || value > 1) return std::nullopt;
+	return value;
+}
+
+std::optional<float> parse_result(std::string_view line, size_t &fen_length)
+{
+	while (!line.empty() && (line.back() == ' ' || line.back() == ';' || line.back() == '\r')) line.remove_suffix(1);
+
+	std::string_view text;
+	if (size_t open = line.find('['); open != std::string_view::npos)
+	{
+		const size_t close = line.find(']', open);
+		if (close == std::string_view::npos) return std::nullopt;
+		text       = line.substr(open + 1, close - open - 1);
+		fen_length = open;
+	}
+	else if (size_t quote = line.find('"'); quote != std::string_view::npos)
+	{
+		const size_t end = line.find('"', quote + 1);
+		if (end == std::string_view::npos) return std::nullopt;
+		text       = line.substr(quote + 1, end - quote - 1);
+		fen_length = std::min(quote, line.find(" c9"));
+	}
+	else
+	{
+		const size_t space = line.rfind(' ');
+		if (space == std::string_view::npos) return std::nullopt;
+		text       = line.substr(space + 1);
+		fen_length = space;
+		// Without brackets or quotes, a plain number is just the FEN's move counter.
+		if (text != "1-0" && text != "0-1" && text != "1/2-1/2") return std::nullopt;
+	}
+
+	while (fen_length > 0 && line[fen_length - 1] == ' ') fen_length--;
+	return result_value(text);
+}
+
+// Appends the position's coefficients. Returns false if the position can't be used.
+static bool convert(std::string_view fen, float result, dataset &out)
+{
+	// One board per thread, set up again for every position, so loading doesn't allocate a board per line.
+	thread_local Board board;
+	if (!board.set_fen(fen)) return false;
+	board.update_bitboards();
+	// Only quiet positions tell us anything about the static evaluation.
+	if (board.is_in_check()) return false;
+
+	std::array<int, PARAMETER_COUNT> dense{};
+	for (auto &piece : board.piece_board)
+	{
+		if (piece == piece_set_t::null_iterator) continue;
+		const int     sign   = piece->get_color() == WHITE ? 1 : -1;
+		const uint8_t square = piece->get_color() == WHITE ? piece->position() : piece->position() ^ 56;
+
+		if (piece->get_type() != PieceType::KING) dense[piece_value_index(piece->get_type())] += sign;
+		dense[table_index(piece->get_type(), square)] += sign;
+	}
+	for (color_t color : { WHITE, BLACK })
+	{
+		const int                     sign   = color == WHITE ? 1 : -1;
+		const bitboard::piece_boards &pieces = board.bitboards[color].pieces;
+		if (pieces.rooks.count() >= 2) dense[modifier_index(ROOK_PAIR)] += sign;
+		if (pieces.bishops.count() >= 2) dense[modifier_index(BISHOP_PAIR)] += sign;
+		if (pieces.knights.count() >= 2) dense[modifier_index(KNIGHT_PAIR)] += sign;
+		if (pieces.pawns.none()) dense[modifier_index(NO_PAWNS)] += sign;
+	}
+
+	// Everything besides material and modifiers stays fixed, so it only has to be evaluated once.
+	using evaluation::hce::term;
+	const evaluation::hce::eval_trace trace = evaluation::hce::trace(board);
+	evaluation::packed_eval_t         fixed = trace.total();
+	for (term fitted : { term::MATERIAL, term::MODIFIERS })
+		fixed -= trace.terms[(size_t) fitted][WHITE] - trace.terms[(size_t) fitted][BLACK];
+
+	position entry{ (uint32_t) out.coefficients.size(),
+		            0,
+		            (uint16_t) trace.piece_phase,
+		            (int16_t) evaluation::mg_value(fixed),
+		            (int16_t) evaluation::eg_value(fixed),
+		            result };
+	for (size_t index = 0; index < PARAMETER_COUNT; index++)
+	{
+		if (dense[index] == 0) continue;
+		out.coefficients.push_back({ (uint16_t) index, (int8_t) dense[index] });
+		entry.coefficient_count++;
+	}
+	out.positions.push_back(entry);
+	return true;
+}
+
+std::optional<dataset> load_dataset(const std::string &path)
+{
+	const mapped_file file(path);
+	if (!file.is_open()) return std::nullopt;
+
+	// Finding the lines is a quick sequential scan, the conversion is what's worth spreading over threads.
+	std::vector<std::string_view> lines;
+	const char                   *cursor = file.data();
+	const char                   *end    = file.data() + file.size();
+	while (cursor < end)
+	{
+		const char *newline = static_cast<const char *>(std::memchr(cursor, '\n', end - cursor));
+		if (newline == nullptr) newline = end;
+		if (newline != cursor) lines.emplace_back(cursor, newline - cursor);
+		cursor = newline + 1;
+	}
+
+	tbb::enumerable_thread_specific<dataset> partial_sets;
+	tbb::parallel_for(tbb::blocked_range<size_t>(0, lines.size()),
+	                  [&](const tbb::blocked_range<size_t> &range)
+	                  {
+		                  dataset &local = partial_sets.local();
+		                  for (size_t i = range.begin(); i != range.end(); i++)
+		                  {
+			                  size_t                     fen_length = 0;
+			                  const std::optional<float> result     = parse_result(lines[i], fen_length);
+			                  if (!result.has_value() || !convert(lines[i].substr(0, fen_length), *result, local))
+				                  local.skipped++;
+		                  }
+	                  });
+
+	// Each thread numbered its coefficients from zero, so they're shifted as the sets are joined.
+	dataset combined;
+	for (dataset &local : partial_sets)
+	{
+		const uint32_t offset = combined.coefficients.size();
+		for (position &entry : local.positions) entry.first_coefficient += offset;
+		combined.positions.insert(combined.positions.end(), local.positions.begin(), local.positions.end());
+		combined.coefficients.insert(combined.coefficients.end(), local.coefficients.begin(), local.coefficients.end());
+		combined.skipped += local.skipped;
+	}
+	return combined;
+}
+
+} // namespace tuner
\ No newline at end of file
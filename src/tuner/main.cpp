@@ -0,0 +1,89 @@
+#include "dataset.hpp"
+#include "optimizer.hpp"
+#include "parameters.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cxxopts.hpp>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+
+using Clock = std::chrono::steady_clock;
+
+int main(int argc, char **argv)
+{
+	cxxopts::Options options("tuner", "Fits the hand-crafted evaluation's parameters to labelled positions");
+	options.add_options()
+		("d,data", "EPD file with one labelled quiet position per line", cxxopts::value<std::string>())
+		("o,output", "Where to write the tuned header",
+		 cxxopts::value<std::string>()->default_value("hc_parameters.hpp"))
+		("e,epochs", "Number of passes over the data", cxxopts::value<size_t>()->default_value("1000"))
+		("l,learning-rate", "Adam's step size, in centipawns", cxxopts::value<double>()->default_value("1.0"))
+		("k,scaling", "Sigmoid scaling, fitted to the data when 0", cxxopts::value<double>()->default_value("0"))
+		("r,report", "Print the error every this many epochs", cxxopts::value<size_t>()->default_value("10"))
+		("h,help", "Print this help");
+	options.parse_positional({ "data" });
+	const cxxopts::ParseResult args = options.parse(argc, argv);
+
+	if (args.count("help") || !args.count("data"))
+	{
+		std::cout << options.help() << std::endl;
+		return args.count("help") ? 0 : 1;
+	}
+
+	const std::string             path  = args["data"].as<std::string>();
+	const Clock::time_point       start = Clock::now();
+	std::optional<tuner::dataset> data  = tuner::load_dataset(path);
+	if (!data.has_value())
+	{
+		std::cerr << "Couldn't open " << path << std::endl;
+		return 1;
+	}
+	const auto load_time = std::chrono::duration_cast<std::chrono::milliseconds>(Clock::now() - start);
+	std::cout << "Loaded " << data->positions.size() << " positions (" << data->skipped << " skipped) in "
+	          << load_time.count() << "ms, "
+	          << (uint64_t) (data->positions.size() * 1000 / std::max<int64_t>(load_time.count(), 1))
+	          << " positions/s" << std::endl;
+
+	tuner::parameters params  = tuner::current_parameters();
+	double            scaling = args["scaling"].as<double>();
+	if (scaling == 0) scaling = tuner::fit_scaling(*data, params);
+	std::cout << std::fixed << std::setprecision(6) << "Scaling: " << scaling
+	          << ", initial error: " << tuner::mean_error(*data, params, scaling) << std::endl;
+
+	tuner::adam_settings settings;
+	settings.epochs        = args["epochs"].as<size_t>();
+	settings.learning_rate = args["learning-rate"].as<double>();
+	const size_t report    = std::max<size_t>(args["report"].as<size_t>(), 1);
+
+	const Clock::time_point tune_start = Clock::now();
+	tuner::tune(*data,
+	            params,
+	            scaling,
+	            settings,
+	            [&](size_t epoch)
+	            {
+		            if (epoch % report == 0 || epoch == settings.epochs)
+		            {
+			            const auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(Clock::now()
+			                                                                                       - tune_start);
+			            std::cout << "Epoch " << epoch << ": error " << tuner::mean_error(*data, params, scaling)
+			                      << " (" << elapsed.count() / epoch << "ms/epoch)" << std::endl;
+		            }
+		            return true;
+	            });
+
+	const double      error = tuner::mean_error(*data, params, scaling);
+	std::ostringstream comment;
+	comment << "Tuned on " << data->positions.size() << " positions, with a final error of " << std::fixed
+	        << std::setprecision(6) << error << ".";
+	const std::string output = args["output"].as<std::string>();
+	if (!tuner::write_header(output, params, comment.str()))
+	{
+		std::cerr << "Couldn't write " << output << std::endl;
+		return 1;
+	}
+	std::cout << "Wrote " << output << std::endl;
+	return 0;
+}
\ No newline at end of file
@@ -0,0 +1,147 @@
+#include "optimizer.hpp"
+
+#include <cmath>
+#include <tbb/enumerable_thread_specific.h>
+#include <tbb/parallel_for.h>
+#include <tbb/parallel_reduce.h>
+
+namespace tuner
+{
+
+// Positions per task. Big enough that scheduling costs nothing next to the work.
+constexpr size_t GRAIN_SIZE = 4096;
+
+inline double sigmoid(double eval, double scaling) { return 1.0 / (1.0 + std::pow(10.0, -scaling * eval / 400.0)); }
+
+double evaluate(const dataset &data, const position &entry, const parameters &params)
+{
+	double mg = entry.fixed_mg;
+	double eg = entry.fixed_eg;
+
+	const coefficient *coefficients = data.coefficients.data() + entry.first_coefficient;
+	for (size_t i = 0; i < entry.coefficient_count; i++)
+	{
+		mg += coefficients[i].value * params[coefficients[i].index].mg;
+		eg += coefficients[i].value * params[coefficients[i].index].eg;
+	}
+
+	return (mg * (256 - entry.phase) + eg * entry.phase) / 256;
+}
+
+double mean_error(const dataset &data, const parameters &params, double scaling)
+{
+	if (data.positions.empty()) return 0;
+
+	const double total = tbb::parallel_reduce(
+	    tbb::blocked_range<size_t>(0, data.positions.size(), GRAIN_SIZE),
+	    0.0,
+	    [&](const tbb::blocked_range<size_t> &range, double sum)
+	    {
+		    for (size_t i = range.begin(); i != range.end(); i++)
+		    {
+			    const position &entry = data.positions[i];
+			    const double    error = entry.result - sigmoid(evaluate(data, entry, params), scaling);
+			    sum                  += error * error;
+		    }
+		    return sum;
+	    },
+	    std::plus<double>());
+
+	return total / data.positions.size();
+}
+
+double fit_scaling(const dataset &data, const parameters &params)
+{
+	// The error is convex in the scaling, so a ternary search finds the minimum.
+	double low = 0.0, high = 4.0;
+	for (size_t iteration = 0; iteration < 40; iteration++)
+	{
+		const double a = low + (high - low) / 3;
+		const double b = high - (high - low) / 3;
+		if (mean_error(data, params, a) < mean_error(data, params, b)) high = b;
+		else low = a;
+	}
+	return (low + high) / 2;
+}
+
+// Midgame and endgame gradient of every parameter, interleaved.
+typedef std::vector<double> gradient_t;
+
+// Every thread sums into its own buffer, and the buffers are only added up once the pass is done.
+static gradient_t compute_gradient(const dataset &data, const parameters &params, double scaling)
+{
+	tbb::enumerable_thread_specific<gradient_t> buffers(gradient_t(2 * PARAMETER_COUNT, 0.0));
+
+	tbb::parallel_for(tbb::blocked_range<size_t>(0, data.positions.size(), GRAIN_SIZE),
+	                  [&](const tbb::blocked_range<size_t> &range)
+	                  {
+		                  gradient_t &gradient = buffers.local();
+		                  for (size_t i = range.begin(); i != range.end(); i++)
+		                  {
+			                  const position &entry    = data.positions[i];
+			                  const double    expected = sigmoid(evaluate(data, entry, params), scaling);
+			                  // d/d(eval) of (result - sigmoid)^2, leaving out the constant factors.
+			                  const double    slope    = (expected - entry.result) * expected * (1 - expected);
+			                  const double    mg_slope = slope * (256 - entry.phase) / 256;
+			                  const double    eg_slope = slope * entry.phase / 256;
+
+			                  const coefficient *coefficients = data.coefficients.data() + entry.first_coefficient;
+			                  for (size_t c = 0; c < entry.coefficient_count; c++)
+			                  {
+				                  gradient[2 * coefficients[c].index]     += mg_slope * coefficients[c].value;
+				                  gradient[2 * coefficients[c].index + 1] += eg_slope * coefficients[c].value;
+			                  }
+		                  }
+	                  });
+
+	gradient_t total(2 * PARAMETER_COUNT, 0.0);
+	buffers.combine_each(
+	    [&total](const gradient_t &gradient)
+	    {
+		    for (size_t i = 0; i < total.size(); i++) total[i] += gradient[i];
+	    });
+
+	// The factors left out above.
+	const double factor = 2.0 * scaling * std::log(10.0) / 400.0 / data.positions.size();
+	for (double &value : total) value *= factor;
+	return total;
+}
+
+void tune(const dataset &data, parameters &params, double scaling, const adam_settings &settings,
+          const epoch_callback &callback)
+{
+	if (data.positions.empty()) return;
+
+	std::vector<double> first_moment(2 * PARAMETER_COUNT, 0.0);
+	std::vector<double> second_moment(2 * PARAMETER_COUNT, 0.0);
+
+	for (size_t epoch = 1; epoch <= settings.epochs; epoch++)
+	{
+		gradient_t gradient = compute_gradient(data, params, scaling);
+
+		// A tied parameter is a single value, so it follows the sum of both its gradients.
+		for (size_t index = 0; index < PARAMETER_COUNT; index++)
+		{
+			if (!is_tied(index)) continue;
+			gradient[2 * index]     += gradient[2 * index + 1];
+			gradient[2 * index + 1]  = gradient[2 * index];
+		}
+
+		const double first_correction  = 1 - std::pow(settings.beta1, epoch);
+		const double second_correction = 1 - std::pow(settings.beta2, epoch);
+		for (size_t i = 0; i < gradient.size(); i++)
+		{
+			first_moment[i]  = settings.beta1 * first_moment[i] + (1 - settings.beta1) * gradient[i];
+			second_moment[i] = settings.beta2 * second_moment[i] + (1 - settings.beta2) * gradient[i] * gradient[i];
+
+			const double step = settings.learning_rate * (first_moment[i] / first_correction)
+			                    / (std::sqrt(second_moment[i] / second_correction) + settings.epsilon);
+			if (i % 2 == 0) params[i / 2].mg -= step;
+			else params[i / 2].eg -= step;
+		}
+
+		if (!callback(epoch)) break;
+	}
+}
+
+} // namespace tuner
\ No newline at end of file
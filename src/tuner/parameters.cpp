@@ -0,0 +1,141 @@
+#include "parameters.hpp"
+
+#include "hc_parameters.hpp"
+
+#include <algorithm>
+#include <cctype>
+#include <cmath>
+#include <fstream>
+#include <iomanip>
+#include <sstream>
+
+namespace tuner
+{
+
+using namespace evaluation::hce;
+
+typedef std::array<evaluation::eval_t, 64> table_t;
+
+constexpr std::array<PieceType, 6> TABLE_PIECES = { PieceType::PAWN, PieceType::KNIGHT, PieceType::BISHOP,
+	                                                PieceType::ROOK, PieceType::QUEEN,  PieceType::KING };
+constexpr std::array<const char *, 6> TABLE_NAMES = { "PAWNS", "KNIGHTS", "BISHOPS", "ROOKS", "QUEENS", "KING" };
+constexpr std::array<const char *, 5> VALUE_NAMES = { "PAWN", "KNIGHT", "BISHOP", "ROOK", "QUEEN" };
+
+constexpr std::array<const table_t *, 6> MID_TABLES = { &piece_tables::PAWNS_MID,   &piece_tables::KNIGHTS_MID,
+	                                                    &piece_tables::BISHOPS_MID, &piece_tables::ROOKS_MID,
+	                                                    &piece_tables::QUEENS_MID,  &piece_tables::KING_MID };
+constexpr std::array<const table_t *, 6> END_TABLES = { &piece_tables::PAWNS_END,   &piece_tables::KNIGHTS_END,
+	                                                    &piece_tables::BISHOPS_END, &piece_tables::ROOKS_END,
+	                                                    &piece_tables::QUEENS_END,  &piece_tables::KING_END };
+
+parameters current_parameters()
+{
+	parameters params;
+
+	const std::array<evaluation::eval_t, 5> mid_values = { piece_values::PAWN_MID, piece_values::KNIGHT_MID,
+		                                                   piece_values::BISHOP_MID, piece_values::ROOK_MID,
+		                                                   piece_values::QUEEN_MID };
+	const std::array<evaluation::eval_t, 5> end_values = { piece_values::PAWN_END, piece_values::KNIGHT_END,
+		                                                   piece_values::BISHOP_END, piece_values::ROOK_END,
+		                                                   piece_values::QUEEN_END };
+	for (size_t i = 0; i < PIECE_VALUE_COUNT; i++) params[PIECE_VALUE_OFFSET + i] = { (double) mid_values[i],
+		                                                                               (double) end_values[i] };
+
+	for (size_t piece = 0; piece < TABLE_PIECES.size(); piece++)
+		for (uint8_t square = 0; square < 64; square++)
+			params[table_index(TABLE_PIECES[piece], square)] = { (double) (*MID_TABLES[piece])[square],
+				                                                 (double) (*END_TABLES[piece])[square] };
+
+	const std::array<evaluation::eval_t, MODIFIER_COUNT> modifiers = { modifier_values::ROOK_PAIR,
+		                                                               modifier_values::BISHOP_PAIR,
+		                                                               modifier_values::KNIGHT_PAIR,
+		                                                               modifier_values::NO_PAWN_PENALTY };
+	for (size_t i = 0; i < MODIFIER_COUNT; i++) params[MODIFIER_OFFSET + i] = { (double) modifiers[i],
+		                                                                        (double) modifiers[i] };
+
+	return params;
+}
+
+inline long rounded(double value) { return std::lround(value); }
+
+// Writes big constants like 10'000 the same way the hand-written ones are.
+static std::string with_separators(long value)
+{
+	std::string digits = std::to_string(value);
+	for (size_t i = digits.size(); i > 3 && std::isdigit(digits[i - 4]); i -= 3) digits.insert(i - 3, "'");
+	return digits;
+}
+
+// Writes one table in the same layout as the hand-written ones, eight squares per row.
+static void write_table(std::ostream &out, const std::string &name, const parameters &params, PieceType type, bool mid)
+{
+	std::array<long, 64> values;
+	for (uint8_t square = 0; square < 64; square++)
+	{
+		const parameter &param = params[table_index(type, square)];
+		values[square]         = rounded(mid ? param.mg : param.eg);
+	}
+
+	size_t width = 3;
+	for (long value : values) width = std::max(width, std::to_string(value).size());
+
+	out << "constexpr std::array<eval_t, 64> " << name << " = {\n";
+	for (size_t rank = 0; rank < 8; rank++)
+	{
+		out << '\t';
+		for (size_t file = 0; file < 8; file++)
+		{
+			out << std::setw(width) << values[rank * 8 + file];
+			if (rank != 7 || file != 7) out << ',';
+		}
+		out << '\n';
+	}
+	out << "};\n\n";
+}
+
+bool write_header(const std::string &path, const parameters &params, const std::string &comment)
+{
+	std::ostringstream out;
+
+	out << "#pragma once\n\n#include <array>\n\n#include \"eval_types.hpp\"\n\n";
+	out << "// The evaluation parameters the tuner fits. The tuner writes a new version of this file,\n";
+	out << "// so anything that isn't fitted belongs in hc_evaluation.hpp instead.\n";
+	out << "// " << comment << '\n';
+	out << "namespace evaluation::hce\n{\n\n#pragma region Piece_Values\n\nnamespace piece_values\n{\n\n";
+
+	out << "constexpr eval_t KING_MID   = " << with_separators(piece_values::KING_MID) << ";\n";
+	for (size_t i = PIECE_VALUE_COUNT; i-- > 0;)
+		out << "constexpr eval_t " << std::left << std::setw(10) << (std::string(VALUE_NAMES[i]) + "_MID")
+		    << std::right << " = " << rounded(params[PIECE_VALUE_OFFSET + i].mg) << ";\n";
+	out << "\nconstexpr eval_t KING_END   = " << with_separators(piece_values::KING_END) << ";\n";
+	for (size_t i = PIECE_VALUE_COUNT; i-- > 0;)
+		out << "constexpr eval_t " << std::left << std::setw(10) << (std::string(VALUE_NAMES[i]) + "_END")
+		    << std::right << " = " << rounded(params[PIECE_VALUE_OFFSET + i].eg) << ";\n";
+
+	out << "\n} // namespace piece_values\n\n";
+	out << "// Bonuses for having both pieces of a pair, and a penalty for having no pawns left, for each side.\n";
+	out << "namespace modifier_values\n{\n\n";
+	const std::array<const char *, MODIFIER_COUNT> modifier_names = { "ROOK_PAIR", "BISHOP_PAIR", "KNIGHT_PAIR",
+		                                                              "NO_PAWN_PENALTY" };
+	for (size_t i = 0; i < MODIFIER_COUNT; i++)
+		out << "constexpr eval_t " << std::left << std::setw(15) << modifier_names[i] << std::right << " = "
+		    << rounded(params[MODIFIER_OFFSET + i].mg) << ";\n";
+	out << "\n} // namespace modifier_values\n\n#pragma endregion Piece_Values\n\n";
+
+	out << "#pragma region Piece_Tables\n\n";
+	out << "// Due to the layout of the board indices, the tables will be upside-down\n";
+	out << "namespace piece_tables\n{\n// clang-format off\n\n";
+	for (size_t piece = 0; piece < TABLE_PIECES.size(); piece++)
+	{
+		write_table(out, std::string(TABLE_NAMES[piece]) + "_MID", params, TABLE_PIECES[piece], true);
+		write_table(out, std::string(TABLE_NAMES[piece]) + "_END", params, TABLE_PIECES[piece], false);
+	}
+	out << "// clang-format on\n\n} // namespace piece_tables\n\n#pragma endregion Piece_Tables\n\n";
+	out << "} // namespace evaluation::hce";
+
+	std::ofstream file(path);
+	file << out.str();
+	return (bool) file;
+}
+
+} // namespace tuner
\ No newline at end of file